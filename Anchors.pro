@@ -17,10 +17,24 @@ TEMPLATE = app
 SOURCES += main.cpp\
         mainwindow.cpp \
     anchors.cpp \
-    dragwidget.cpp
+    dragwidget.cpp \
+    anchorsheatmap.cpp \
+    anchorsrecorder.cpp \
+    anchorsbenchmark.cpp \
+    anchorstracer.cpp \
+    anchorspositioner.cpp \
+    anchorsgraph.cpp \
+    anchorsscreen.cpp
 
 HEADERS  += mainwindow.h \
     anchors.h \
-    dragwidget.h
+    dragwidget.h \
+    anchorsheatmap.h \
+    anchorsrecorder.h \
+    anchorsbenchmark.h \
+    anchorstracer.h \
+    anchorspositioner.h \
+    anchorsgraph.h \
+    anchorsscreen.h
 
 FORMS    += mainwindow.ui
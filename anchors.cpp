@@ -1,11 +1,409 @@
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QExplicitlySharedDataPointer>
+#include <QBasicTimer>
+#include <QHash>
+#include <QScrollArea>
+#include <QScrollBar>
+#include <QSet>
+#include <QTimer>
+#include <QTimerEvent>
+#include <QWindow>
+#include <QVarLengthArray>
+#include <QVector>
 
 #include "anchors.h"
 
+static QList<AnchorsObserver *> anchorsObservers;
+
+#define NOTIFY_OBSERVERS(call)\
+    if (Q_UNLIKELY(!anchorsObservers.isEmpty())) {\
+        foreach (AnchorsObserver *observer, anchorsObservers)\
+            observer->call;\
+    }\
+
+AnchorsObserver::AnchorsObserver()
+{
+    anchorsObservers.append(this);
+}
+
+AnchorsObserver::~AnchorsObserver()
+{
+    anchorsObservers.removeOne(this);
+}
+
+void AnchorsObserver::eventBegin(const QWidget *w, QEvent::Type type)
+{
+    Q_UNUSED(w)
+    Q_UNUSED(type)
+}
+
+void AnchorsObserver::eventEnd(const QWidget *w, QEvent::Type type)
+{
+    Q_UNUSED(w)
+    Q_UNUSED(type)
+}
+
+void AnchorsObserver::updateBegin(const QWidget *w, UpdateType type)
+{
+    Q_UNUSED(w)
+    Q_UNUSED(type)
+}
+
+void AnchorsObserver::updateEnd(const QWidget *w, UpdateType type, qint64 nsecs)
+{
+    Q_UNUSED(w)
+    Q_UNUSED(type)
+    Q_UNUSED(nsecs)
+}
+
+void AnchorsObserver::geometryAboutToBeCommitted(const QWidget *w, const QRect &geometry)
+{
+    Q_UNUSED(w)
+    Q_UNUSED(geometry)
+}
+
+void AnchorsObserver::geometryCommitted(const QWidget *w, const QRect &geometry)
+{
+    Q_UNUSED(w)
+    Q_UNUSED(geometry)
+}
+
+void AnchorsObserver::repaintAboutToBeRequested(const QWidget *parent, const QRect &rect)
+{
+    Q_UNUSED(parent)
+    Q_UNUSED(rect)
+}
+
+void AnchorsObserver::repaintRequested(const QWidget *parent, const QRect &rect)
+{
+    Q_UNUSED(parent)
+    Q_UNUSED(rect)
+}
+
+void AnchorsObserver::oscillationDetected(const QList<const QWidget *> &widgets)
+{
+    Q_UNUSED(widgets)
+}
+
+bool AnchorsObserver::isActive()
+{
+    return !anchorsObservers.isEmpty();
+}
+
+class AnchorsUpdateScope
+{
+public:
+    AnchorsUpdateScope(const QWidget *w, AnchorsObserver::UpdateType type):
+        widget(w),
+        type(type),
+        active(AnchorsObserver::isActive())
+    {
+        if (Q_UNLIKELY(active)) {
+            NOTIFY_OBSERVERS(updateBegin(widget, type))
+            timer.start();
+        }
+    }
+
+    ~AnchorsUpdateScope()
+    {
+        if (Q_UNLIKELY(active)) {
+            qint64 nsecs = timer.nsecsElapsed();
+            NOTIFY_OBSERVERS(updateEnd(widget, type, nsecs))
+        }
+    }
+
+private:
+    const QWidget *widget;
+    AnchorsObserver::UpdateType type;
+    bool active;
+    QElapsedTimer timer;
+};
+
+// per-window pools for everything the anchors of a widget allocate. Every
+// slot starts with a header naming its pool, NULL for plain heap blocks, so
+// one operator delete serves both
+static void anchorsWindowGone(const QWidget *window);
+
+class AnchorsArena : public QObject
+{
+public:
+    static void *allocate(size_t size, const QWidget *w)
+    {
+        if (!w) {
+            char *block = static_cast<char *>(::operator new(headerSize + size));
+
+            *reinterpret_cast<Pool **>(block) = NULL;
+
+            return block + headerSize;
+        }
+
+        const QWidget *window = w->window();
+        AnchorsArena *arena = arenas.value(window, NULL);
+
+        if (!arena) {
+            arena = new AnchorsArena(window);
+        }
+
+        return arena->take(size);
+    }
+
+    static void release(void *ptr)
+    {
+        if (!ptr) {
+            return;
+        }
+
+        char *slot = static_cast<char *>(ptr) - headerSize;
+        Pool *pool = *reinterpret_cast<Pool **>(slot);
+
+        if (!pool) {
+            ::operator delete(slot);
+            return;
+        }
+
+        AnchorsArena *arena = pool->arena;
+
+        *reinterpret_cast<char **>(ptr) = pool->freeList;
+        pool->freeList = slot;
+
+        // the whole arena goes away in one step once its last object is
+        // gone, a window being torn down keeps it until the end
+        if (--arena->live == 0 && !arena->tearingDown) {
+            delete arena;
+        }
+    }
+
+    // while a window is destroyed as a whole, its anchors only point at
+    // each other and nothing is detached one by one; dialogs parented into
+    // the window anchor to its widgets and go with it
+    static bool isTearingDown(const QWidget *w)
+    {
+        if (Q_LIKELY(teardowns.isEmpty())) {
+            return false;
+        }
+
+        for (; w; w = w->parentWidget()) {
+            if (teardowns.contains(w)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static void beginTeardown(const QWidget *window)
+    {
+        AnchorsArena *arena = arenas.value(window, NULL);
+
+        teardowns << window;
+
+        if (arena) {
+            arena->tearingDown = true;
+        }
+    }
+
+    static void endTeardown(const QWidget *window)
+    {
+        AnchorsArena *arena = arenas.value(window, NULL);
+
+        teardowns.removeOne(window);
+
+        if (arena) {
+            arena->tearingDown = false;
+
+            if (arena->live == 0) {
+                delete arena;
+            }
+        }
+    }
+
+protected:
+    bool eventFilter(QObject *o, QEvent *e) Q_DECL_OVERRIDE
+    {
+        if (o != window) {
+            return false;
+        }
+
+        if (e->type() == QEvent::ParentChange && !window->isWindow()) {
+            rehome(window->window());
+        } else if (e->type() == QEvent::Destroy) {
+            // sent once the children are gone, whatever is still alive was
+            // allocated here but is owned elsewhere and frees itself later
+            teardowns.removeOne(window);
+            arenas.remove(window);
+            anchorsWindowGone(window);
+            window = NULL;
+            tearingDown = false;
+
+            if (live == 0) {
+                deleteLater();
+            }
+        }
+
+        return false;
+    }
+
+private:
+    struct Pool {
+        AnchorsArena *arena;
+        size_t slotSize;
+        QList<char *> blocks;
+        char *freeList = NULL;
+        int used = 0;
+    };
+
+    explicit AnchorsArena(const QWidget *window)
+    {
+        watch(window);
+    }
+
+    ~AnchorsArena()
+    {
+        if (window && arenas.value(window, NULL) == this) {
+            arenas.remove(window);
+        }
+
+        foreach (Pool *pool, pools) {
+            foreach (char *block, pool->blocks) {
+                ::operator delete(block);
+            }
+            delete pool;
+        }
+    }
+
+    void watch(const QWidget *w)
+    {
+        window = w;
+        arenas[window] = this;
+
+        // the window is keyed at allocation time, its own destruction
+        // starts the teardown of everything allocated for it
+        const_cast<QWidget *>(window)->installEventFilter(this);
+        connect(window, &QObject::destroyed, this, &AnchorsArena::windowDestroyed);
+    }
+
+    void windowDestroyed()
+    {
+        teardowns << window;
+        tearingDown = true;
+    }
+
+    // a top-level that gets a parent joins the arena of its new window, so
+    // that the teardown of that window covers what was built before
+    void rehome(const QWidget *newWindow)
+    {
+        AnchorsArena *target = arenas.value(newWindow, NULL);
+
+        arenas.remove(window);
+        anchorsWindowGone(window);
+        const_cast<QWidget *>(window)->removeEventFilter(this);
+        disconnect(window, 0, this, 0);
+
+        if (!target) {
+            watch(newWindow);
+            return;
+        }
+
+        foreach (Pool *pool, pools) {
+            pool->arena = target;
+            target->pools << pool;
+        }
+
+        target->live += live;
+        pools.clear();
+        live = 0;
+        window = NULL;
+        deleteLater();
+    }
+
+    void *take(size_t size)
+    {
+        size_t slotSize = headerSize + (size + alignment - 1) / alignment * alignment;
+        Pool *pool = NULL;
+
+        foreach (Pool *candidate, pools) {
+            if (candidate->slotSize == slotSize) {
+                pool = candidate;
+
+                if (pool->freeList || pool->used < SlotsPerBlock) {
+                    break;
+                }
+            }
+        }
+
+        if (!pool) {
+            pool = new Pool;
+            pool->arena = this;
+            pool->slotSize = slotSize;
+            pools << pool;
+        }
+
+        char *slot = NULL;
+
+        if (pool->freeList) {
+            slot = pool->freeList;
+            pool->freeList = *reinterpret_cast<char **>(slot + headerSize);
+        } else {
+            if (pool->blocks.isEmpty() || pool->used == SlotsPerBlock) {
+                pool->blocks << static_cast<char *>(::operator new(slotSize * SlotsPerBlock));
+                pool->used = 0;
+            }
+
+            slot = pool->blocks.last() + slotSize * pool->used++;
+        }
+
+        *reinterpret_cast<Pool **>(slot) = pool;
+        ++live;
+
+        return slot + headerSize;
+    }
+
+    enum {
+        SlotsPerBlock = 64,
+        alignment = sizeof(void *) > sizeof(qint64) ? sizeof(void *) : sizeof(qint64),
+        headerSize = alignment
+    };
+
+    const QWidget *window = NULL;
+    QList<Pool *> pools;
+    int live = 0;
+    bool tearingDown = false;
+
+    static QHash<const QWidget *, AnchorsArena *> arenas;
+    static QList<const QWidget *> teardowns;
+};
+
+QHash<const QWidget *, AnchorsArena *> AnchorsArena::arenas;
+QList<const QWidget *> AnchorsArena::teardowns;
+
+// the class operators of everything pooled: new (w) places an object in the
+// arena of the window of w, a plain new goes to the heap
+#define ANCHORS_ARENA_OPERATORS\
+    static void *operator new(size_t size)\
+    {\
+        return AnchorsArena::allocate(size, NULL);\
+    }\
+    static void *operator new(size_t size, const QWidget *w)\
+    {\
+        return AnchorsArena::allocate(size, w);\
+    }\
+    static void operator delete(void *ptr)\
+    {\
+        AnchorsArena::release(ptr);\
+    }\
+    static void operator delete(void *ptr, const QWidget *w)\
+    {\
+        Q_UNUSED(w)\
+        AnchorsArena::release(ptr);\
+    }\
+
 class ExtendWidgetPrivate
 {
     explicit ExtendWidgetPrivate(ExtendWidget *qq): q_ptr(qq) {}
 
+    ANCHORS_ARENA_OPERATORS
+
     QSize old_size;
     QPoint old_pos;
     QWidget *target = NULL;
@@ -14,6 +412,7 @@ class ExtendWidgetPrivate
     ExtendWidget *q_ptr;
 
     Q_DECLARE_PUBLIC(ExtendWidget)
+    friend class AnchorsBasePrivate;
 };
 
 ExtendWidget::ExtendWidget(QWidget *w, QObject *parent):
@@ -85,11 +484,42 @@ void ExtendWidget::setEnabled(bool enabled)
     emit enabledChanged(enabled);
 }
 
+class AnchorsLayoutCachePrivate;
+static QHash<const QWidget *, AnchorsLayoutCachePrivate *> anchorsLayoutCaches;
+static bool anchorsCacheResize(AnchorsLayoutCachePrivate *cache, const QResizeEvent *e);
+static void anchorsGeometryChanged(const QWidget *w);
+
+// items laid out by a template have no anchors object of their own, one is
+// only made, with the template's anchors, once an item is overridden
+static void anchorsTemplateRelease(QWidget *w);
+static void anchorsTemplateDrop(const QWidget *w);
+static void anchorsTemplateDropWindow(const QWidget *window);
+static bool anchorsTemplateSizeAnchored(const QWidget *w, Qt::Orientation orientation);
+
 bool ExtendWidget::eventFilter(QObject *o, QEvent *e)
 {
     Q_D(ExtendWidget);
 
     if (o == d->target) {
+        if (Q_UNLIKELY(!anchorsLayoutCaches.isEmpty())
+                && (e->type() == QEvent::Resize || e->type() == QEvent::Move)) {
+            AnchorsLayoutCachePrivate *cache = anchorsLayoutCaches.value(d->target);
+
+            if (!cache) {
+                anchorsGeometryChanged(d->target);
+            } else if (e->type() == QEvent::Resize
+                       && anchorsCacheResize(cache, static_cast<QResizeEvent *>(e))) {
+                // the cached layout is already applied, nothing to cascade
+                d->old_size = static_cast<QResizeEvent *>(e)->size();
+                return false;
+            }
+        }
+
+        if (Q_UNLIKELY(AnchorsObserver::isActive())
+                && (e->type() == QEvent::Resize || e->type() == QEvent::Move)) {
+            NOTIFY_OBSERVERS(eventBegin(d->target, e->type()))
+        }
+
         if (e->type() == QEvent::Resize) {
             QResizeEvent *event = static_cast<QResizeEvent *>(e);
             if (event) {
@@ -130,6 +560,11 @@ bool ExtendWidget::eventFilter(QObject *o, QEvent *e)
                 d->old_pos = pos;
             }
         }
+
+        if (Q_UNLIKELY(AnchorsObserver::isActive())
+                && (e->type() == QEvent::Resize || e->type() == QEvent::Move)) {
+            NOTIFY_OBSERVERS(eventEnd(d->target, e->type()))
+        }
     }
 
     return false;
@@ -139,22 +574,106 @@ ExtendWidget::ExtendWidget(ExtendWidgetPrivate *dd, QWidget *w, QObject *parent)
     QObject(parent),
     d_ptr(dd)
 {
+    d_ptr->q_ptr = this;
+
     if (w) {
+        d_ptr->target = w;
         w->installEventFilter(this);
     }
 }
 
+struct AnchorsMargins : public QSharedData {
+    int margins = 0;
+    int topMargin = 0;
+    int bottomMargin = 0;
+    int leftMargin = 0;
+    int rightMargin = 0;
+    int horizontalCenterOffset = 0;
+    int verticalCenterOffset = 0;
+    bool alignWhenCentered = false;
+    qreal aspectRatio = 0;
+};
+
+class AnchorsTransactionPrivate;
+class AnchorsSchedulerPrivate;
+class AnchorsIncrementalLayoutPrivate;
+class AnchorsViewportCullingPrivate;
 class AnchorsBasePrivate
 {
-    AnchorsBasePrivate(AnchorsBase *qq): q_ptr(qq) {}
+    AnchorsBasePrivate(AnchorsBase *qq, QWidget *w):
+        q_ptr(qq),
+        targetObject(new (w) ExtendWidgetPrivate(NULL), w),
+        fillObject(new (w) ExtendWidgetPrivate(NULL), NULL),
+        centerInObject(new (w) ExtendWidgetPrivate(NULL), NULL)
+    {}
     ~AnchorsBasePrivate()
     {
-        delete top;
-        delete bottom;
-        delete left;
-        delete right;
-        delete horizontalCenter;
-        delete verticalCenter;
+        takeDirty();
+
+        if (repaintPending) {
+            if (teardown) {
+                repaintBlocked = false;
+            }
+            dropRepaint();
+        }
+
+        if (parked) {
+            unpark();
+        }
+        if (culled) {
+            dropCulled();
+        }
+        if (!variableNames.isEmpty()) {
+            dropVariables();
+        }
+
+        // the peers in the window go away as well, only bindings may still
+        // read from widgets that outlive it
+        if (teardown) {
+            foreach (const Binding &binding, bindings) {
+                foreach (const QPointer<AnchorsBase> &base, binding.dependencies) {
+                    if (base && !AnchorsArena::isTearingDown(base->target())) {
+                        base->d_func()->dropReader(q_ptr);
+                    }
+                }
+            }
+            return;
+        }
+
+        // dependents keep their geometry but no longer point at this widget
+        foreach (AnchorInfo *info, incoming) {
+            info->targetInfo = NULL;
+        }
+        for (int i = 0; i < 6; ++i) {
+            if (infos[i].targetInfo) {
+                infos[i].targetInfo->base->d_func()->release(&infos[i]);
+                infos[i].targetInfo = NULL;
+            }
+        }
+        foreach (const Binding &binding, bindings) {
+            foreach (const QPointer<AnchorsBase> &base, binding.dependencies) {
+                if (base) {
+                    base->d_func()->dropReader(q_ptr);
+                }
+            }
+        }
+    }
+
+    ANCHORS_ARENA_OPERATORS
+
+    // anchors never span windows, so a change only makes what was derived
+    // from the graph of its own window stale
+    static void touchGraph(const QWidget *w)
+    {
+        if (w) {
+            ++graphVersions[w->window()];
+        }
+    }
+
+    // zero is left for "no version" in the layout caches
+    static quint32 graphVersion(const QWidget *w)
+    {
+        return w ? graphVersions.value(w->window(), 0) + 1 : 0;
     }
 
     static void setWidgetAnchorsBase(const QWidget *w, AnchorsBase *b)
@@ -171,6 +690,18 @@ class AnchorsBasePrivate
     {
         return widgetMap.value(w, NULL);
     }
+    // the object behind anchors the library sets up on its own, nobody
+    // outside holds it, so it is reclaimed once it is idle again
+    static AnchorsBase *implicitAnchorsBase(QWidget *w)
+    {
+        AnchorsBase *base = widgetMap.value(w, NULL);
+
+        if (!base && w) {
+            base = new (w) AnchorsBase(w, false);
+        }
+
+        return base;
+    }
     static void removeWidgetAnchorsBase(const QWidget *w, const AnchorsBase *b)
     {
         if (w && b && widgetMap.value(w, NULL) == b) {
@@ -224,8 +755,10 @@ class AnchorsBasePrivate
 
         Q_Q(const AnchorsBase);
 
-        bool tmp1 = ((int)q->isBinding(top) + (int)q->isBinding(verticalCenter) + (int)q->isBinding(bottom)) < 2;
-        bool tmp2 = ((int)q->isBinding(left) + (int)q->isBinding(horizontalCenter) + (int)q->isBinding(right)) < 2;
+        bool tmp1 = ((int)q->isBinding(top) + (int)q->isBinding(verticalCenter) + (int)q->isBinding(bottom)
+                     + bindingCount(Qt::Vertical)) < 2;
+        bool tmp2 = ((int)q->isBinding(left) + (int)q->isBinding(horizontalCenter) + (int)q->isBinding(right)
+                     + bindingCount(Qt::Horizontal)) < 2;
 
         switch (info->type) {
         case Qt::AnchorTop://Deliberate
@@ -241,28 +774,31 @@ class AnchorsBasePrivate
         }
     }
 
-    qreal getValueByInfo(const AnchorInfo *info)
+    static qreal getValueByRect(const QRect &rect, Qt::AnchorPoint point)
     {
-        ARect rect = info->base->target()->geometry();
-
-        switch (info->type) {
+        switch (point) {
         case Qt::AnchorTop:
             return rect.top();
         case Qt::AnchorBottom:
             return rect.bottom() + 1;
         case Qt::AnchorHorizontalCenter:
-            return rect.horizontalCenter();
+            return rect.left() + rect.width() / 2.0;
         case Qt::AnchorLeft:
             return rect.left();
         case Qt::AnchorRight:
             return rect.right() + 1;
         case Qt::AnchorVerticalCenter:
-            return rect.verticalCenter();
+            return rect.top() + rect.height() / 2.0;
         default:
             return 0;
         }
     }
 
+    qreal getValueByInfo(const AnchorInfo *info)
+    {
+        return getValueByRect(info->base->target()->geometry(), info->type);
+    }
+
     void setValueByInfo(qreal value, const AnchorInfo *info)
     {
         if (!info) {
@@ -299,34 +835,36 @@ class AnchorsBasePrivate
             return getValueByInfo(info);
         }
 
-        qreal value = getValueByInfo(info->targetInfo);
-        bool isParent = info->base->target()->parentWidget() == info->targetInfo->base->target();
-        int topValue = isParent ? -info->targetInfo->base->target()->geometry().top() : 0;
-        int leftValue = isParent ? -info->targetInfo->base->target()->geometry().left() : 0;
+        const QWidget *target_widget = info->targetInfo->base->target();
+        const QRect &target_rect = target_widget->geometry();
+        qreal value = getValueByRect(target_rect, info->targetInfo->type);
+        bool isParent = info->base->target()->parentWidget() == target_widget;
+        int topValue = isParent ? -target_rect.top() : 0;
+        int leftValue = isParent ? -target_rect.left() : 0;
 
         switch (info->type) {
         case Qt::AnchorTop: {
-            int offset = topMargin == 0 ? margins : topMargin;
+            int offset = settings->topMargin == 0 ? settings->margins : settings->topMargin;
             return value + offset + topValue;
         }
         case Qt::AnchorBottom: {
-            int offset = bottomMargin == 0 ? margins : bottomMargin;
+            int offset = settings->bottomMargin == 0 ? settings->margins : settings->bottomMargin;
             return value - offset + topValue - 1;
         }
         case Qt::AnchorHorizontalCenter: {
-            int offset = horizontalCenterOffset;
+            int offset = settings->horizontalCenterOffset;
             return value + offset + leftValue;
         }
         case Qt::AnchorLeft: {
-            int offset = leftMargin == 0 ? margins : leftMargin;
+            int offset = settings->leftMargin == 0 ? settings->margins : settings->leftMargin;
             return value + offset + leftValue;
         }
         case Qt::AnchorRight: {
-            int offset = rightMargin == 0 ? margins : rightMargin;
+            int offset = settings->rightMargin == 0 ? settings->margins : settings->rightMargin;
             return value - offset + leftValue - 1;
         }
         case Qt::AnchorVerticalCenter: {
-            int offset = verticalCenterOffset;
+            int offset = settings->verticalCenterOffset;
             return value + offset + topValue;
         }
         default:
@@ -347,822 +885,5470 @@ class AnchorsBasePrivate
         return w->geometry();
     }
 
-    int horizontalAnchorCount() const
+    // keeps the size inside the widget's minimum and maximum size: the fixed
+    // edge stays in place and the opposite one yields, a fixed center stays
+    // centered; fixed and crossFixed each name the point of one axis, an axis
+    // neither of them belongs to keeps its start edge
+    static void boundSize(QRect &rect, const QWidget *w, Qt::AnchorPoint fixed, Qt::AnchorPoint crossFixed)
     {
-        Q_Q(const AnchorsBase);
-
-        int count = 0;
-        if(q->isBinding(left))
-            ++count;
-        if(q->isBinding(horizontalCenter))
-            ++count;
-        if(q->isBinding(right))
-            ++count;
+        int width = qBound(w->minimumWidth(), rect.width(), w->maximumWidth());
+        int height = qBound(w->minimumHeight(), rect.height(), w->maximumHeight());
+
+        if (width != rect.width()) {
+            if (fixed == Qt::AnchorRight || crossFixed == Qt::AnchorRight) {
+                rect.setLeft(rect.right() - width + 1);
+            } else if (fixed == Qt::AnchorHorizontalCenter || crossFixed == Qt::AnchorHorizontalCenter) {
+                rect.moveLeft(rect.left() + (rect.width() - width) / 2);
+                rect.setWidth(width);
+            } else {
+                rect.setWidth(width);
+            }
+        }
 
-        return count;
+        if (height != rect.height()) {
+            if (fixed == Qt::AnchorBottom || crossFixed == Qt::AnchorBottom) {
+                rect.setTop(rect.bottom() - height + 1);
+            } else if (fixed == Qt::AnchorVerticalCenter || crossFixed == Qt::AnchorVerticalCenter) {
+                rect.moveTop(rect.top() + (rect.height() - height) / 2);
+                rect.setHeight(height);
+            } else {
+                rect.setHeight(height);
+            }
+        }
     }
 
-    int verticalAnchorCount() const
+    // crossFixed is the point that stays put on the other axis, when a
+    // single update places both of them
+    void commitGeometry(QRect rect, Qt::AnchorPoint fixed, Qt::AnchorPoint crossFixed = Qt::AnchorTop)
     {
-        Q_Q(const AnchorsBase);
+        QWidget *w = extendWidget->target();
 
-        int count = 0;
-        if(q->isBinding(top))
-            ++count;
-        if(q->isBinding(verticalCenter))
-            ++count;
-        if(q->isBinding(bottom))
-            ++count;
+        boundSize(rect, w, fixed, crossFixed);
 
-        return count;
-    }
+        if (rect == w->geometry()) {
+            return;
+        }
 
-    AnchorsBase *q_ptr;
+        if (repaintCoalescing && passDepth > 0 && !w->isWindow() && w->isVisible()) {
+            suppressRepaint(w);
+        }
+
+        NOTIFY_OBSERVERS(geometryAboutToBeCommitted(w, rect))
+        w->setGeometry(rect);
+        NOTIFY_OBSERVERS(geometryCommitted(w, rect))
+    }
+
+    static int roundValue(qreal value)
+    {
+        switch (centerRounding) {
+        case AnchorsBase::RoundUp:
+            return qCeil(value);
+        case AnchorsBase::RoundNearest:
+            return qFloor(value + 0.5);
+        default:
+            return qFloor(value);
+        }
+    }
+
+    // first pixel of a span of the given size centered on center; aligned
+    // spans snap the center to a whole pixel first, so that targets with
+    // odd and even sizes place the span the same way
+    int centeredStart(qreal center, int size) const
+    {
+        if (settings->alignWhenCentered) {
+            return roundValue(center) - size / 2;
+        }
+
+        return roundValue(center - size / 2.0);
+    }
+
+    struct EngineSelection {
+        AnchorsEngine *engine = NULL;
+        AnchorsEngine *reference = NULL;
+        AnchorsEngineComparison comparison;
+        QMetaObject::Connection destroyed;
+    };
+
+    AnchorsEngine::Axis axisOf(const QRect &rect, Qt::Orientation orientation) const
+    {
+        AnchorsEngine::Axis axis;
+        bool vertical = orientation == Qt::Vertical;
+
+        axis.orientation = orientation;
+        axis.start = vertical ? rect.top() : rect.left();
+        axis.size = vertical ? rect.height() : rect.width();
+        axis.alignWhenCentered = settings->alignWhenCentered;
+
+        for (int i = 0; i < 3; ++i) {
+            axis.bound[i] = false;
+            axis.values[i] = 0;
+        }
+
+        return axis;
+    }
+
+    static void setAxis(QRect &rect, const AnchorsEngine::Axis &axis)
+    {
+        if (axis.orientation == Qt::Vertical) {
+            rect.moveTop(axis.start);
+            rect.setHeight(axis.size);
+        } else {
+            rect.moveLeft(axis.start);
+            rect.setWidth(axis.size);
+        }
+    }
+
+    // the selections are keyed by the bare window pointer, so an entry
+    // must not outlive its window; one connection per entry removes it
+    static void selectEngine(const QWidget *window, EngineSelection selection)
+    {
+        QHash<const QWidget *, EngineSelection>::iterator it = engines.find(window);
+
+        if (it != engines.end()) {
+            selection.destroyed = it->destroyed;
+            *it = selection;
+            return;
+        }
+
+        selection.destroyed = QObject::connect(window, &QObject::destroyed, [window]() {
+            engines.remove(window);
+        });
+        engines.insert(window, selection);
+    }
+
+    static void dropEngine(const QWidget *window)
+    {
+        QHash<const QWidget *, EngineSelection>::iterator it = engines.find(window);
+
+        if (it != engines.end()) {
+            QObject::disconnect(it->destroyed);
+            engines.erase(it);
+        }
+    }
+
+    int resolveAxis(AnchorsEngine::Axis &axis) const
+    {
+        if (Q_LIKELY(engines.isEmpty())) {
+            return AnchorsEngine::cascade()->resolve(axis);
+        }
+
+        QHash<const QWidget *, EngineSelection>::iterator it = engines.find(extendWidget->target()->window());
+
+        if (it == engines.end()) {
+            return AnchorsEngine::cascade()->resolve(axis);
+        }
+        if (!it->reference) {
+            return it->engine->resolve(axis);
+        }
+
+        return compareAxis(*it, axis);
+    }
+
+    // both engines see the same input, the first one's result is committed
+    int compareAxis(EngineSelection &selection, AnchorsEngine::Axis &axis) const
+    {
+        AnchorsEngineComparison &comparison = selection.comparison;
+        AnchorsEngine::Axis other = axis;
+        AnchorsEngine::Axis *axes[2] = { &axis, &other };
+        const AnchorsEngine *list[2] = { selection.engine, selection.reference };
+        int indexes[2];
+        qint64 nsecs[2];
+        QElapsedTimer clock;
+
+        // the order alternates, so neither engine always runs on a warm cache
+        for (int n = 0; n < 2; ++n) {
+            int i = comparison.resolves & 1 ? 1 - n : n;
+
+            clock.start();
+            indexes[i] = list[i]->resolve(*axes[i]);
+            nsecs[i] = clock.nsecsElapsed();
+        }
+
+        ++comparison.resolves;
+        comparison.firstNsecs += nsecs[0];
+        comparison.secondNsecs += nsecs[1];
+
+        if (indexes[0] != indexes[1] || axis.start != other.start || axis.size != other.size) {
+            if (comparison.mismatches++ == 0) {
+                qWarning() << "anchors: engines" << comparison.first << "and" << comparison.second
+                           << "disagree on" << extendWidget->target() << ":" << axis.start << axis.size
+                           << "vs" << other.start << other.size;
+            }
+        }
+
+        return indexes[0];
+    }
+
+    // places one axis of rect on its anchors and bindings, false when
+    // neither binds it
+    bool placeAxis(QRect &rect, Qt::Orientation orientation, Qt::AnchorPoint &fixed)
+    {
+        Q_Q(AnchorsBase);
+
+        bool vertical = orientation == Qt::Vertical;
+        const AnchorInfo *points[] = {
+            vertical ? top : left,
+            vertical ? verticalCenter : horizontalCenter,
+            vertical ? bottom : right
+        };
+        AnchorsEngine::Axis axis = axisOf(rect, orientation);
+
+        for (int i = 0; i < 3; ++i) {
+            axis.bound[i] = q->isBinding(points[i]);
+            if (axis.bound[i]) {
+                axis.values[i] = getTargetValueByInfo(points[i]);
+            }
+        }
+
+        int index = resolveAxis(axis);
+
+        if (index < 0 && !bindingCount(orientation)) {
+            return false;
+        }
+
+        fixed = points[qMax(0, index)]->type;
+
+        setAxis(rect, axis);
+        applyBindings(rect, fixed, orientation);
+
+        return true;
+    }
+
+    void updateAxis(Qt::Orientation orientation)
+    {
+        QRect rect = extendWidget->target()->geometry();
+        Qt::AnchorPoint fixed = orientation == Qt::Vertical ? Qt::AnchorTop : Qt::AnchorLeft;
+        Qt::Orientations derived = aspectOrientation();
+
+        if (derived == orientation) {
+            applyAspectRatio(rect, orientation);
+        }
+
+        bool placed = placeAxis(rect, orientation, fixed) || derived;
+        Qt::AnchorPoint crossFixed = orientation == Qt::Vertical ? Qt::AnchorLeft : Qt::AnchorTop;
+
+        // the axis sized by the aspect ratio goes into the same commit,
+        // rather than into a second pass started by this one's resize; its
+        // own anchors decide which of its points stays put
+        if (derived && derived != orientation) {
+            Qt::Orientation other = Qt::Orientation(int(derived));
+
+            applyAspectRatio(rect, other);
+            placeAxis(rect, other, crossFixed);
+        }
+
+        if (placed) {
+            commitGeometry(rect, fixed, crossFixed);
+        }
+    }
+
+    bool sizeDetermined(Qt::Orientation orientation) const
+    {
+        bool vertical = orientation == Qt::Vertical;
+
+        if (centerIn->target()) {
+            return false;
+        }
+
+        return (vertical ? verticalAnchorCount() : horizontalAnchorCount()) + bindingCount(orientation) >= 2
+                || indexOfBinding(vertical ? AnchorsBase::HeightProperty : AnchorsBase::WidthProperty) >= 0;
+    }
+
+    // the axis an aspect ratio sizes: the one its anchors and bindings leave
+    // open, the vertical one when both are
+    Qt::Orientations aspectOrientation() const
+    {
+        if (settings->aspectRatio <= 0 || fill->target()) {
+            return Qt::Orientations();
+        }
+
+        if (!sizeDetermined(Qt::Vertical)) {
+            return Qt::Vertical;
+        }
+        if (!sizeDetermined(Qt::Horizontal)) {
+            return Qt::Horizontal;
+        }
+
+        return Qt::Orientations();
+    }
+
+    void applyAspectRatio(QRect &rect, Qt::Orientation orientation) const
+    {
+        if (orientation == Qt::Vertical) {
+            rect.setHeight(qMax(0, roundValue(rect.width() / settings->aspectRatio)));
+        } else {
+            rect.setWidth(qMax(0, roundValue(rect.height() * settings->aspectRatio)));
+        }
+    }
+
+    void moveCentered(QRect &rect, Qt::AnchorPoint point, qreal center) const
+    {
+        if (point == Qt::AnchorHorizontalCenter) {
+            rect.moveLeft(centeredStart(center, rect.width()));
+        } else {
+            rect.moveTop(centeredStart(center, rect.height()));
+        }
+    }
+
+    static void beginPass()
+    {
+        if (passDepth++ == 0) {
+            ++currentPass;
+        }
+    }
+
+    static void endPass()
+    {
+        if (--passDepth == 0 && !suppressed.isEmpty()) {
+            flushRepaints();
+        }
+    }
+
+    enum {
+        MaxRepaintRects = 8
+    };
+
+    // a handful of rects per parent, overlapping areas are merged
+    struct Repaint {
+        QWidget *parent;
+        QRect rects[MaxRepaintRects];
+        int count;
+    };
+
+    // Qt invalidates the old and the new area of every moved widget on its
+    // own; with updates blocked on the widget the pass keeps where it was
+    // before its first move, the area it ends up in is read at the end.
+    // The storage only grows, so a pass in steady state doesn't allocate
+    void suppressRepaint(QWidget *w)
+    {
+        if (repaintPending) {
+            return;
+        }
+
+        repaintPending = true;
+        repaintFrom = w->geometry();
+        repaintBlocked = !w->testAttribute(Qt::WA_UpdatesDisabled);
+        if (repaintBlocked) {
+            w->setAttribute(Qt::WA_UpdatesDisabled);
+        }
+        suppressed.append(this);
+    }
+
+    void dropRepaint()
+    {
+        QWidget *w = extendWidget->target();
+
+        for (int i = 0; i < suppressed.size(); ++i) {
+            if (suppressed.at(i) == this) {
+                suppressed.remove(i);
+                break;
+            }
+        }
+
+        repaintPending = false;
+        if (repaintBlocked && w) {
+            w->setAttribute(Qt::WA_UpdatesDisabled, false);
+        }
+    }
+
+    static void addRepaint(Repaint &repaint, const QRect &rect)
+    {
+        QRect grown = rect.adjusted(-1, -1, 1, 1);
+        int best = 0;
+        int bestArea = -1;
+
+        for (int i = 0; i < repaint.count; ++i) {
+            if (repaint.rects[i].intersects(grown)) {
+                repaint.rects[i] |= rect;
+                return;
+            }
+        }
+
+        if (repaint.count < MaxRepaintRects) {
+            repaint.rects[repaint.count++] = rect;
+            return;
+        }
+
+        // out of room, the rect joins the one it enlarges least
+        for (int i = 0; i < repaint.count; ++i) {
+            QRect united = repaint.rects[i] | rect;
+            int area = united.width() * united.height();
+
+            if (bestArea < 0 || area < bestArea) {
+                bestArea = area;
+                best = i;
+            }
+        }
+        repaint.rects[best] |= rect;
+    }
+
+    // the attribute is cleared directly, setUpdatesEnabled() would repaint
+    // the whole widget on top of the merged area
+    static void flushRepaints()
+    {
+        int last = -1;
+
+        repaints.resize(0);
+        for (int i = 0; i < suppressed.size(); ++i) {
+            AnchorsBasePrivate *d = suppressed.at(i);
+            QWidget *w = d->extendWidget->target();
+
+            d->repaintPending = false;
+            if (!w) {
+                continue;
+            }
+
+            QWidget *parent = w->parentWidget();
+
+            if (d->repaintBlocked) {
+                w->setAttribute(Qt::WA_UpdatesDisabled, false);
+            }
+
+            // moved back to where it started, nothing to repaint
+            if (!parent || w->geometry() == d->repaintFrom) {
+                continue;
+            }
+
+            // siblings tend to follow each other in the list
+            if (last < 0 || repaints.at(last).parent != parent) {
+                last = -1;
+                for (int j = 0; j < repaints.size(); ++j) {
+                    if (repaints.at(j).parent == parent) {
+                        last = j;
+                        break;
+                    }
+                }
+            }
+            if (last < 0) {
+                last = repaints.size();
+                repaints.resize(last + 1);
+                repaints[last].parent = parent;
+                repaints[last].count = 0;
+            }
+
+            addRepaint(repaints[last], d->repaintFrom);
+            addRepaint(repaints[last], w->geometry());
+        }
+        suppressed.resize(0);
+
+        for (int i = 0; i < repaints.size(); ++i) {
+            const Repaint &repaint = repaints.at(i);
+
+            for (int j = 0; j < repaint.count; ++j) {
+                NOTIFY_OBSERVERS(repaintAboutToBeRequested(repaint.parent, repaint.rects[j]))
+                repaint.parent->update(repaint.rects[j]);
+                NOTIFY_OBSERVERS(repaintRequested(repaint.parent, repaint.rects[j]))
+            }
+        }
+        repaints.resize(0);
+    }
+
+    // counts the updates of this widget in the current pass, past the limit
+    // the widget is feeding back into itself and its updates are dropped
+    bool enterPass()
+    {
+        if (pass != currentPass) {
+            pass = currentPass;
+            iterations = 0;
+        }
+
+        if (++iterations <= iterationLimit) {
+            return true;
+        }
+
+        if (reportedPass != currentPass) {
+            reportedPass = currentPass;
+            reportOscillation();
+        }
+
+        return false;
+    }
+
+    void reportOscillation()
+    {
+        QList<const QWidget *> list;
+
+        list << extendWidget->target();
+        foreach (AnchorsBase *base, widgetMap) {
+            const AnchorsBasePrivate *d = base->d_func();
+
+            if (d != this && d->pass == currentPass && d->iterations * 2 > iterationLimit) {
+                list << base->target();
+            }
+        }
+
+        setError(AnchorsBase::Oscillation, "oscillation: relayout did not settle within the iteration limit.");
+
+        QStringList names;
+        foreach (const QWidget *w, list) {
+            names << (w->objectName().isEmpty() ? QString(w->metaObject()->className()) : w->objectName());
+        }
+        qWarning() << "Anchors: oscillation detected, involved widgets:" << names.join(", ");
+
+        NOTIFY_OBSERVERS(oscillationDetected(list))
+    }
+
+    class PassScope
+    {
+    public:
+        explicit PassScope(AnchorsBasePrivate *d)
+        {
+            beginPass();
+            accepted = d->enterPass();
+        }
+
+        ~PassScope()
+        {
+            endPass();
+        }
+
+        bool accepted;
+    };
+
+    int horizontalAnchorCount() const
+    {
+        Q_Q(const AnchorsBase);
+
+        int count = 0;
+        if(q->isBinding(left))
+            ++count;
+        if(q->isBinding(horizontalCenter))
+            ++count;
+        if(q->isBinding(right))
+            ++count;
+
+        return count;
+    }
+
+    int verticalAnchorCount() const
+    {
+        Q_Q(const AnchorsBase);
+
+        int count = 0;
+        if(q->isBinding(top))
+            ++count;
+        if(q->isBinding(verticalCenter))
+            ++count;
+        if(q->isBinding(bottom))
+            ++count;
+
+        return count;
+    }
+
+    enum {
+        MaxDependencies = 7
+    };
+
+    enum UpdateFlag {
+        VerticalFlag = 0x01,
+        HorizontalFlag = 0x02,
+        FillFlag = 0x04,
+        CenterInFlag = 0x08,
+        BindingFlag = 0x10
+    };
+
+    int boundFlags() const
+    {
+        Q_Q(const AnchorsBase);
+
+        if (fill->target()) {
+            return FillFlag;
+        }
+
+        if (centerIn->target()) {
+            return CenterInFlag;
+        }
+
+        int flags = 0;
+        if (q->isBinding(top) || q->isBinding(verticalCenter) || q->isBinding(bottom)) {
+            flags |= VerticalFlag;
+        }
+        if (q->isBinding(left) || q->isBinding(horizontalCenter) || q->isBinding(right)) {
+            flags |= HorizontalFlag;
+        }
+        if (!bindings.isEmpty()) {
+            flags |= BindingFlag;
+            if (bindingCount(Qt::Vertical)) {
+                flags |= VerticalFlag;
+            }
+            if (bindingCount(Qt::Horizontal)) {
+                flags |= HorizontalFlag;
+            }
+        }
+
+        return flags;
+    }
+
+    int dependencies(AnchorsBasePrivate **list) const
+    {
+        const AnchorInfo *infos[] = {top, bottom, left, right, horizontalCenter, verticalCenter};
+        int count = 0;
+
+        for (int i = 0; i < 6; ++i) {
+            if (infos[i]->targetInfo) {
+                list[count++] = infos[i]->targetInfo->base->d_func();
+            }
+        }
+
+        AnchorsBase *base = getWidgetAnchorsBase(fill->target() ? fill->target() : centerIn->target());
+        if (base) {
+            list[count++] = base->d_func();
+        }
+
+        return count;
+    }
+
+    int dependencies(Qt::Orientation orientation, AnchorsBasePrivate **list) const
+    {
+        const AnchorInfo *infos[] = {top, bottom, verticalCenter, left, right, horizontalCenter};
+        int first = orientation == Qt::Vertical ? 0 : 3;
+        int count = 0;
+
+        for (int i = first; i < first + 3; ++i) {
+            if (infos[i]->targetInfo) {
+                list[count++] = infos[i]->targetInfo->base->d_func();
+            }
+        }
+
+        AnchorsBase *base = getWidgetAnchorsBase(fill->target() ? fill->target() : centerIn->target());
+        if (base) {
+            list[count++] = base->d_func();
+        }
+
+        return count;
+    }
+
+    // matched by widget, so a fill or centerIn target that never got
+    // anchors of its own counts too, as do the widgets bindings read
+    bool anchoredTo(const QWidget *w) const
+    {
+        const AnchorInfo *infos[] = {top, bottom, left, right, horizontalCenter, verticalCenter};
+
+        for (int i = 0; i < 6; ++i) {
+            if (infos[i]->targetInfo && infos[i]->targetInfo->base->target() == w) {
+                return true;
+            }
+        }
+
+        if (fill->target() == w || centerIn->target() == w) {
+            return true;
+        }
+
+        foreach (const Binding &binding, bindings) {
+            foreach (const QPointer<AnchorsBase> &base, binding.dependencies) {
+                if (base && base->target() == w) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    void markDirty(int flags)
+    {
+        if (!flags) {
+            return;
+        }
+
+        if (!dirty) {
+            dirtyPrev = dirtyLast;
+            dirtyNext = NULL;
+            if (dirtyLast) {
+                dirtyLast->dirtyNext = this;
+            } else {
+                dirtyFirst = this;
+            }
+            dirtyLast = this;
+        }
+
+        dirty |= flags;
+    }
+
+    int takeDirty()
+    {
+        int flags = dirty;
+
+        if (!flags) {
+            return 0;
+        }
+
+        if (dirtyPrev) {
+            dirtyPrev->dirtyNext = dirtyNext;
+        } else {
+            dirtyFirst = dirtyNext;
+        }
+        if (dirtyNext) {
+            dirtyNext->dirtyPrev = dirtyPrev;
+        } else {
+            dirtyLast = dirtyPrev;
+        }
+
+        dirtyPrev = NULL;
+        dirtyNext = NULL;
+        dirty = 0;
+
+        return flags;
+    }
+
+    struct Binding {
+        AnchorsBase::BindingProperty property;
+        std::function<qreal()> expression;
+        qreal value = 0;
+        bool stale = true;
+        QList<QPointer<AnchorsBase> > dependencies;
+    };
+
+    static Qt::Orientation bindingOrientation(AnchorsBase::BindingProperty property)
+    {
+        switch (property) {
+        case AnchorsBase::LeftProperty://Deliberate
+        case AnchorsBase::HorizontalCenterProperty://Deliberate
+        case AnchorsBase::RightProperty://Deliberate
+        case AnchorsBase::WidthProperty:
+            return Qt::Horizontal;
+        default:
+            return Qt::Vertical;
+        }
+    }
+
+    int indexOfBinding(AnchorsBase::BindingProperty property) const
+    {
+        for (int i = 0; i < bindings.size(); ++i) {
+            if (bindings.at(i).property == property) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    int bindingCount(Qt::Orientation orientation) const
+    {
+        int count = 0;
+
+        foreach (const Binding &binding, bindings) {
+            if (bindingOrientation(binding.property) == orientation) {
+                ++count;
+            }
+        }
+
+        return count;
+    }
+
+    bool readsFrom(const AnchorsBase *base) const
+    {
+        foreach (const Binding &binding, bindings) {
+            if (binding.dependencies.contains(const_cast<AnchorsBase *>(base))) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // called by the tracked getters, every widget an expression reads while
+    // it is evaluated becomes one of its dependencies
+    static void record(QWidget *w)
+    {
+        if (!recording) {
+            return;
+        }
+
+        AnchorsBase *base = implicitAnchorsBase(w);
+
+        if (!recording->dependencies.contains(base)) {
+            recording->dependencies << base;
+        }
+    }
+
+    void connectDependency(AnchorsBase *base)
+    {
+        Q_Q(AnchorsBase);
+
+        ExtendWidget *source = base->d_func()->extendWidget;
+
+        // the parent is read in its own coordinates, only its size matters
+        if (base->target() != extendWidget->target()->parentWidget()) {
+            QObject::connect(source, SIGNAL(positionChanged(QPoint)), q, SLOT(updateBindings()), Qt::UniqueConnection);
+        }
+        if (QObject::connect(source, SIGNAL(sizeChanged(QSize)), q, SLOT(updateBindings()), Qt::UniqueConnection)) {
+            ++base->d_func()->readers;
+        }
+    }
+
+    void dropDependencies(const QList<QPointer<AnchorsBase> > &list)
+    {
+        Q_Q(AnchorsBase);
+
+        foreach (const QPointer<AnchorsBase> &base, list) {
+            if (base && !readsFrom(base)) {
+                base->d_func()->dropReader(q);
+            }
+        }
+    }
+
+    qreal evaluate(Binding &binding)
+    {
+        QList<QPointer<AnchorsBase> > old = binding.dependencies;
+        Binding *outer_binding = recording;
+        const AnchorsBasePrivate *outer_owner = recordingOwner;
+
+        binding.dependencies.clear();
+        recording = &binding;
+        recordingOwner = this;
+        qreal value = binding.expression();
+        recording = outer_binding;
+        recordingOwner = outer_owner;
+        binding.stale = false;
+
+        // the dependencies are taken again on every evaluation, so that
+        // branches in the expression only track what they actually read
+        foreach (const QPointer<AnchorsBase> &base, binding.dependencies) {
+            if (base && !old.contains(base)) {
+                connectDependency(base);
+            }
+        }
+        dropDependencies(old);
+
+        return value;
+    }
+
+    void markStale(const QWidget *w)
+    {
+        for (int i = 0; i < bindings.size(); ++i) {
+            Binding &binding = bindings[i];
+
+            foreach (const QPointer<AnchorsBase> &base, binding.dependencies) {
+                if (base && base->target() == w) {
+                    binding.stale = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // returns the update flags of the axes whose bound values changed
+    int evaluateBindings()
+    {
+        int flags = 0;
+
+        for (int i = 0; i < bindings.size(); ++i) {
+            if (!bindings.at(i).stale) {
+                continue;
+            }
+
+            qreal value = evaluate(bindings[i]);
+            Binding &binding = bindings[i];
+
+            if (value != binding.value) {
+                binding.value = value;
+                flags |= bindingOrientation(binding.property) == Qt::Vertical ? VerticalFlag : HorizontalFlag;
+            }
+        }
+
+        return flags;
+    }
+
+    void dropReader(AnchorsBase *reader)
+    {
+        QObject::disconnect(extendWidget, SIGNAL(positionChanged(QPoint)), reader, SLOT(updateBindings()));
+        if (QObject::disconnect(extendWidget, SIGNAL(sizeChanged(QSize)), reader, SLOT(updateBindings()))) {
+            --readers;
+            requestReclaim();
+        }
+    }
+
+    void clearBindings()
+    {
+        QList<Binding> list = bindings;
+
+        bindings.clear();
+        foreach (const Binding &binding, list) {
+            dropDependencies(binding.dependencies);
+        }
+        updateSizeConnections();
+    }
+
+    // places the bound size and edges of one axis on top of what the anchors
+    // computed: the size keeps the pinned edge, a free edge moves the widget
+    // and an edge bound next to a pinned one resizes it
+    void applyBindings(QRect &rect, Qt::AnchorPoint &fixed, Qt::Orientation orientation) const
+    {
+        if (bindings.isEmpty()) {
+            return;
+        }
+
+        bool vertical = orientation == Qt::Vertical;
+        const Qt::AnchorPoint points[] = {
+            vertical ? Qt::AnchorTop : Qt::AnchorLeft,
+            vertical ? Qt::AnchorVerticalCenter : Qt::AnchorHorizontalCenter,
+            vertical ? Qt::AnchorBottom : Qt::AnchorRight
+        };
+        int start = vertical ? rect.top() : rect.left();
+        int size = vertical ? rect.height() : rect.width();
+        bool pinned = (vertical ? verticalAnchorCount() : horizontalAnchorCount()) > 0;
+        int index = indexOfBinding(vertical ? AnchorsBase::HeightProperty : AnchorsBase::WidthProperty);
+
+        if (index >= 0) {
+            int value = qMax(0, roundValue(bindings.at(index).value));
+
+            if (pinned && fixed == points[2]) {
+                start += size - value;
+            } else if (pinned && fixed == points[1]) {
+                start = centeredStart(start + size / 2.0, value);
+            }
+            size = value;
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            index = indexOfBinding(AnchorsBase::BindingProperty(points[i]));
+
+            if (index < 0) {
+                continue;
+            }
+
+            qreal value = bindings.at(index).value;
+
+            if (!pinned) {
+                if (i == 0) {
+                    start = roundValue(value);
+                } else if (i == 1) {
+                    start = centeredStart(value, size);
+                } else {
+                    start = roundValue(value) - size;
+                }
+
+                pinned = true;
+                fixed = points[i];
+                continue;
+            }
+
+            int end = start + size;
+
+            if (fixed == points[0]) {
+                size = i == 1 ? roundValue(2 * (value - start)) : roundValue(value) - start;
+            } else if (fixed == points[2]) {
+                start = i == 1 ? end - roundValue(2 * (end - value)) : roundValue(value);
+                size = end - start;
+            } else {
+                qreal center = start + size / 2.0;
+                int edge = roundValue(value);
+
+                size = roundValue(2 * qAbs(edge - center));
+                start = i == 0 ? edge : edge - size;
+            }
+        }
+
+        size = qMax(0, size);
+
+        if (vertical) {
+            rect.moveTop(start);
+            rect.setHeight(size);
+        } else {
+            rect.moveLeft(start);
+            rect.setWidth(size);
+        }
+    }
+
+    // an edge other than the start one, or anything bound by an expression,
+    // has to be placed again when the widget itself is resized
+    void updateSizeConnections()
+    {
+        Q_Q(AnchorsBase);
+
+        if (((q->isBinding(right) || q->isBinding(horizontalCenter)) && horizontalAnchorCount() == 1)
+                || bindingCount(Qt::Horizontal)) {
+            QObject::connect(extendWidget, SIGNAL(widthChanged(int)), q, SLOT(updateHorizontal()), Qt::UniqueConnection);
+        } else {
+            QObject::disconnect(extendWidget, SIGNAL(widthChanged(int)), q, SLOT(updateHorizontal()));
+        }
+
+        if (((q->isBinding(bottom) || q->isBinding(verticalCenter)) && verticalAnchorCount() == 1)
+                || bindingCount(Qt::Vertical)) {
+            QObject::connect(extendWidget, SIGNAL(heightChanged(int)), q, SLOT(updateVertical()), Qt::UniqueConnection);
+        } else {
+            QObject::disconnect(extendWidget, SIGNAL(heightChanged(int)), q, SLOT(updateVertical()));
+        }
+
+        // a free size the aspect ratio reads from is followed by the other
+        // axis, a determined one already places both in its own update
+        Qt::Orientations derived = centerIn->target() ? Qt::Orientations() : aspectOrientation();
+
+        if (derived == Qt::Vertical && !sizeDetermined(Qt::Horizontal)) {
+            QObject::connect(extendWidget, SIGNAL(widthChanged(int)), q, SLOT(updateVertical()), Qt::UniqueConnection);
+        } else {
+            QObject::disconnect(extendWidget, SIGNAL(widthChanged(int)), q, SLOT(updateVertical()));
+        }
+
+        if (derived == Qt::Horizontal && !sizeDetermined(Qt::Vertical)) {
+            QObject::connect(extendWidget, SIGNAL(heightChanged(int)), q, SLOT(updateHorizontal()), Qt::UniqueConnection);
+        } else {
+            QObject::disconnect(extendWidget, SIGNAL(heightChanged(int)), q, SLOT(updateHorizontal()));
+        }
+    }
+
+    void requestLayout();
+    void touch();
+    void setError(AnchorsBase::AnchorError code, const QString &string);
+
+    bool park(int flag);
+    void unpark();
+    static void requestSlice();
+    bool cull(int flag);
+    void uncull();
+    void dropCulled();
+
+    bool deferUpdate(int flag)
+    {
+        if (immediate > 0) {
+            return false;
+        }
+
+        if (Q_UNLIKELY(!cullings.isEmpty()) && cull(flag)) {
+            return true;
+        }
+
+        if (Q_UNLIKELY(scheduler) && park(flag)) {
+            return true;
+        }
+
+        if (Q_UNLIKELY(incremental)) {
+            markDirty(flag);
+            requestSlice();
+            return true;
+        }
+
+        if (deferDepth > 0) {
+            markDirty(flag);
+            return true;
+        }
+
+        if (layout) {
+            markDirty(flag);
+            requestLayout();
+            return true;
+        }
+
+        return false;
+    }
+
+    void process()
+    {
+        if (!dirty || visiting) {
+            return;
+        }
+
+        // settle everything this widget is anchored to before computing it,
+        // so that each widget is committed once per pass
+        AnchorsBasePrivate *list[MaxDependencies];
+        int count = dependencies(list);
+
+        visiting = true;
+        for (int i = 0; i < count; ++i) {
+            if (Q_UNLIKELY(list[i]->culled)) {
+                list[i]->uncull();
+            }
+            list[i]->process();
+        }
+        foreach (const Binding &binding, bindings) {
+            foreach (const QPointer<AnchorsBase> &base, binding.dependencies) {
+                if (base && base->d_func() != this) {
+                    if (Q_UNLIKELY(base->d_func()->culled)) {
+                        base->d_func()->uncull();
+                    }
+                    base->d_func()->process();
+                }
+            }
+        }
+        visiting = false;
+
+        int flags = takeDirty();
+
+        if (flags & BindingFlag) {
+            flags |= evaluateBindings();
+        }
+
+        if (!flags) {
+            return;
+        }
+
+        // the update of the axis an aspect ratio reads from places both
+        Qt::Orientations derived = aspectOrientation();
+
+        if (derived == Qt::Vertical && (flags & HorizontalFlag)) {
+            flags &= ~VerticalFlag;
+        } else if (derived == Qt::Horizontal && (flags & VerticalFlag)) {
+            flags &= ~HorizontalFlag;
+        }
+
+        Q_Q(AnchorsBase);
+
+        ++immediate;
+        if (flags & FillFlag) {
+            q->updateFill();
+        }
+        if (flags & CenterInFlag) {
+            q->updateCenterIn();
+        }
+        if (flags & VerticalFlag) {
+            q->updateVertical();
+        }
+        if (flags & HorizontalFlag) {
+            q->updateHorizontal();
+        }
+        --immediate;
+    }
+
+    // widgets at the defaults or applied from one template share their
+    // settings, a setter gives the widget its own copy first
+    static QExplicitlySharedDataPointer<AnchorsMargins> defaultSettings()
+    {
+        static QExplicitlySharedDataPointer<AnchorsMargins> settings(new AnchorsMargins);
+
+        return settings;
+    }
+
+    void detachSettings()
+    {
+        settings.detach();
+    }
+
+    void shareSettings(const QExplicitlySharedDataPointer<AnchorsMargins> &other)
+    {
+        Q_Q(AnchorsBase);
+
+        QExplicitlySharedDataPointer<AnchorsMargins> old = settings;
+
+        settings = other;
+
+        if (old->margins != other->margins) {
+            emit q->marginsChanged(other->margins);
+        }
+        if (old->topMargin != other->topMargin) {
+            emit q->topMarginChanged(other->topMargin);
+        }
+        if (old->bottomMargin != other->bottomMargin) {
+            emit q->bottomMarginChanged(other->bottomMargin);
+        }
+        if (old->leftMargin != other->leftMargin) {
+            emit q->leftMarginChanged(other->leftMargin);
+        }
+        if (old->rightMargin != other->rightMargin) {
+            emit q->rightMarginChanged(other->rightMargin);
+        }
+        if (old->horizontalCenterOffset != other->horizontalCenterOffset) {
+            emit q->horizontalCenterOffsetChanged(other->horizontalCenterOffset);
+        }
+        if (old->verticalCenterOffset != other->verticalCenterOffset) {
+            emit q->verticalCenterOffsetChanged(other->verticalCenterOffset);
+        }
+        if (old->alignWhenCentered != other->alignWhenCentered) {
+            emit q->alignWhenCenteredChanged(other->alignWhenCentered);
+        }
+        if (old->aspectRatio != other->aspectRatio) {
+            updateSizeConnections();
+            emit q->aspectRatioChanged(other->aspectRatio);
+        }
+    }
+
+    struct Variable {
+        int value = 0;
+        QSet<AnchorsBasePrivate *> dependents;
+    };
+
+    void applyVariable(int property, int value)
+    {
+        Q_Q(AnchorsBase);
+
+        applyingVariable = true;
+        switch (property) {
+        case AnchorsBase::MarginsProperty:
+            q->setMargins(value);
+            break;
+        case AnchorsBase::TopMarginProperty:
+            q->setTopMargin(value);
+            break;
+        case AnchorsBase::BottomMarginProperty:
+            q->setBottomMargin(value);
+            break;
+        case AnchorsBase::LeftMarginProperty:
+            q->setLeftMargin(value);
+            break;
+        case AnchorsBase::RightMarginProperty:
+            q->setRightMargin(value);
+            break;
+        case AnchorsBase::HorizontalCenterOffsetProperty:
+            q->setHorizontalCenterOffset(value);
+            break;
+        case AnchorsBase::VerticalCenterOffsetProperty:
+            q->setVerticalCenterOffset(value);
+            break;
+        }
+        applyingVariable = false;
+    }
+
+    // the caller defers, so every dependent of the variable is laid out once
+    static void applyVariable(const QString &name, const Variable &variable)
+    {
+        foreach (AnchorsBasePrivate *d, variable.dependents) {
+            for (QHash<int, QString>::const_iterator it = d->variableNames.constBegin();
+                 it != d->variableNames.constEnd(); ++it) {
+                if (it.value() == name) {
+                    d->applyVariable(it.key(), variable.value);
+                }
+            }
+        }
+    }
+
+    void dropVariable(int property)
+    {
+        QString name = variableNames.take(property);
+
+        // another property of the widget may still use the same variable
+        if (!variableNames.values().contains(name)) {
+            variables[name].dependents.remove(this);
+        }
+    }
+
+    // a value set directly replaces the variable the property followed
+    void unlinkVariable(int property)
+    {
+        if (!applyingVariable && variableNames.contains(property)) {
+            touch();
+            dropVariable(property);
+        }
+    }
+
+    void dropVariables()
+    {
+        foreach (const QString &name, variableNames) {
+            QHash<QString, Variable>::iterator it = variables.find(name);
+
+            if (it != variables.end()) {
+                it->dependents.remove(this);
+            }
+        }
+        variableNames.clear();
+    }
+
+    void release(AnchorInfo *info)
+    {
+        incoming.remove(info);
+        requestReclaim();
+    }
+
+    // nothing anchors to or from the widget any more and none of its
+    // settings would be lost with the object
+    bool isIdle() const
+    {
+        if (!reclaimable || !handles.isEmpty() || readers || !incoming.isEmpty()) {
+            return false;
+        }
+
+        for (int i = 0; i < 6; ++i) {
+            if (infos[i].targetInfo) {
+                return false;
+            }
+        }
+
+        if (fill->target() || centerIn->target() || !bindings.isEmpty() || !variableNames.isEmpty()
+                || layout || dirty || parked || culled) {
+            return false;
+        }
+
+        const AnchorsMargins *m = settings.constData();
+
+        if (m->margins || m->topMargin || m->bottomMargin || m->leftMargin || m->rightMargin
+                || m->horizontalCenterOffset || m->verticalCenterOffset || m->alignWhenCentered || m->aspectRatio > 0
+                || !extendWidget->enabled()) {
+            return false;
+        }
+
+        return !anchorsLayoutCaches.contains(extendWidget->target());
+    }
+
+    void requestReclaim()
+    {
+        if (!autoReclaim || !reclaimable || reclaimQueued) {
+            return;
+        }
+
+        // the check runs from the event loop, so a widget that is anchored
+        // again right after its last anchor was cleared keeps its object
+        if (reclaims.isEmpty()) {
+            QTimer::singleShot(0, &AnchorsBasePrivate::reclaimIdle);
+        }
+        reclaimQueued = true;
+        reclaims << q_ptr;
+    }
+
+    static void reclaimIdle()
+    {
+        if (transaction || deferDepth > 0) {
+            QTimer::singleShot(0, &AnchorsBasePrivate::reclaimIdle);
+            return;
+        }
+
+        QList<QPointer<AnchorsBase> > list = reclaims;
+
+        reclaims.clear();
+        foreach (const QPointer<AnchorsBase> &base, list) {
+            if (!base) {
+                continue;
+            }
+
+            AnchorsBasePrivate *d = base->d_func();
+
+            d->reclaimQueued = false;
+            if (autoReclaim && d->isIdle()) {
+                // takes the event filter and the arena slot with it
+                delete base.data();
+            }
+        }
+    }
+
+    static void beginDefer()
+    {
+        ++deferDepth;
+    }
+
+    static void endDefer()
+    {
+        if (--deferDepth > 0) {
+            return;
+        }
+
+        // an incremental layout picks the batch up in its next time slice
+        if (Q_UNLIKELY(incremental)) {
+            if (dirtyFirst) {
+                requestSlice();
+            }
+            return;
+        }
+
+        // updates triggered while flushing are deferred too and picked up by
+        // this loop, so dependents are resolved after their targets
+        ++deferDepth;
+        beginPass();
+        while (dirtyFirst) {
+            dirtyFirst->process();
+        }
+        endPass();
+        --deferDepth;
+    }
+
+    AnchorsBase *q_ptr;
+
+    ExtendWidget targetObject;
+    ExtendWidget fillObject;
+    ExtendWidget centerInObject;
+    ExtendWidget *extendWidget = &targetObject;
+    AnchorInfo infos[6] = {
+        AnchorInfo(q_ptr, Qt::AnchorTop),
+        AnchorInfo(q_ptr, Qt::AnchorBottom),
+        AnchorInfo(q_ptr, Qt::AnchorLeft),
+        AnchorInfo(q_ptr, Qt::AnchorRight),
+        AnchorInfo(q_ptr, Qt::AnchorHorizontalCenter),
+        AnchorInfo(q_ptr, Qt::AnchorVerticalCenter)
+    };
+    AnchorInfo *top = &infos[0];
+    AnchorInfo *bottom = &infos[1];
+    AnchorInfo *left = &infos[2];
+    AnchorInfo *right = &infos[3];
+    AnchorInfo *horizontalCenter = &infos[4];
+    AnchorInfo *verticalCenter = &infos[5];
+    ExtendWidget *fill = &fillObject;
+    ExtendWidget *centerIn = &centerInObject;
+    QExplicitlySharedDataPointer<AnchorsMargins> settings = defaultSettings();
+    AnchorsBase::AnchorError errorCode = AnchorsBase::NoError;
+    QString errorString;
+    AnchorLayout *layout = NULL;
+    int dirty = 0;
+    int parked = 0;
+    int culled = 0;
+    QSet<AnchorInfo *> incoming;
+    int readers = 0;
+    QList<AnchorsBase *> handles;
+    bool teardown = false;
+    bool reclaimable = false;
+    bool reclaimQueued = false;
+    AnchorsViewportCullingPrivate *culling = NULL;
+    int immediate = 0;
+    bool visiting = false;
+    AnchorsBasePrivate *dirtyPrev = NULL;
+    AnchorsBasePrivate *dirtyNext = NULL;
+    quint32 pass = 0;
+    int iterations = 0;
+    QList<Binding> bindings;
+    QHash<int, QString> variableNames;
+    bool applyingVariable = false;
+    bool repaintPending = false;
+    bool repaintBlocked = false;
+    QRect repaintFrom;
+    static QMap<const QWidget *, AnchorsBase *> widgetMap;
+    static AnchorsBasePrivate *dirtyFirst;
+    static AnchorsBasePrivate *dirtyLast;
+    static int deferDepth;
+    static AnchorsTransactionPrivate *transaction;
+    static QHash<const QWidget *, quint32> graphVersions;
+    static AnchorsBase::CenterRounding centerRounding;
+    static int iterationLimit;
+    static quint32 currentPass;
+    static quint32 reportedPass;
+    static int passDepth;
+    static Binding *recording;
+    static const AnchorsBasePrivate *recordingOwner;
+    static AnchorsSchedulerPrivate *scheduler;
+    static AnchorsIncrementalLayoutPrivate *incremental;
+    static QHash<const QWidget *, AnchorsViewportCullingPrivate *> cullings;
+    static QHash<QString, Variable> variables;
+    static QHash<const QWidget *, EngineSelection> engines;
+    static QList<QPointer<AnchorsBase> > reclaims;
+    static bool autoReclaim;
+    static bool repaintCoalescing;
+    static QVarLengthArray<AnchorsBasePrivate *, 256> suppressed;
+    static QVarLengthArray<Repaint, 16> repaints;
+
+    Q_DECLARE_PUBLIC(AnchorsBase)
+
+    friend class AnchorLayout;
+    friend class AnchorLayoutPrivate;
+    friend class AnchorsTransaction;
+    friend class AnchorsTransactionPrivate;
+    friend class AnchorsLayoutCache;
+    friend class AnchorsLayoutCachePrivate;
+    friend class AnchorsScheduler;
+    friend class AnchorsSchedulerPrivate;
+    friend class AnchorsIncrementalLayout;
+    friend class AnchorsIncrementalLayoutPrivate;
+    friend class AnchorsViewportCulling;
+    friend class AnchorsViewportCullingPrivate;
+    friend class AnchorsVariables;
+    friend class AnchorsEngine;
+    friend class AnchorsTemplate;
+    friend class AnchorsTemplatePrivate;
+    friend struct AnchorInfo;
+    friend void anchorsGeometryChanged(const QWidget *w);
+    friend void anchorsWindowGone(const QWidget *window);
+};
+
+QMap<const QWidget *, AnchorsBase *> AnchorsBasePrivate::widgetMap;
+AnchorsBasePrivate *AnchorsBasePrivate::dirtyFirst = NULL;
+AnchorsBasePrivate *AnchorsBasePrivate::dirtyLast = NULL;
+int AnchorsBasePrivate::deferDepth = 0;
+AnchorsTransactionPrivate *AnchorsBasePrivate::transaction = NULL;
+QHash<const QWidget *, quint32> AnchorsBasePrivate::graphVersions;
+AnchorsBase::CenterRounding AnchorsBasePrivate::centerRounding = AnchorsBase::RoundDown;
+int AnchorsBasePrivate::iterationLimit = 64;
+quint32 AnchorsBasePrivate::currentPass = 0;
+quint32 AnchorsBasePrivate::reportedPass = 0;
+int AnchorsBasePrivate::passDepth = 0;
+AnchorsBasePrivate::Binding *AnchorsBasePrivate::recording = NULL;
+const AnchorsBasePrivate *AnchorsBasePrivate::recordingOwner = NULL;
+AnchorsSchedulerPrivate *AnchorsBasePrivate::scheduler = NULL;
+AnchorsIncrementalLayoutPrivate *AnchorsBasePrivate::incremental = NULL;
+QHash<const QWidget *, AnchorsViewportCullingPrivate *> AnchorsBasePrivate::cullings;
+QHash<QString, AnchorsBasePrivate::Variable> AnchorsBasePrivate::variables;
+QHash<const QWidget *, AnchorsBasePrivate::EngineSelection> AnchorsBasePrivate::engines;
+QList<QPointer<AnchorsBase> > AnchorsBasePrivate::reclaims;
+bool AnchorsBasePrivate::autoReclaim = true;
+bool AnchorsBasePrivate::repaintCoalescing = true;
+QVarLengthArray<AnchorsBasePrivate *, 256> AnchorsBasePrivate::suppressed;
+QVarLengthArray<AnchorsBasePrivate::Repaint, 16> AnchorsBasePrivate::repaints;
+
+AnchorsBase::AnchorsBase(QWidget *w):
+    QObject(w)
+{
+    init(w);
+}
+
+AnchorsBase::~AnchorsBase()
+{
+    Q_D(AnchorsBase);
+
+    QWidget *w = qobject_cast<QWidget *>(parent());
+
+    // the whole window goes: the primaries free their privates and nothing
+    // is detached one by one, a handle may already have lost its private
+    if (AnchorsArena::isTearingDown(w)) {
+        if (AnchorsBasePrivate::getWidgetAnchorsBase(w) == this) {
+            AnchorsBasePrivate::widgetMap.remove(w);
+            d->teardown = true;
+            delete d;
+        }
+        return;
+    }
+
+    // the primary went first, there is nothing left to detach from
+    if (!d) {
+        return;
+    }
+
+    AnchorsBasePrivate::touchGraph(w);
+
+    if (d->q_func() == this) {
+        d->removeWidgetAnchorsBase(target(), this);
+        foreach (AnchorsBase *handle, d->handles) {
+            handle->d_ptr = NULL;
+        }
+        delete d;
+    } else {
+        d->handles.removeOne(this);
+        d->requestReclaim();
+    }
+}
+
+void *AnchorsBase::operator new(size_t size)
+{
+    return AnchorsArena::allocate(size, NULL);
+}
+
+void *AnchorsBase::operator new(size_t size, const QWidget *w)
+{
+    return AnchorsArena::allocate(size, w);
+}
+
+void AnchorsBase::operator delete(void *ptr)
+{
+    AnchorsArena::release(ptr);
+}
+
+void AnchorsBase::operator delete(void *ptr, const QWidget *w)
+{
+    Q_UNUSED(w)
+
+    AnchorsArena::release(ptr);
+}
+
+QWidget *AnchorsBase::target() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->extendWidget->target();
+}
+
+bool AnchorsBase::enabled() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->extendWidget->enabled();
+}
+
+bool AnchorsBase::isRetained() const
+{
+    Q_D(const AnchorsBase);
+
+    return !d->reclaimable;
+}
+
+void AnchorsBase::setRetained(bool retained)
+{
+    Q_D(AnchorsBase);
+
+    if (d->reclaimable != retained) {
+        return;
+    }
+
+    d->reclaimable = !retained;
+    d->requestReclaim();
+}
+
+const AnchorsBase *AnchorsBase::anchors() const
+{
+    return this;
+}
+
+const AnchorInfo *AnchorsBase::top() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->top;
+}
+
+const AnchorInfo *AnchorsBase::bottom() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->bottom;
+}
+
+const AnchorInfo *AnchorsBase::left() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->left;
+}
+
+const AnchorInfo *AnchorsBase::right() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->right;
+}
+
+const AnchorInfo *AnchorsBase::horizontalCenter() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->horizontalCenter;
+}
+
+const AnchorInfo *AnchorsBase::verticalCenter() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->verticalCenter;
+}
+
+QWidget *AnchorsBase::fill() const
+{
+    Q_D(const AnchorsBase);
+
+    if (d->fill) {
+        return d->fill->target();
+    }
+
+    return NULL;
+}
+
+QWidget *AnchorsBase::centerIn() const
+{
+    Q_D(const AnchorsBase);
+
+    if (d->centerIn) {
+        return d->centerIn->target();
+    }
+
+    return NULL;
+}
+
+int AnchorsBase::margins() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->settings->margins;
+}
+
+int AnchorsBase::topMargin() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->settings->topMargin;
+}
+
+int AnchorsBase::bottomMargin() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->settings->bottomMargin;
+}
+
+int AnchorsBase::leftMargin() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->settings->leftMargin;
+}
+
+int AnchorsBase::rightMargin() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->settings->rightMargin;
+}
+
+int AnchorsBase::horizontalCenterOffset() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->settings->horizontalCenterOffset;
+}
+
+int AnchorsBase::verticalCenterOffset() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->settings->verticalCenterOffset;
+}
+
+int AnchorsBase::alignWhenCentered() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->settings->alignWhenCentered;
+}
+
+qreal AnchorsBase::aspectRatio() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->settings->aspectRatio;
+}
+
+AnchorsBase::AnchorError AnchorsBase::errorCode() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->errorCode;
+}
+
+QString AnchorsBase::errorString() const
+{
+    Q_D(const AnchorsBase);
+
+    return d->errorString;
+}
+
+bool AnchorsBase::isBinding(const AnchorInfo *info) const
+{
+    return info->targetInfo;
+}
+
+bool AnchorsBase::hasBinding(BindingProperty property) const
+{
+    Q_D(const AnchorsBase);
+
+    return d->indexOfBinding(property) >= 0;
+}
+
+QList<QWidget *> AnchorsBase::bindingDependencies(BindingProperty property) const
+{
+    Q_D(const AnchorsBase);
+
+    QList<QWidget *> list;
+    int index = d->indexOfBinding(property);
+
+    if (index >= 0) {
+        foreach (const QPointer<AnchorsBase> &base, d->bindings.at(index).dependencies) {
+            if (base) {
+                list << base->target();
+            }
+        }
+    }
+
+    return list;
+}
+
+bool AnchorsBase::setAnchor(QWidget *w, const Qt::AnchorPoint &p, QWidget *target, const Qt::AnchorPoint &point)
+{
+    if (!w || !target) {
+        return false;
+    }
+
+    anchorsTemplateRelease(w);
+
+    return AnchorsBasePrivate::implicitAnchorsBase(w)->setAnchor(p, target, point);
+}
+
+void AnchorsBase::clearAnchors(const QWidget *w)
+{
+    anchorsTemplateDrop(w);
+
+    AnchorsBase *base = AnchorsBasePrivate::getWidgetAnchorsBase(w);
+    if (base) {
+        base->deleteLater();
+    }
+}
+
+void AnchorsBase::clearWindowAnchors(const QWidget *window)
+{
+    QList<AnchorsBase *> list;
+
+    // the anchors of the window only point at each other, so they are torn
+    // down like the window itself and its arena goes with the last private
+    AnchorsArena::beginTeardown(window);
+    anchorsTemplateDropWindow(window);
+
+    foreach (AnchorsBase *base, AnchorsBasePrivate::widgetMap) {
+        if (AnchorsArena::isTearingDown(base->target())) {
+            list << base << base->d_func()->handles;
+        }
+    }
+
+    qDeleteAll(list);
+    AnchorsArena::endTeardown(window);
+}
+
+// a plain lookup: an object the library created on its own may still be
+// reclaimed once idle, setRetained() keeps it for a caller holding on to it
+AnchorsBase *AnchorsBase::getAnchorBaseByWidget(const QWidget *w)
+{
+    return AnchorsBasePrivate::getWidgetAnchorsBase(w);
+}
+
+// the caller may keep the returned pointer, so the object is retained
+AnchorsBase *AnchorsBase::createAnchorBase(QWidget *w)
+{
+    anchorsTemplateRelease(w);
+
+    AnchorsBase *base = AnchorsBasePrivate::implicitAnchorsBase(w);
+
+    if (base) {
+        base->d_func()->reclaimable = false;
+    }
+
+    return base;
+}
+
+AnchorsBase::CenterRounding AnchorsBase::centerRounding()
+{
+    return AnchorsBasePrivate::centerRounding;
+}
+
+void AnchorsBase::setCenterRounding(CenterRounding rounding)
+{
+    AnchorsBasePrivate::centerRounding = rounding;
+}
+
+int AnchorsBase::iterationLimit()
+{
+    return AnchorsBasePrivate::iterationLimit;
+}
+
+void AnchorsBase::setIterationLimit(int limit)
+{
+    AnchorsBasePrivate::iterationLimit = qMax(1, limit);
+}
+
+bool AnchorsBase::repaintCoalescing()
+{
+    return AnchorsBasePrivate::repaintCoalescing;
+}
+
+void AnchorsBase::setRepaintCoalescing(bool enabled)
+{
+    AnchorsBasePrivate::repaintCoalescing = enabled;
+}
+
+bool AnchorsBase::autoReclaim()
+{
+    return AnchorsBasePrivate::autoReclaim;
+}
+
+void AnchorsBase::setAutoReclaim(bool enabled)
+{
+    AnchorsBasePrivate::autoReclaim = enabled;
+}
+
+qreal AnchorsBase::valueOf(QWidget *w, Qt::AnchorPoint point)
+{
+    if (!w) {
+        return 0;
+    }
+
+    AnchorsBasePrivate::record(w);
+
+    const AnchorsBasePrivate *owner = AnchorsBasePrivate::recordingOwner;
+    QRect rect = owner ? QRect(owner->getWidgetRect(w)) : w->geometry();
+
+    return AnchorsBasePrivate::getValueByRect(rect, point);
+}
+
+int AnchorsBase::widthOf(QWidget *w)
+{
+    if (!w) {
+        return 0;
+    }
+
+    AnchorsBasePrivate::record(w);
+
+    return w->width();
+}
+
+int AnchorsBase::heightOf(QWidget *w)
+{
+    if (!w) {
+        return 0;
+    }
+
+    AnchorsBasePrivate::record(w);
+
+    return w->height();
+}
+
+// true when the anchors, a binding or the aspect ratio give w its size on
+// the axis, whatever the widget proposes there is overridden
+bool AnchorsBase::isSizeAnchored(const QWidget *w, Qt::Orientation orientation)
+{
+    AnchorsBase *base = AnchorsBasePrivate::getWidgetAnchorsBase(w);
+
+    if (!base) {
+        return anchorsTemplateSizeAnchored(w, orientation);
+    }
+    if (!base->enabled()) {
+        return false;
+    }
+
+    AnchorsBasePrivate *d = base->d_func();
+
+    return d->fill->target() || d->sizeDetermined(orientation) || (d->aspectOrientation() & orientation);
+}
+
+void AnchorsBase::setEnabled(bool enabled)
+{
+    Q_D(AnchorsBase);
+
+    d->touch();
+    d->extendWidget->setEnabled(enabled);
+}
+
+bool AnchorsBase::setAnchor(const Qt::AnchorPoint &p, QWidget *target, const Qt::AnchorPoint &point)
+{
+    if (!target) {
+        return false;
+    }
+
+    AnchorsBase *base = AnchorsBasePrivate::implicitAnchorsBase(target);
+    const AnchorInfo *info = base->d_func()->getInfoByPoint(point);
+
+    switch (p) {
+    case Qt::AnchorTop:
+        return setTop(info);
+    case Qt::AnchorBottom:
+        return setBottom(info);
+    case Qt::AnchorLeft:
+        return setLeft(info);
+    case Qt::AnchorRight:
+        return setRight(info);
+    case Qt::AnchorHorizontalCenter:
+        return setHorizontalCenter(info);
+    case Qt::AnchorVerticalCenter:
+        return setVerticalCenter(info);
+    default:
+        return false;
+    }
+}
+
+#define UPDATE_NOW(call)\
+    ++d->immediate;\
+    call;\
+    --d->immediate;\
+
+#define ANCHOR_BIND_INFO(point, Point, slotName, signalsname...)\
+    Q_D(AnchorsBase);\
+    if(*d->point == point)\
+        return true;\
+    d->touch();\
+    ExtendWidget *tmp_w1 = NULL;\
+    ExtendWidget *tmp_w2 = NULL;\
+    if(d->point->targetInfo){\
+        tmp_w1 = d->point->targetInfo->base->d_func()->extendWidget;\
+    }\
+    QStringList signalList = QString(#signalsname).split("),");\
+    if(point){\
+        if(d->indexOfBinding(AnchorsBase::BindingProperty(d->point->type)) >= 0){\
+            d->setError(Conflict, "Conflict: an expression is bound to the edge.");\
+            return false;\
+        }\
+        if(!d->isBindable(d->point)){\
+            d->setError(Conflict, "Conflict: CenterIn or Fill is anchored.");\
+            return false;\
+        }\
+        if (point->base == d->q_func()){\
+            d->setError(TargetInvalid, "Cannot anchor widget to self.");\
+            return false;\
+        }else if(target()->parentWidget() != point->base->target()){\
+            bool isBrother = false;\
+            foreach (const QWidget *w, target()->parentWidget()->findChildren<QWidget*>()) {\
+                if(w == point->base->target()){\
+                    isBrother = true;\
+                    break;\
+                }\
+            }\
+            if(!isBrother){\
+                d->setError(TargetInvalid, "Cannot anchor to an widget that isn't a parent or sibling.");\
+                return false;\
+            }\
+        }\
+        if(!d->checkInfo(d->point, point)){\
+            d->setError(PointInvalid, "Cannot anchor a vertical/horizontal edge to a horizontal/vertical edge.");\
+            return false;\
+        }\
+        if(AnchorsBasePrivate::transaction){\
+            *d->point = point;\
+            slotName();\
+        }else{\
+            int old_pos = d->getValueByInfo(point);\
+            AnchorInfo old_info = *d->point;\
+            *d->point = point;\
+            UPDATE_NOW(slotName());\
+            if(old_pos != d->getValueByInfo(point)){\
+                *d->point = old_info;\
+                UPDATE_NOW(slotName());\
+                d->setError(PointInvalid, "loop bind.");\
+                return false;\
+            }else{\
+                old_pos = d->getValueByInfo(d->point);\
+                int target_old_value = d->getValueByInfo(point);\
+                d->setValueByInfo(target_old_value + 1, point);\
+                if(old_pos != d->getValueByInfo(d->point)){\
+                    *d->point = old_info;\
+                    UPDATE_NOW(slotName());\
+                    d->setValueByInfo(target_old_value, point);\
+                    d->setError(PointInvalid, "loop bind.");\
+                    return false;\
+                }\
+                d->setValueByInfo(target_old_value, point);\
+            }\
+        }\
+        tmp_w2 = point->base->d_func()->extendWidget;\
+        if(tmp_w1 != tmp_w2){\
+            foreach(QString str, signalList){\
+                QByteArray arr = str.replace(" ", "").toLatin1();\
+                if(arr.right(1) != ")") arr += ")";\
+                if(tmp_w1)\
+                    disconnect(tmp_w1, QByteArray("2"+arr).data(), d->q_func(), SLOT(slotName()));\
+                if(arr.size() != 13 || target()->parentWidget() != point->base->target())\
+                    connect(tmp_w2, QByteArray("2"+arr).data(), d->q_func(), SLOT(slotName()));\
+            }\
+        }\
+    }else{\
+        foreach(QString str, signalList){\
+            QByteArray arr = str.replace(" ", "").toLatin1();\
+            if(arr.right(1) != ")") arr += ")";\
+            disconnect(tmp_w1, QByteArray("2"+arr).data(), d->q_func(), SLOT(slotName()));\
+        }\
+        *d->point = point;\
+    }\
+    d->updateSizeConnections();\
+    emit point##Changed(d->point);\
+    return true;\
+
+#define ANCHOR_BIND_WIDGET(point, Point)\
+    if(d->point->target() == point)\
+        return true;\
+    d->touch();\
+    if(point){\
+        if (point == target()){\
+            d->setError(TargetInvalid, "Cannot anchor widget to self.");\
+            return false;\
+        }else if(target()->parentWidget() != point){\
+            bool isBrother = false;\
+            foreach (const QWidget *w, target()->parentWidget()->findChildren<QWidget*>()) {\
+                if(w == point){\
+                    isBrother = true;\
+                    break;\
+                }\
+            }\
+            if(!isBrother){\
+                d->setError(TargetInvalid, "Cannot anchor to an widget that isn't a parent or sibling.");\
+                return false;\
+            }\
+        }\
+        if(AnchorsBasePrivate::transaction){\
+            d->point->setTarget(point);\
+            update##Point();\
+        }else{\
+            QRect old_rect = point->geometry();\
+            QWidget *old_widget = d->point->target();\
+            d->point->setTarget(point);\
+            UPDATE_NOW(update##Point());\
+            if(old_rect != point->geometry()){\
+                d->point->setTarget(old_widget);\
+                UPDATE_NOW(update##Point());\
+                d->setError(PointInvalid, "loop bind.");\
+                return false;\
+            }\
+        }\
+        d->clearBindings();\
+        AnchorInfo *info = NULL;\
+        setTop(info);setLeft(info);setRight(info);setBottom(info);setHorizontalCenter(info);setVerticalCenter(info);setCenterIn((QWidget*)NULL);\
+        if(d->point == d->fill)\
+            setCenterIn((QWidget*)NULL);\
+        if(target()->parentWidget() == point)\
+            disconnect(d->point, SIGNAL(positionChanged(QPoint)), d->q_func(), SLOT(update##Point()));\
+        else connect(d->point, SIGNAL(positionChanged(QPoint)), d->q_func(), SLOT(update##Point()));\
+    }\
+    d->point->setTarget(point);\
+    if(!point)\
+        d->requestReclaim();\
+    if(d->centerIn){connect(d->extendWidget, SIGNAL(sizeChanged(QSize)), d->q_func(), SLOT(updateCenterIn()));}\
+    else disconnect(d->extendWidget, SIGNAL(sizeChanged(QSize)), d->q_func(), SLOT(updateCenterIn()));\
+    emit point##Changed(point);\
+    return true;\
+
+bool AnchorsBase::setTop(const AnchorInfo *top)
+{
+    ANCHOR_BIND_INFO(top, Top, updateVertical , yChanged(int), heightChanged(int))
+}
+
+bool AnchorsBase::setBottom(const AnchorInfo *bottom)
+{
+    ANCHOR_BIND_INFO(bottom, Bottom, updateVertical , yChanged(int), heightChanged(int))
+}
+
+bool AnchorsBase::setLeft(const AnchorInfo *left)
+{
+    ANCHOR_BIND_INFO(left, Left, updateHorizontal, xChanged(int), widthChanged(int))
+}
+
+bool AnchorsBase::setRight(const AnchorInfo *right)
+{
+    ANCHOR_BIND_INFO(right, Right, updateHorizontal, xChanged(int), widthChanged(int))
+}
+
+bool AnchorsBase::setHorizontalCenter(const AnchorInfo *horizontalCenter)
+{
+    ANCHOR_BIND_INFO(horizontalCenter, HorizontalCenter, updateHorizontal, xChanged(int), widthChanged(int))
+}
+
+bool AnchorsBase::setVerticalCenter(const AnchorInfo *verticalCenter)
+{
+    ANCHOR_BIND_INFO(verticalCenter, VerticalCenter, updateVertical , yChanged(int), heightChanged(int))
+}
+
+bool AnchorsBase::setFill(QWidget *fill)
+{
+    Q_D(AnchorsBase);
+
+    ANCHOR_BIND_WIDGET(fill, Fill)
+}
+
+bool AnchorsBase::setCenterIn(QWidget *centerIn)
+{
+    Q_D(AnchorsBase);
+
+    if (centerIn && d->fill->target()) {
+        d->setError(Conflict, "Conflict: Fill is anchored.");
+        return false;
+    }
+
+    ANCHOR_BIND_WIDGET(centerIn, CenterIn)
+}
+
+bool AnchorsBase::setFill(AnchorsBase *fill)
+{
+    return setFill(fill->target());
+}
+
+bool AnchorsBase::setCenterIn(AnchorsBase *centerIn)
+{
+    return setCenterIn(centerIn->target());
+}
+
+void AnchorsBase::setMargins(int margins)
+{
+    Q_D(AnchorsBase);
+
+    d->unlinkVariable(MarginsProperty);
+    if (d->settings->margins == margins) {
+        return;
+    }
+
+    d->touch();
+    d->detachSettings();
+    d->settings->margins = margins;
+
+    // edges without a margin of their own fall back to this one, so going
+    // back to zero moves them as well
+    if (d->fill->target()) {
+        updateFill();
+    } else {
+        updateVertical();
+        updateHorizontal();
+    }
+
+    emit marginsChanged(margins);
+}
+
+void AnchorsBase::setTopMargin(int topMargin)
+{
+    Q_D(AnchorsBase);
+
+    d->unlinkVariable(TopMarginProperty);
+    if (d->settings->topMargin == topMargin) {
+        return;
+    }
+
+    d->touch();
+    d->detachSettings();
+    d->settings->topMargin = topMargin;
+
+    if (d->fill->target()) {
+        updateFill();
+    } else if (isBinding(d->top)) {
+        updateVertical();
+    }
+
+    emit topMarginChanged(topMargin);
+}
+
+void AnchorsBase::setBottomMargin(int bottomMargin)
+{
+    Q_D(AnchorsBase);
+
+    d->unlinkVariable(BottomMarginProperty);
+    if (d->settings->bottomMargin == bottomMargin) {
+        return;
+    }
+
+    d->touch();
+    d->detachSettings();
+    d->settings->bottomMargin = bottomMargin;
+
+    if (d->fill->target()) {
+        updateFill();
+    } else if (isBinding(d->bottom)) {
+        updateVertical();
+    }
+
+    emit bottomMarginChanged(bottomMargin);
+}
+
+void AnchorsBase::setLeftMargin(int leftMargin)
+{
+    Q_D(AnchorsBase);
+
+    d->unlinkVariable(LeftMarginProperty);
+    if (d->settings->leftMargin == leftMargin) {
+        return;
+    }
+
+    d->touch();
+    d->detachSettings();
+    d->settings->leftMargin = leftMargin;
+
+    if (d->fill->target()) {
+        updateFill();
+    } else if (isBinding(d->left)) {
+        updateHorizontal();
+    }
+
+    emit leftMarginChanged(leftMargin);
+}
+
+void AnchorsBase::setRightMargin(int rightMargin)
+{
+    Q_D(AnchorsBase);
+
+    d->unlinkVariable(RightMarginProperty);
+    if (d->settings->rightMargin == rightMargin) {
+        return;
+    }
+
+    d->touch();
+    d->detachSettings();
+    d->settings->rightMargin = rightMargin;
+
+    if (isBinding(d->right)) {
+        updateHorizontal();
+    }
+    if (d->fill->target()) {
+        updateFill();
+    }
+
+    emit rightMarginChanged(rightMargin);
+}
+
+void AnchorsBase::setHorizontalCenterOffset(int horizontalCenterOffset)
+{
+    Q_D(AnchorsBase);
+
+    d->unlinkVariable(HorizontalCenterOffsetProperty);
+    if (d->settings->horizontalCenterOffset == horizontalCenterOffset) {
+        return;
+    }
+
+    d->touch();
+    d->detachSettings();
+    d->settings->horizontalCenterOffset = horizontalCenterOffset;
+
+    if (isBinding(d->horizontalCenter)) {
+        updateHorizontal();
+    }
+
+    emit horizontalCenterOffsetChanged(horizontalCenterOffset);
+}
+
+void AnchorsBase::setVerticalCenterOffset(int verticalCenterOffset)
+{
+    Q_D(AnchorsBase);
+
+    d->unlinkVariable(VerticalCenterOffsetProperty);
+    if (d->settings->verticalCenterOffset == verticalCenterOffset) {
+        return;
+    }
+
+    d->touch();
+    d->detachSettings();
+    d->settings->verticalCenterOffset = verticalCenterOffset;
+
+    if (isBinding(d->verticalCenter)) {
+        updateVertical();
+    }
+
+    emit verticalCenterOffsetChanged(verticalCenterOffset);
+}
+
+void AnchorsBase::setAlignWhenCentered(bool alignWhenCentered)
+{
+    Q_D(AnchorsBase);
+
+    if (d->settings->alignWhenCentered == alignWhenCentered) {
+        return;
+    }
+
+    d->touch();
+    d->detachSettings();
+    d->settings->alignWhenCentered = alignWhenCentered;
+
+    if (d->centerIn->target()) {
+        updateCenterIn();
+    }
+    if (isBinding(d->verticalCenter)) {
+        updateVertical();
+    }
+    if (isBinding(d->horizontalCenter)) {
+        updateHorizontal();
+    }
+
+    emit alignWhenCenteredChanged(alignWhenCentered);
+}
+
+void AnchorsBase::setAspectRatio(qreal aspectRatio)
+{
+    Q_D(AnchorsBase);
+
+    aspectRatio = qMax(qreal(0), aspectRatio);
+
+    if (d->settings->aspectRatio == aspectRatio) {
+        return;
+    }
+
+    d->touch();
+    d->detachSettings();
+    d->settings->aspectRatio = aspectRatio;
+    d->updateSizeConnections();
+
+    Qt::Orientations derived = d->aspectOrientation();
+
+    if (d->centerIn->target()) {
+        updateCenterIn();
+    } else if (derived == Qt::Vertical) {
+        updateVertical();
+    } else if (derived == Qt::Horizontal) {
+        updateHorizontal();
+    }
+
+    emit aspectRatioChanged(aspectRatio);
+}
+
+bool AnchorsBase::setBinding(BindingProperty property, const std::function<qreal()> &expression)
+{
+    Q_D(AnchorsBase);
+
+    if (!expression) {
+        clearBinding(property);
+        return true;
+    }
+
+    if (d->fill->target() || d->centerIn->target()) {
+        d->setError(Conflict, "Conflict: CenterIn or Fill is anchored.");
+        return false;
+    }
+
+    if (property != WidthProperty && property != HeightProperty
+            && isBinding(d->getInfoByPoint(Qt::AnchorPoint(property)))) {
+        d->setError(Conflict, "Conflict: the edge is anchored.");
+        return false;
+    }
+
+    Qt::Orientation orientation = d->bindingOrientation(property);
+    int index = d->indexOfBinding(property);
+    int count = (orientation == Qt::Vertical ? d->verticalAnchorCount() : d->horizontalAnchorCount())
+                + d->bindingCount(orientation) - (index >= 0 ? 1 : 0);
+
+    if (count >= 2) {
+        d->setError(Conflict, "Conflict: two anchors or bindings already determine the axis.");
+        return false;
+    }
+
+    d->touch();
+
+    if (index < 0) {
+        AnchorsBasePrivate::Binding binding;
+
+        binding.property = property;
+        d->bindings << binding;
+        index = d->bindings.size() - 1;
+    }
+
+    d->bindings[index].expression = expression;
+    qreal value = d->evaluate(d->bindings[index]);
+    d->bindings[index].value = value;
+    d->updateSizeConnections();
+
+    if (orientation == Qt::Vertical) {
+        updateVertical();
+    } else {
+        updateHorizontal();
+    }
+
+    emit bindingChanged(property);
+
+    return true;
+}
+
+bool AnchorsBase::setSizeBinding(BindingProperty property, QWidget *source, BindingProperty sourceProperty,
+                                 qreal ratio, int offset)
+{
+    Q_D(AnchorsBase);
+
+    if ((property != WidthProperty && property != HeightProperty)
+            || (sourceProperty != WidthProperty && sourceProperty != HeightProperty)) {
+        d->setError(PointInvalid, "Only a width or a height can be bound to a width or a height.");
+        return false;
+    }
+
+    if (!source) {
+        d->setError(TargetInvalid, "Cannot bind a size to a null widget.");
+        return false;
+    }
+
+    if (source == target()) {
+        d->setError(LoopBind, "loop bind, use the aspect ratio to size a widget by itself.");
+        return false;
+    }
+
+    // an ordinary expression, so the source is tracked and the size is
+    // resolved in the same pass as the edges
+    QPointer<QWidget> w = source;
+
+    if (sourceProperty == WidthProperty) {
+        return setBinding(property, [w, ratio, offset]() { return AnchorsBase::widthOf(w) * ratio + offset; });
+    }
+
+    return setBinding(property, [w, ratio, offset]() { return AnchorsBase::heightOf(w) * ratio + offset; });
+}
+
+void AnchorsBase::clearBinding(BindingProperty property)
+{
+    Q_D(AnchorsBase);
+
+    int index = d->indexOfBinding(property);
+
+    if (index < 0) {
+        return;
+    }
+
+    d->touch();
+
+    // the widget keeps its geometry, like it does when an anchor is removed
+    d->dropDependencies(d->bindings.takeAt(index).dependencies);
+    d->updateSizeConnections();
+    d->requestReclaim();
+
+    emit bindingChanged(property);
+}
+
+QString AnchorsBase::marginVariable(MarginProperty property) const
+{
+    Q_D(const AnchorsBase);
+
+    return d->variableNames.value(property);
+}
+
+bool AnchorsBase::setMarginVariable(MarginProperty property, const QString &name)
+{
+    Q_D(AnchorsBase);
+
+    QHash<QString, AnchorsBasePrivate::Variable>::iterator it = AnchorsBasePrivate::variables.find(name);
+
+    if (it == AnchorsBasePrivate::variables.end()) {
+        return false;
+    }
+
+    d->touch();
+    if (d->variableNames.contains(property)) {
+        d->dropVariable(property);
+    }
+
+    d->variableNames[property] = name;
+    it->dependents.insert(d);
+    d->applyVariable(property, it->value);
+
+    return true;
+}
+
+void AnchorsBase::clearMarginVariable(MarginProperty property)
+{
+    Q_D(AnchorsBase);
+
+    // the margin keeps the last value of the variable
+    if (d->variableNames.contains(property)) {
+        d->touch();
+        d->dropVariable(property);
+    }
+}
+
+#define SET_POS(fun, fixed)\
+    Q_D(AnchorsBase);\
+    ARect rect = target()->geometry();\
+    rect.set##fun(arg, point);\
+    d->commitGeometry(rect, fixed);\
+
+#define MOVE_POS(fun)\
+    Q_D(AnchorsBase);\
+    ARect rect = target()->geometry();\
+    rect.move##fun(arg);\
+    d->commitGeometry(rect, Qt::AnchorTop);\
+
+void AnchorsBase::setTop(int arg, Qt::AnchorPoint point)
+{
+    SET_POS(Top, Qt::AnchorBottom)
+}
+
+void AnchorsBase::setBottom(int arg, Qt::AnchorPoint point)
+{
+    SET_POS(Bottom, Qt::AnchorTop)
+}
+
+void AnchorsBase::setLeft(int arg, Qt::AnchorPoint point)
+{
+    SET_POS(Left, Qt::AnchorRight)
+}
+
+void AnchorsBase::setHorizontalCenter(int arg, Qt::AnchorPoint point)
+{
+    SET_POS(HorizontalCenter, point)
+}
+
+void AnchorsBase::setVerticalCenter(int arg, Qt::AnchorPoint point)
+{
+    SET_POS(VerticalCenter, point)
+}
+
+void AnchorsBase::setRight(int arg, Qt::AnchorPoint point)
+{
+    SET_POS(Right, Qt::AnchorLeft)
+}
+
+void AnchorsBase::moveTop(int arg)
+{
+    MOVE_POS(Top)
+}
+
+void AnchorsBase::moveBottom(int arg)
+{
+    MOVE_POS(Bottom)
+}
+
+void AnchorsBase::moveLeft(int arg)
+{
+    MOVE_POS(Left)
+}
+
+void AnchorsBase::moveRight(int arg)
+{
+    MOVE_POS(Right)
+}
+
+void AnchorsBase::moveHorizontalCenter(int arg)
+{
+    Q_D(AnchorsBase);
+
+    QRect rect = target()->geometry();
+    d->moveCentered(rect, Qt::AnchorHorizontalCenter, arg);
+    d->commitGeometry(rect, Qt::AnchorTop);
+}
+
+void AnchorsBase::moveVerticalCenter(int arg)
+{
+    Q_D(AnchorsBase);
+
+    QRect rect = target()->geometry();
+    d->moveCentered(rect, Qt::AnchorVerticalCenter, arg);
+    d->commitGeometry(rect, Qt::AnchorTop);
+}
+
+void AnchorsBase::moveCenter(const QPoint &arg)
+{
+    Q_D(AnchorsBase);
+
+    QRect rect = target()->geometry();
+    d->moveCentered(rect, Qt::AnchorHorizontalCenter, arg.x());
+    d->moveCentered(rect, Qt::AnchorVerticalCenter, arg.y());
+    d->commitGeometry(rect, Qt::AnchorTop);
+}
+
+void AnchorsBase::updateVertical()
+{
+    Q_D(AnchorsBase);
+
+    if (d->deferUpdate(AnchorsBasePrivate::VerticalFlag)) {
+        return;
+    }
+
+    AnchorsBasePrivate::PassScope pass(d);
+    if (!pass.accepted) {
+        return;
+    }
+
+    AnchorsUpdateScope scope(target(), AnchorsObserver::VerticalUpdate);
+    d->updateAxis(Qt::Vertical);
+}
+
+void AnchorsBase::updateHorizontal()
+{
+    Q_D(AnchorsBase);
+
+    if (d->deferUpdate(AnchorsBasePrivate::HorizontalFlag)) {
+        return;
+    }
+
+    AnchorsBasePrivate::PassScope pass(d);
+    if (!pass.accepted) {
+        return;
+    }
+
+    AnchorsUpdateScope scope(target(), AnchorsObserver::HorizontalUpdate);
+    d->updateAxis(Qt::Horizontal);
+}
+
+void AnchorsBase::updateFill()
+{
+    Q_D(AnchorsBase);
+
+    if (d->deferUpdate(AnchorsBasePrivate::FillFlag)) {
+        return;
+    }
+
+    AnchorsBasePrivate::PassScope pass(d);
+    if (!pass.accepted) {
+        return;
+    }
+
+    AnchorsUpdateScope scope(target(), AnchorsObserver::FillUpdate);
+
+    QRect rect = d->getWidgetRect(d->fill->target());
+    QRect geometry = target()->geometry();
+    AnchorsEngine::Axis axis = d->axisOf(geometry, Qt::Vertical);
+    axis.bound[0] = axis.bound[2] = true;
+    axis.values[0] = rect.top() + (d->settings->topMargin != 0 ? d->settings->topMargin : d->settings->margins);
+    axis.values[2] = rect.bottom() - (d->settings->bottomMargin != 0 ? d->settings->bottomMargin : d->settings->margins);
+    d->resolveAxis(axis);
+    d->setAxis(geometry, axis);
+
+    axis = d->axisOf(geometry, Qt::Horizontal);
+    axis.bound[0] = axis.bound[2] = true;
+    axis.values[0] = rect.left() + (d->settings->leftMargin != 0 ? d->settings->leftMargin : d->settings->margins);
+    axis.values[2] = rect.right() - (d->settings->rightMargin != 0 ? d->settings->rightMargin : d->settings->margins);
+    d->resolveAxis(axis);
+    d->setAxis(geometry, axis);
+
+    d->commitGeometry(geometry, Qt::AnchorTop);
+}
+
+void AnchorsBase::updateCenterIn()
+{
+    Q_D(AnchorsBase);
+
+    if (d->deferUpdate(AnchorsBasePrivate::CenterInFlag)) {
+        return;
+    }
+
+    AnchorsBasePrivate::PassScope pass(d);
+    if (!pass.accepted) {
+        return;
+    }
+
+    AnchorsUpdateScope scope(target(), AnchorsObserver::CenterInUpdate);
+
+    QRect rect = d->getWidgetRect(d->centerIn->target());
+    QRect geometry = target()->geometry();
+
+    // a centered widget keeps its width, the aspect ratio gives the height
+    if (d->settings->aspectRatio > 0) {
+        d->applyAspectRatio(geometry, Qt::Vertical);
+    }
+
+    AnchorsEngine::Axis axis = d->axisOf(geometry, Qt::Horizontal);
+    axis.bound[1] = true;
+    axis.values[1] = d->getValueByRect(rect, Qt::AnchorHorizontalCenter);
+    d->resolveAxis(axis);
+    d->setAxis(geometry, axis);
+
+    axis = d->axisOf(geometry, Qt::Vertical);
+    axis.bound[1] = true;
+    axis.values[1] = d->getValueByRect(rect, Qt::AnchorVerticalCenter);
+    d->resolveAxis(axis);
+    d->setAxis(geometry, axis);
+
+    d->commitGeometry(geometry, Qt::AnchorTop);
+}
+
+void AnchorsBase::updateBindings()
+{
+    Q_D(AnchorsBase);
+
+    ExtendWidget *source = qobject_cast<ExtendWidget *>(sender());
+
+    if (source) {
+        d->markStale(source->target());
+    }
+
+    if (d->deferUpdate(AnchorsBasePrivate::BindingFlag)) {
+        return;
+    }
+
+    // the expressions only run when something they read has changed, the
+    // axes only when one of their values did
+    int flags = d->evaluateBindings();
+
+    if (flags & AnchorsBasePrivate::VerticalFlag) {
+        updateVertical();
+    }
+    if (flags & AnchorsBasePrivate::HorizontalFlag) {
+        updateHorizontal();
+    }
+}
+
+AnchorsBase::AnchorsBase(AnchorsBasePrivate *dd):
+    QObject(dd->extendWidget->target()),
+    d_ptr(dd)
+{
+}
+
+void AnchorsBase::init(QWidget *w)
+{
+    Q_D(AnchorsBase);
+
+    anchorsTemplateRelease(w);
+
+    AnchorsBase *base = AnchorsBasePrivate::getWidgetAnchorsBase(w);
+
+    if (base) {
+        if (d && d->q_func() == this) {
+            delete d;
+        }
+
+        d_ptr = base->d_func();
+        d_ptr->handles << this;
+    } else if (d && d->q_func() == this) {
+        d->removeWidgetAnchorsBase(target(), this);
+        d->setWidgetAnchorsBase(w, this);
+        d->extendWidget->setTarget(w);
+    } else {
+        base = new (w) AnchorsBase(w, false);
+        d_ptr = base->d_func();
+        d_ptr->handles << this;
+    }
+}
+
+AnchorsBase::AnchorsBase(QWidget *w, bool):
+    QObject(w),
+    d_ptr(new (w) AnchorsBasePrivate(this, w))
+{
+    Q_D(AnchorsBase);
+
+    AnchorsBasePrivate::touchGraph(w);
+
+    d->reclaimable = true;
+    connect(d->extendWidget, SIGNAL(enabledChanged(bool)), SIGNAL(enabledChanged(bool)));
+    connect(d->fill, SIGNAL(sizeChanged(QSize)), SLOT(updateFill()));
+    connect(d->centerIn, SIGNAL(sizeChanged(QSize)), SLOT(updateCenterIn()));
+
+    d->setWidgetAnchorsBase(w, this);
+}
+
+class AnchorsTransactionPrivate
+{
+    explicit AnchorsTransactionPrivate(AnchorsTransaction *qq): q_ptr(qq) {}
+
+    struct Binding {
+        QPointer<AnchorsBase> base;
+        Qt::AnchorPoint point;
+    };
+
+    struct Expression {
+        AnchorsBase::BindingProperty property;
+        std::function<qreal()> expression;
+    };
+
+    struct Snapshot {
+        QPointer<AnchorsBase> base;
+        Binding bindings[6];
+        QList<Expression> expressions;
+        QHash<int, QString> variableNames;
+        QPointer<QWidget> fill;
+        QPointer<QWidget> centerIn;
+        int margins;
+        int topMargin;
+        int bottomMargin;
+        int leftMargin;
+        int rightMargin;
+        int horizontalCenterOffset;
+        int verticalCenterOffset;
+        bool alignWhenCentered;
+        qreal aspectRatio;
+    };
+
+    AnchorsTransactionPrivate *root()
+    {
+        return outer ? outer : this;
+    }
+
+    void record(AnchorsBasePrivate *d)
+    {
+        if (replaying || recorded.contains(d)) {
+            return;
+        }
+
+        Snapshot snapshot;
+
+        snapshot.base = d->q_func();
+        for (int i = 0; i < 6; ++i) {
+            const AnchorInfo *info = d->infos[i].targetInfo;
+
+            snapshot.bindings[i].base = info ? info->base : NULL;
+            snapshot.bindings[i].point = info ? info->type : Qt::AnchorTop;
+        }
+        foreach (const AnchorsBasePrivate::Binding &binding, d->bindings) {
+            Expression expression;
+
+            expression.property = binding.property;
+            expression.expression = binding.expression;
+            snapshot.expressions << expression;
+        }
+        snapshot.variableNames = d->variableNames;
+        snapshot.fill = d->fill->target();
+        snapshot.centerIn = d->centerIn->target();
+        snapshot.margins = d->settings->margins;
+        snapshot.topMargin = d->settings->topMargin;
+        snapshot.bottomMargin = d->settings->bottomMargin;
+        snapshot.leftMargin = d->settings->leftMargin;
+        snapshot.rightMargin = d->settings->rightMargin;
+        snapshot.horizontalCenterOffset = d->settings->horizontalCenterOffset;
+        snapshot.verticalCenterOffset = d->settings->verticalCenterOffset;
+        snapshot.alignWhenCentered = d->settings->alignWhenCentered;
+        snapshot.aspectRatio = d->settings->aspectRatio;
+
+        recorded.insert(d);
+        snapshots.append(snapshot);
+    }
+
+    void fail(AnchorsBase::AnchorError code, const QString &string)
+    {
+        if (replaying || errorCode != AnchorsBase::NoError) {
+            return;
+        }
+
+        errorCode = code;
+        errorString = string;
+    }
+
+    // walks the dependencies of one axis, a widget met again while it is
+    // still on the stack closes a loop
+    static bool findLoop(AnchorsBasePrivate *d, Qt::Orientation orientation,
+                         QHash<const AnchorsBasePrivate *, bool> &states)
+    {
+        QHash<const AnchorsBasePrivate *, bool>::const_iterator it = states.constFind(d);
+
+        if (it != states.constEnd()) {
+            return it.value();
+        }
+
+        states.insert(d, true);
+
+        AnchorsBasePrivate *list[AnchorsBasePrivate::MaxDependencies];
+        int count = d->dependencies(orientation, list);
+
+        for (int i = 0; i < count; ++i) {
+            if (findLoop(list[i], orientation, states)) {
+                return true;
+            }
+        }
+
+        states[d] = false;
+
+        return false;
+    }
+
+    bool validate()
+    {
+        QHash<const AnchorsBasePrivate *, bool> vertical;
+        QHash<const AnchorsBasePrivate *, bool> horizontal;
+
+        foreach (const Snapshot &snapshot, snapshots) {
+            if (!snapshot.base) {
+                continue;
+            }
+
+            AnchorsBasePrivate *d = snapshot.base->d_func();
+
+            if (findLoop(d, Qt::Vertical, vertical) || findLoop(d, Qt::Horizontal, horizontal)) {
+                d->setError(AnchorsBase::LoopBind, "loop bind.");
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void restore()
+    {
+        replaying = true;
+
+        // unbind everything first, so that restoring one widget never sees
+        // a half-restored neighbour as a conflict
+        foreach (const Snapshot &snapshot, snapshots) {
+            AnchorsBase *base = snapshot.base;
+
+            if (!base) {
+                continue;
+            }
+
+            const AnchorInfo *info = NULL;
+            base->setFill((QWidget *)NULL);
+            base->setCenterIn((QWidget *)NULL);
+            base->setTop(info);
+            base->setBottom(info);
+            base->setLeft(info);
+            base->setRight(info);
+            base->setHorizontalCenter(info);
+            base->setVerticalCenter(info);
+
+            AnchorsBasePrivate *d = base->d_func();
+
+            while (!d->bindings.isEmpty()) {
+                base->clearBinding(d->bindings.last().property);
+            }
+        }
+
+        foreach (const Snapshot &snapshot, snapshots) {
+            AnchorsBase *base = snapshot.base;
+
+            if (!base) {
+                continue;
+            }
+
+            for (int i = 0; i < 6; ++i) {
+                const Binding &binding = snapshot.bindings[i];
+
+                if (binding.base) {
+                    base->setAnchor(base->d_func()->infos[i].type, binding.base->target(), binding.point);
+                }
+            }
+            if (snapshot.fill) {
+                base->setFill(snapshot.fill.data());
+            }
+            if (snapshot.centerIn) {
+                base->setCenterIn(snapshot.centerIn.data());
+            }
+
+            base->setMargins(snapshot.margins);
+            base->setTopMargin(snapshot.topMargin);
+            base->setBottomMargin(snapshot.bottomMargin);
+            base->setLeftMargin(snapshot.leftMargin);
+            base->setRightMargin(snapshot.rightMargin);
+            base->setHorizontalCenterOffset(snapshot.horizontalCenterOffset);
+            base->setVerticalCenterOffset(snapshot.verticalCenterOffset);
+            base->setAlignWhenCentered(snapshot.alignWhenCentered);
+            base->setAspectRatio(snapshot.aspectRatio);
+
+            // the direct setters above dropped the links, a variable that is
+            // gone by now leaves the restored value in place
+            for (QHash<int, QString>::const_iterator it = snapshot.variableNames.constBegin();
+                 it != snapshot.variableNames.constEnd(); ++it) {
+                base->setMarginVariable(AnchorsBase::MarginProperty(it.key()), it.value());
+            }
+        }
+
+        // the expressions read the restored neighbours, so they go last
+        foreach (const Snapshot &snapshot, snapshots) {
+            AnchorsBase *base = snapshot.base;
+
+            if (!base) {
+                continue;
+            }
+
+            foreach (const Expression &expression, snapshot.expressions) {
+                base->setBinding(expression.property, expression.expression);
+            }
+        }
+
+        replaying = false;
+    }
+
+    void finish()
+    {
+        active = false;
+
+        if (!outer) {
+            AnchorsBasePrivate::transaction = NULL;
+            snapshots.clear();
+            recorded.clear();
+        }
+
+        // the single pass over everything the transaction left dirty
+        AnchorsBasePrivate::endDefer();
+    }
+
+    AnchorsTransactionPrivate *outer = NULL;
+    QList<Snapshot> snapshots;
+    QSet<const AnchorsBasePrivate *> recorded;
+    AnchorsBase::AnchorError errorCode = AnchorsBase::NoError;
+    QString errorString;
+    bool active = false;
+    bool aborted = false;
+    bool replaying = false;
+
+    AnchorsTransaction *q_ptr;
+
+    Q_DECLARE_PUBLIC(AnchorsTransaction)
+
+    friend class AnchorsBasePrivate;
+};
+
+void AnchorsBasePrivate::touch()
+{
+    touchGraph(extendWidget->target());
+
+    if (transaction) {
+        transaction->record(this);
+    }
+}
+
+void AnchorsBasePrivate::setError(AnchorsBase::AnchorError code, const QString &string)
+{
+    errorCode = code;
+    errorString = string;
+
+    if (transaction) {
+        transaction->fail(code, string);
+    }
+}
+
+bool AnchorsVariables::contains(const QString &name)
+{
+    return AnchorsBasePrivate::variables.contains(name);
+}
+
+int AnchorsVariables::value(const QString &name)
+{
+    return AnchorsBasePrivate::variables.value(name).value;
+}
+
+QStringList AnchorsVariables::names()
+{
+    return AnchorsBasePrivate::variables.keys();
+}
+
+int AnchorsVariables::dependentCount(const QString &name)
+{
+    return AnchorsBasePrivate::variables.value(name).dependents.size();
+}
+
+void AnchorsVariables::setValue(const QString &name, int value)
+{
+    QHash<QString, int> values;
+
+    values.insert(name, value);
+    setValues(values);
+}
+
+void AnchorsVariables::setValues(const QHash<QString, int> &values)
+{
+    // a whole density or scaling switch is laid out in a single pass
+    AnchorsBasePrivate::beginDefer();
+    for (QHash<QString, int>::const_iterator it = values.constBegin(); it != values.constEnd(); ++it) {
+        QHash<QString, AnchorsBasePrivate::Variable>::iterator variable = AnchorsBasePrivate::variables.find(it.key());
+
+        if (variable == AnchorsBasePrivate::variables.end()) {
+            AnchorsBasePrivate::Variable v;
+            v.value = it.value();
+            AnchorsBasePrivate::variables.insert(it.key(), v);
+        } else if (variable->value != it.value()) {
+            variable->value = it.value();
+            AnchorsBasePrivate::applyVariable(it.key(), *variable);
+        }
+    }
+    AnchorsBasePrivate::endDefer();
+}
+
+void AnchorsVariables::remove(const QString &name)
+{
+    AnchorsBasePrivate::Variable variable = AnchorsBasePrivate::variables.take(name);
+
+    // dependents keep the last value, like after clearMarginVariable()
+    foreach (AnchorsBasePrivate *d, variable.dependents) {
+        foreach (int property, d->variableNames.keys(name)) {
+            d->variableNames.remove(property);
+        }
+    }
+}
+
+class AnchorsTemplatePrivate : public QSharedData
+{
+public:
+    struct Anchor {
+        AnchorsTemplate::Target target = AnchorsTemplate::NoTarget;
+        Qt::AnchorPoint point = Qt::AnchorTop;
+    };
+
+    struct Siblings {
+        QWidget *previous = NULL;
+        QWidget *next = NULL;
+    };
+
+    // one walk over the children of a parent gives every child its
+    // neighbours, the previous widget is passed along
+    static void collectSiblings(const QWidget *parent, QHash<const QWidget *, Siblings> &siblings)
+    {
+        QWidget *previous = NULL;
+
+        foreach (QObject *child, parent->children()) {
+            if (!child->isWidgetType()) {
+                continue;
+            }
+
+            QWidget *w = static_cast<QWidget *>(child);
+
+            siblings[w].previous = previous;
+            if (previous) {
+                siblings[previous].next = w;
+            }
+            previous = w;
+        }
+    }
+
+    static Siblings siblingsOf(const QWidget *w)
+    {
+        QHash<const QWidget *, Siblings> siblings;
+
+        collectSiblings(w->parentWidget(), siblings);
+
+        return siblings.value(w);
+    }
+
+    // a missing sibling falls back to the parent's edge of the same name,
+    // so the first and the last item of a list line up with their parent
+    static QWidget *targetOf(QWidget *w, AnchorsTemplate::Target target, const Siblings &siblings)
+    {
+        switch (target) {
+        case AnchorsTemplate::PreviousTarget:
+            return siblings.previous;
+        case AnchorsTemplate::NextTarget:
+            return siblings.next;
+        default:
+            return w->parentWidget();
+        }
+    }
+
+    bool apply(QWidget *w, const Siblings &siblings) const;
+
+    // a template whose items only need its own state is laid out for all
+    // items of a parent at once; the aspect ratio and anchors to both
+    // neighbours on one axis need the full machinery per item
+    bool isShared() const
+    {
+        if (settings->aspectRatio > 0) {
+            return false;
+        }
+
+        static const Qt::AnchorPoint axes[2][3] = {
+            {Qt::AnchorTop, Qt::AnchorVerticalCenter, Qt::AnchorBottom},
+            {Qt::AnchorLeft, Qt::AnchorHorizontalCenter, Qt::AnchorRight}
+        };
+
+        for (int n = 0; n < 2; ++n) {
+            bool previous = false;
+            bool next = false;
+
+            for (int i = 0; i < 3; ++i) {
+                previous |= anchors[axes[n][i]].target == AnchorsTemplate::PreviousTarget;
+                next |= anchors[axes[n][i]].target == AnchorsTemplate::NextTarget;
+            }
+            if (previous && next) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool usesNext() const
+    {
+        for (int i = 0; i < 6; ++i) {
+            if (anchors[i].target == AnchorsTemplate::NextTarget) {
+                return true;
+            }
+        }
+
+        return fill == AnchorsTemplate::NextTarget || centerIn == AnchorsTemplate::NextTarget;
+    }
+
+    bool sizeAnchored(Qt::Orientation orientation) const
+    {
+        if (fill != AnchorsTemplate::NoTarget) {
+            return true;
+        }
+
+        bool vertical = orientation == Qt::Vertical;
+        int count = 0;
+
+        count += anchors[vertical ? Qt::AnchorTop : Qt::AnchorLeft].target != AnchorsTemplate::NoTarget;
+        count += anchors[vertical ? Qt::AnchorVerticalCenter : Qt::AnchorHorizontalCenter].target
+                 != AnchorsTemplate::NoTarget;
+        count += anchors[vertical ? Qt::AnchorBottom : Qt::AnchorRight].target != AnchorsTemplate::NoTarget;
+
+        return count >= 2;
+    }
+
+    // anchors, fill or bindings set on the widget itself
+    static bool hasOwnAnchors(const QWidget *w)
+    {
+        AnchorsBase *base = AnchorsBasePrivate::getWidgetAnchorsBase(w);
+
+        if (!base) {
+            return false;
+        }
+
+        AnchorsBasePrivate *d = base->d_func();
+
+        for (int i = 0; i < 6; ++i) {
+            if (d->infos[i].targetInfo) {
+                return true;
+            }
+        }
+
+        return d->fill->target() || d->centerIn->target() || !d->bindings.isEmpty();
+    }
+
+    // the point of the widget's rect the way getTargetValueByInfo() sees it
+    qreal valueOf(Qt::AnchorPoint point, const QRect &target, Qt::AnchorPoint targetPoint) const
+    {
+        const AnchorsMargins *m = settings.constData();
+        qreal value = AnchorsBasePrivate::getValueByRect(target, targetPoint);
+
+        switch (point) {
+        case Qt::AnchorTop:
+            return value + (m->topMargin == 0 ? m->margins : m->topMargin);
+        case Qt::AnchorBottom:
+            return value - (m->bottomMargin == 0 ? m->margins : m->bottomMargin) - 1;
+        case Qt::AnchorHorizontalCenter:
+            return value + m->horizontalCenterOffset;
+        case Qt::AnchorLeft:
+            return value + (m->leftMargin == 0 ? m->margins : m->leftMargin);
+        case Qt::AnchorRight:
+            return value - (m->rightMargin == 0 ? m->margins : m->rightMargin) - 1;
+        case Qt::AnchorVerticalCenter:
+            return value + m->verticalCenterOffset;
+        default:
+            return 0;
+        }
+    }
+
+    void place(QWidget *w, const Siblings &siblings) const;
+
+    // the anchor points of Qt::AnchorPoint in their enum order
+    Anchor anchors[6];
+    AnchorsTemplate::Target fill = AnchorsTemplate::NoTarget;
+    AnchorsTemplate::Target centerIn = AnchorsTemplate::NoTarget;
+    QExplicitlySharedDataPointer<AnchorsMargins> settings = AnchorsBasePrivate::defaultSettings();
+};
+
+AnchorsTemplate::AnchorsTemplate():
+    d_ptr(new AnchorsTemplatePrivate)
+{
+}
+
+AnchorsTemplate::AnchorsTemplate(const AnchorsTemplate &other):
+    d_ptr(other.d_ptr)
+{
+}
+
+AnchorsTemplate::~AnchorsTemplate()
+{
+}
+
+AnchorsTemplate &AnchorsTemplate::operator=(const AnchorsTemplate &other)
+{
+    d_ptr = other.d_ptr;
+
+    return *this;
+}
+
+AnchorsTemplate::Target AnchorsTemplate::anchorTarget(Qt::AnchorPoint point) const
+{
+    Q_D(const AnchorsTemplate);
+
+    return d->anchors[point].target;
+}
+
+Qt::AnchorPoint AnchorsTemplate::anchorTargetPoint(Qt::AnchorPoint point) const
+{
+    Q_D(const AnchorsTemplate);
+
+    return d->anchors[point].point;
+}
+
+AnchorsTemplate::Target AnchorsTemplate::fill() const
+{
+    Q_D(const AnchorsTemplate);
+
+    return d->fill;
+}
+
+AnchorsTemplate::Target AnchorsTemplate::centerIn() const
+{
+    Q_D(const AnchorsTemplate);
+
+    return d->centerIn;
+}
+
+int AnchorsTemplate::margin(AnchorsBase::MarginProperty property) const
+{
+    Q_D(const AnchorsTemplate);
+
+    const AnchorsMargins *settings = d->settings.constData();
+
+    switch (property) {
+    case AnchorsBase::MarginsProperty:
+        return settings->margins;
+    case AnchorsBase::TopMarginProperty:
+        return settings->topMargin;
+    case AnchorsBase::BottomMarginProperty:
+        return settings->bottomMargin;
+    case AnchorsBase::LeftMarginProperty:
+        return settings->leftMargin;
+    case AnchorsBase::RightMarginProperty:
+        return settings->rightMargin;
+    case AnchorsBase::HorizontalCenterOffsetProperty:
+        return settings->horizontalCenterOffset;
+    case AnchorsBase::VerticalCenterOffsetProperty:
+        return settings->verticalCenterOffset;
+    }
+
+    return 0;
+}
+
+bool AnchorsTemplate::alignWhenCentered() const
+{
+    Q_D(const AnchorsTemplate);
+
+    return d->settings->alignWhenCentered;
+}
+
+qreal AnchorsTemplate::aspectRatio() const
+{
+    Q_D(const AnchorsTemplate);
+
+    return d->settings->aspectRatio;
+}
+
+// every setter works on a private copy, widgets the template was applied to
+// keep what they were given
+AnchorsTemplate &AnchorsTemplate::setAnchor(Qt::AnchorPoint point, Target target, Qt::AnchorPoint targetPoint)
+{
+    d_ptr.detach();
+
+    Q_D(AnchorsTemplate);
+
+    d->anchors[point].target = target;
+    d->anchors[point].point = targetPoint;
+
+    if (target != NoTarget) {
+        d->fill = NoTarget;
+        d->centerIn = NoTarget;
+    }
+
+    return *this;
+}
+
+AnchorsTemplate &AnchorsTemplate::setFill(Target target)
+{
+    d_ptr.detach();
+
+    Q_D(AnchorsTemplate);
+
+    d->fill = target;
+
+    if (target != NoTarget) {
+        d->centerIn = NoTarget;
+        for (int i = 0; i < 6; ++i) {
+            d->anchors[i].target = NoTarget;
+        }
+    }
+
+    return *this;
+}
+
+AnchorsTemplate &AnchorsTemplate::setCenterIn(Target target)
+{
+    d_ptr.detach();
+
+    Q_D(AnchorsTemplate);
+
+    d->centerIn = target;
+
+    if (target != NoTarget) {
+        d->fill = NoTarget;
+        for (int i = 0; i < 6; ++i) {
+            d->anchors[i].target = NoTarget;
+        }
+    }
+
+    return *this;
+}
+
+AnchorsTemplate &AnchorsTemplate::setMargin(AnchorsBase::MarginProperty property, int value)
+{
+    d_ptr.detach();
+
+    Q_D(AnchorsTemplate);
+
+    d->settings.detach();
+
+    switch (property) {
+    case AnchorsBase::MarginsProperty:
+        d->settings->margins = value;
+        break;
+    case AnchorsBase::TopMarginProperty:
+        d->settings->topMargin = value;
+        break;
+    case AnchorsBase::BottomMarginProperty:
+        d->settings->bottomMargin = value;
+        break;
+    case AnchorsBase::LeftMarginProperty:
+        d->settings->leftMargin = value;
+        break;
+    case AnchorsBase::RightMarginProperty:
+        d->settings->rightMargin = value;
+        break;
+    case AnchorsBase::HorizontalCenterOffsetProperty:
+        d->settings->horizontalCenterOffset = value;
+        break;
+    case AnchorsBase::VerticalCenterOffsetProperty:
+        d->settings->verticalCenterOffset = value;
+        break;
+    }
+
+    return *this;
+}
+
+AnchorsTemplate &AnchorsTemplate::setAlignWhenCentered(bool alignWhenCentered)
+{
+    d_ptr.detach();
+
+    Q_D(AnchorsTemplate);
+
+    d->settings.detach();
+    d->settings->alignWhenCentered = alignWhenCentered;
+
+    return *this;
+}
+
+AnchorsTemplate &AnchorsTemplate::setAspectRatio(qreal aspectRatio)
+{
+    d_ptr.detach();
+
+    Q_D(AnchorsTemplate);
+
+    d->settings.detach();
+    d->settings->aspectRatio = qMax(qreal(0), aspectRatio);
+
+    return *this;
+}
+
+bool AnchorsTemplatePrivate::apply(QWidget *w, const Siblings &siblings) const
+{
+    AnchorsBase *base = AnchorsBasePrivate::implicitAnchorsBase(w);
+    AnchorsBasePrivate *bd = base->d_func();
+
+    // the settings are shared by reference, the widget only gets its own
+    // copy once one of them is overridden
+    bd->touch();
+    bd->shareSettings(settings);
+
+    if (fill != AnchorsTemplate::NoTarget) {
+        QWidget *target = targetOf(w, fill, siblings);
+
+        if (!base->setFill(target ? target : w->parentWidget())) {
+            return false;
+        }
+        base->updateFill();
+
+        return true;
+    }
+
+    if (centerIn != AnchorsTemplate::NoTarget) {
+        QWidget *target = targetOf(w, centerIn, siblings);
+
+        if (!base->setCenterIn(target ? target : w->parentWidget())) {
+            return false;
+        }
+        base->updateCenterIn();
+
+        return true;
+    }
+
+    for (int i = 0; i < 6; ++i) {
+        const Anchor &anchor = anchors[i];
+
+        if (anchor.target == AnchorsTemplate::NoTarget) {
+            continue;
+        }
+
+        Qt::AnchorPoint point = Qt::AnchorPoint(i);
+        QWidget *target = targetOf(w, anchor.target, siblings);
+
+        if (!target) {
+            if (!base->setAnchor(point, w->parentWidget(), point)) {
+                return false;
+            }
+        } else if (!base->setAnchor(point, target, anchor.point)) {
+            return false;
+        }
+    }
+
+    // anchors that were already in place still have to pick up new margins
+    base->updateVertical();
+    base->updateHorizontal();
+
+    return true;
+}
+
+// the same arithmetic as the anchors of a single widget, read straight from
+// the template, so that an item needs nothing of its own
+void AnchorsTemplatePrivate::place(QWidget *w, const Siblings &siblings) const
+{
+    static const Qt::AnchorPoint axes[2][3] = {
+        {Qt::AnchorTop, Qt::AnchorVerticalCenter, Qt::AnchorBottom},
+        {Qt::AnchorLeft, Qt::AnchorHorizontalCenter, Qt::AnchorRight}
+    };
+
+    QWidget *parent = w->parentWidget();
+    const AnchorsMargins *m = settings.constData();
+    AnchorsEngine *engine = AnchorsEngine::engine(w);
+    QRect rect = w->geometry();
+    Qt::AnchorPoint fixed[2] = {Qt::AnchorTop, Qt::AnchorLeft};
+
+    for (int n = 0; n < 2; ++n) {
+        bool vertical = n == 0;
+        AnchorsEngine::Axis axis;
+
+        axis.orientation = vertical ? Qt::Vertical : Qt::Horizontal;
+        axis.start = vertical ? rect.top() : rect.left();
+        axis.size = vertical ? rect.height() : rect.width();
+        axis.alignWhenCentered = m->alignWhenCentered;
+        for (int i = 0; i < 3; ++i) {
+            axis.bound[i] = false;
+            axis.values[i] = 0;
+        }
+
+        if (fill != AnchorsTemplate::NoTarget || centerIn != AnchorsTemplate::NoTarget) {
+            QWidget *target = targetOf(w, fill != AnchorsTemplate::NoTarget ? fill : centerIn, siblings);
+            QRect area = !target || target == parent ? parent->rect() : target->geometry();
+
+            if (fill != AnchorsTemplate::NoTarget) {
+                axis.bound[0] = axis.bound[2] = true;
+                axis.values[0] = vertical ? area.top() + (m->topMargin != 0 ? m->topMargin : m->margins)
+                                 : area.left() + (m->leftMargin != 0 ? m->leftMargin : m->margins);
+                axis.values[2] = vertical ? area.bottom() - (m->bottomMargin != 0 ? m->bottomMargin : m->margins)
+                                 : area.right() - (m->rightMargin != 0 ? m->rightMargin : m->margins);
+            } else {
+                axis.bound[1] = true;
+                axis.values[1] = AnchorsBasePrivate::getValueByRect(area, axes[n][1]);
+            }
+
+            engine->resolve(axis);
+            AnchorsBasePrivate::setAxis(rect, axis);
+            continue;
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            const Anchor &anchor = anchors[axes[n][i]];
+
+            if (anchor.target == AnchorsTemplate::NoTarget) {
+                continue;
+            }
+
+            // a missing sibling stands for the parent's edge of the same name
+            QWidget *target = targetOf(w, anchor.target, siblings);
+            Qt::AnchorPoint point = target ? anchor.point : axes[n][i];
+
+            axis.bound[i] = true;
+            axis.values[i] = valueOf(axes[n][i], !target || target == parent ? parent->rect() : target->geometry(),
+                                     point);
+        }
+
+        int index = engine->resolve(axis);
+
+        AnchorsBasePrivate::setAxis(rect, axis);
+        fixed[n] = axes[n][qMax(0, index)];
+    }
+
+    AnchorsBasePrivate::boundSize(rect, w, fixed[0], fixed[1]);
+
+    if (rect != w->geometry()) {
+        NOTIFY_OBSERVERS(geometryAboutToBeCommitted(w, rect))
+        w->setGeometry(rect);
+        NOTIFY_OBSERVERS(geometryCommitted(w, rect))
+    }
+}
+
+// the items of one parent that follow one template: the group watches the
+// parent and its widgets and lays the items out in child order, previous
+// neighbours first, or next ones first when the template points that way
+class AnchorsTemplateGroup : public QObject
+{
+public:
+    static AnchorsTemplateGroup *join(QWidget *w, const QExplicitlySharedDataPointer<AnchorsTemplatePrivate> &d)
+    {
+        QWidget *parent = w->parentWidget();
+        AnchorsTemplateGroup *group = NULL;
+
+        leave(w);
+
+        foreach (QObject *child, parent->children()) {
+            AnchorsTemplateGroup *other = child->isWidgetType() ? groups.value(static_cast<QWidget *>(child), NULL)
+                                          : NULL;
+
+            if (other && other->d == d) {
+                group = other;
+                break;
+            }
+        }
+
+        if (!group) {
+            group = new AnchorsTemplateGroup(parent, d);
+        }
+
+        groups.insert(w, group);
+        ++group->count;
+        w->installEventFilter(group);
+
+        return group;
+    }
+
+    static void leave(const QWidget *w)
+    {
+        AnchorsTemplateGroup *group = groups.take(w);
+
+        if (group && --group->count == 0) {
+            group->deleteLater();
+        }
+    }
+
+    static void leaveWindow(const QWidget *window)
+    {
+        QList<const QWidget *> list;
+
+        for (QHash<const QWidget *, AnchorsTemplateGroup *>::const_iterator it = groups.constBegin();
+             it != groups.constEnd(); ++it) {
+            if (it.key()->window() == window) {
+                list << it.key();
+            }
+        }
+
+        foreach (const QWidget *w, list) {
+            leave(w);
+        }
+    }
+
+    // the item gets an anchors object with the template's anchors, which
+    // the caller is about to override
+    static void release(QWidget *w)
+    {
+        AnchorsTemplateGroup *group = groups.value(w, NULL);
+
+        if (!group) {
+            return;
+        }
+
+        QExplicitlySharedDataPointer<AnchorsTemplatePrivate> d = group->d;
+
+        leave(w);
+        d->apply(w, AnchorsTemplatePrivate::siblingsOf(w));
+    }
+
+    static const AnchorsTemplatePrivate *templateOf(const QWidget *w)
+    {
+        AnchorsTemplateGroup *group = groups.value(w, NULL);
+
+        return group ? group->d.data() : NULL;
+    }
+
+    void layout()
+    {
+        if (layingOut || !count) {
+            return;
+        }
+
+        layingOut = true;
+
+        const QObjectList &children = parent()->children();
+        bool backwards = d->usesNext();
+        int size = children.size();
+
+        for (int k = 0; k < size; ++k) {
+            int i = backwards ? size - 1 - k : k;
+            QObject *child = children.at(i);
+
+            if (!child->isWidgetType() || groups.value(static_cast<QWidget *>(child), NULL) != this) {
+                continue;
+            }
+
+            AnchorsTemplatePrivate::Siblings siblings;
+
+            for (int j = i - 1; j >= 0 && !siblings.previous; --j) {
+                if (children.at(j)->isWidgetType()) {
+                    siblings.previous = static_cast<QWidget *>(children.at(j));
+                }
+            }
+            for (int j = i + 1; j < size && !siblings.next; ++j) {
+                if (children.at(j)->isWidgetType()) {
+                    siblings.next = static_cast<QWidget *>(children.at(j));
+                }
+            }
+
+            d->place(static_cast<QWidget *>(child), siblings);
+        }
+
+        layingOut = false;
+    }
+
+protected:
+    bool eventFilter(QObject *o, QEvent *e) Q_DECL_OVERRIDE
+    {
+        switch (e->type()) {
+        case QEvent::Resize:
+            layout();
+            break;
+        case QEvent::Move:
+            // the items are placed in the parent's coordinates
+            if (o != parent()) {
+                layout();
+            }
+            break;
+        case QEvent::ChildAdded:
+        case QEvent::ChildRemoved:
+            if (o == parent()) {
+                QObject *child = static_cast<QChildEvent *>(e)->child();
+
+                if (!child->isWidgetType()) {
+                    break;
+                }
+
+                // a new widget may be the neighbour an item follows
+                if (e->type() == QEvent::ChildAdded) {
+                    child->installEventFilter(this);
+                } else if (groups.value(static_cast<QWidget *>(child), NULL) == this) {
+                    leave(static_cast<QWidget *>(child));
+                }
+                layout();
+            }
+            break;
+        default:
+            break;
+        }
+
+        return false;
+    }
+
+private:
+    AnchorsTemplateGroup(QWidget *parent, const QExplicitlySharedDataPointer<AnchorsTemplatePrivate> &dd):
+        QObject(parent),
+        d(dd)
+    {
+        parent->installEventFilter(this);
+        foreach (QObject *child, parent->children()) {
+            if (child->isWidgetType()) {
+                child->installEventFilter(this);
+            }
+        }
+    }
+
+    ~AnchorsTemplateGroup()
+    {
+        QHash<const QWidget *, AnchorsTemplateGroup *>::iterator it = groups.begin();
+
+        while (it != groups.end()) {
+            if (it.value() == this) {
+                it = groups.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    QExplicitlySharedDataPointer<AnchorsTemplatePrivate> d;
+    int count = 0;
+    bool layingOut = false;
+
+    static QHash<const QWidget *, AnchorsTemplateGroup *> groups;
+};
+
+QHash<const QWidget *, AnchorsTemplateGroup *> AnchorsTemplateGroup::groups;
+
+static void anchorsTemplateRelease(QWidget *w)
+{
+    AnchorsTemplateGroup::release(w);
+}
+
+static void anchorsTemplateDrop(const QWidget *w)
+{
+    AnchorsTemplateGroup::leave(w);
+}
+
+static void anchorsTemplateDropWindow(const QWidget *window)
+{
+    AnchorsTemplateGroup::leaveWindow(window);
+}
+
+static bool anchorsTemplateSizeAnchored(const QWidget *w, Qt::Orientation orientation)
+{
+    const AnchorsTemplatePrivate *d = AnchorsTemplateGroup::templateOf(w);
+
+    return d && d->sizeAnchored(orientation);
+}
+
+bool AnchorsTemplate::apply(QWidget *w) const
+{
+    Q_D(const AnchorsTemplate);
+
+    if (!w || !w->parentWidget()) {
+        return false;
+    }
+
+    if (d->isShared() && !AnchorsTemplatePrivate::hasOwnAnchors(w)) {
+        AnchorsTemplateGroup::join(w, d_ptr)->layout();
+        return true;
+    }
+
+    AnchorsTemplateGroup::leave(w);
+
+    return d->apply(w, AnchorsTemplatePrivate::siblingsOf(w));
+}
+
+bool AnchorsTemplate::apply(const QList<QWidget *> &widgets) const
+{
+    // a transaction skips the per-anchor loop probes and lays out every
+    // item in a single pass once all of them are bound
+    Q_D(const AnchorsTemplate);
+
+    AnchorsTransaction transaction;
+    QHash<const QWidget *, AnchorsTemplatePrivate::Siblings> siblings;
+    QList<QWidget *> joined;
+    QList<AnchorsTemplateGroup *> groups;
+    bool shared = d->isShared();
+    bool ok = true;
+
+    foreach (QWidget *w, widgets) {
+        QWidget *parent = w ? w->parentWidget() : NULL;
+
+        if (!parent) {
+            ok = false;
+            break;
+        }
+
+        // items without anchors of their own are laid out by the template
+        if (shared && !AnchorsTemplatePrivate::hasOwnAnchors(w)) {
+            AnchorsTemplateGroup *group = AnchorsTemplateGroup::join(w, d_ptr);
+
+            if (!groups.contains(group)) {
+                groups << group;
+            }
+            joined << w;
+            continue;
+        }
+
+        AnchorsTemplateGroup::leave(w);
+
+        // the neighbours of all items of a parent come from a single walk
+        if (!siblings.contains(w)) {
+            AnchorsTemplatePrivate::collectSiblings(parent, siblings);
+        }
+
+        if (!d->apply(w, siblings.value(w))) {
+            ok = false;
+            break;
+        }
+    }
+
+    if (!ok) {
+        foreach (QWidget *w, joined) {
+            AnchorsTemplateGroup::leave(w);
+        }
+        transaction.rollback();
+        return false;
+    }
+
+    foreach (AnchorsTemplateGroup *group, groups) {
+        group->layout();
+    }
+
+    return transaction.commit();
+}
+
+AnchorsTransaction::AnchorsTransaction():
+    d_ptr(new AnchorsTransactionPrivate(this))
+{
+    Q_D(AnchorsTransaction);
+
+    // a nested transaction joins the outermost one, which owns validation
+    d->outer = AnchorsBasePrivate::transaction;
+    if (!d->outer) {
+        AnchorsBasePrivate::transaction = d;
+    }
+
+    d->active = true;
+    AnchorsBasePrivate::beginDefer();
+}
+
+AnchorsTransaction::~AnchorsTransaction()
+{
+    Q_D(AnchorsTransaction);
+
+    if (d->active) {
+        commit();
+    }
+
+    delete d_ptr;
+}
+
+bool AnchorsTransaction::isActive() const
+{
+    Q_D(const AnchorsTransaction);
+
+    return d->active;
+}
+
+AnchorsBase::AnchorError AnchorsTransaction::errorCode() const
+{
+    Q_D(const AnchorsTransaction);
+
+    return d->outer ? d->outer->errorCode : d->errorCode;
+}
+
+QString AnchorsTransaction::errorString() const
+{
+    Q_D(const AnchorsTransaction);
+
+    return d->outer ? d->outer->errorString : d->errorString;
+}
+
+bool AnchorsTransaction::commit()
+{
+    Q_D(AnchorsTransaction);
+
+    AnchorsTransactionPrivate *root = d->root();
+
+    if (!d->active) {
+        return root->errorCode == AnchorsBase::NoError && !root->aborted;
+    }
+
+    bool ok = root->errorCode == AnchorsBase::NoError && !root->aborted;
+
+    if (!d->outer) {
+        ok = ok && d->validate();
+
+        if (!ok) {
+            d->restore();
+        }
+    }
+
+    d->finish();
+
+    return ok;
+}
+
+void AnchorsTransaction::rollback()
+{
+    Q_D(AnchorsTransaction);
+
+    if (!d->active) {
+        return;
+    }
+
+    if (d->outer) {
+        d->outer->aborted = true;
+    } else {
+        d->restore();
+    }
+
+    d->finish();
+}
+
+class AnchorsLayoutCachePrivate
+{
+    explicit AnchorsLayoutCachePrivate(AnchorsLayoutCache *qq): q_ptr(qq) {}
+
+    struct Entry {
+        QSize size;
+        QVector<QRect> geometries;
+    };
+
+    // entries are only valid for the anchor graph they were taken from
+    void sync()
+    {
+        quint32 current = AnchorsBasePrivate::graphVersion(root);
+
+        if (version == current) {
+            return;
+        }
+
+        version = current;
+        entries.clear();
+        widgets.clear();
+        cacheable = true;
+
+        foreach (AnchorsBase *base, AnchorsBasePrivate::widgetMap) {
+            if (root->isAncestorOf(base->target())) {
+                widgets << base->target();
+
+                // expressions may read state the cache knows nothing about
+                if (!base->d_func()->bindings.isEmpty()) {
+                    cacheable = false;
+                }
+            }
+        }
+    }
+
+    int indexOf(const QSize &size) const
+    {
+        for (int i = 0; i < entries.size(); ++i) {
+            if (entries.at(i).size == size) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    void store(const QSize &size)
+    {
+        int index = indexOf(size);
+
+        if (index >= 0) {
+            entries.move(index, 0);
+            return;
+        }
+
+        Entry entry;
+        entry.size = size;
+        entry.geometries.reserve(widgets.size());
+        foreach (const QPointer<QWidget> &w, widgets) {
+            entry.geometries << (w ? w->geometry() : QRect());
+        }
+
+        entries.prepend(entry);
+        while (entries.size() > capacity) {
+            entries.removeLast();
+        }
+    }
+
+    bool apply(const Entry &entry)
+    {
+        // a widget that went away or lost its anchors since the entry was
+        // taken makes it a miss, the regular cascade handles the change
+        QVarLengthArray<AnchorsBasePrivate *, 256> privates(widgets.size());
+        QVarLengthArray<bool, 256> was_dirty(widgets.size());
+
+        for (int i = 0; i < widgets.size(); ++i) {
+            AnchorsBase *base = widgets.at(i) ? AnchorsBasePrivate::getWidgetAnchorsBase(widgets.at(i)) : NULL;
+
+            if (!base) {
+                return false;
+            }
+
+            privates[i] = base->d_func();
+            was_dirty[i] = privates[i]->dirty;
+        }
 
-    ExtendWidget *extendWidget = NULL;
-    AnchorInfo *top = new AnchorInfo(q_ptr, Qt::AnchorTop);
-    AnchorInfo *bottom = new AnchorInfo(q_ptr, Qt::AnchorBottom);
-    AnchorInfo *left = new AnchorInfo(q_ptr, Qt::AnchorLeft);
-    AnchorInfo *right = new AnchorInfo(q_ptr, Qt::AnchorRight);
-    AnchorInfo *horizontalCenter = new AnchorInfo(q_ptr, Qt::AnchorHorizontalCenter);
-    AnchorInfo *verticalCenter = new AnchorInfo(q_ptr, Qt::AnchorVerticalCenter);
-    ExtendWidget *fill = new ExtendWidget(NULL, q_ptr);
-    ExtendWidget *centerIn = new ExtendWidget(NULL, q_ptr);
-    int margins = 0;
-    int topMargin = 0;
-    int bottomMargin = 0;
-    int leftMargin = 0;
-    int rightMargin = 0;
-    int horizontalCenterOffset = 0;
-    int verticalCenterOffset = 0;
-    bool alignWhenCentered = false;
-    AnchorsBase::AnchorError errorCode = AnchorsBase::NoError;
-    QString errorString;
-    static QMap<const QWidget *, AnchorsBase *> widgetMap;
+        AnchorsBasePrivate::beginDefer();
+        AnchorsBasePrivate::beginPass();
 
-    Q_DECLARE_PUBLIC(AnchorsBase)
+        // the replay is a pass like any other, observers and repaint
+        // coalescing see every geometry it commits
+        for (int i = 0; i < widgets.size(); ++i) {
+            privates[i]->commitGeometry(entry.geometries.at(i), Qt::AnchorTop);
+        }
+
+        // every widget already sits where the cascade would put it
+        for (int i = 0; i < widgets.size(); ++i) {
+            if (!was_dirty[i]) {
+                privates[i]->takeDirty();
+            }
+        }
+
+        AnchorsBasePrivate::endPass();
+        AnchorsBasePrivate::endDefer();
+
+        return true;
+    }
+
+    // the geometry reached for the old size is taken when the root leaves
+    // it, so that immediate cascades and deferred layout passes both settled
+    bool resize(const QResizeEvent *e)
+    {
+        if (e == lastEvent && e->size() == lastSize) {
+            return lastHit;
+        }
+
+        lastEvent = e;
+        lastSize = e->size();
+        lastHit = false;
+
+        if (AnchorsBasePrivate::deferDepth > 0 || AnchorsBasePrivate::passDepth > 0) {
+            settledVersion = 0;
+            return false;
+        }
+
+        bool settled = settledVersion && settledVersion == AnchorsBasePrivate::graphVersion(root);
+
+        sync();
+
+        if (!cacheable) {
+            ++misses;
+            return false;
+        }
+
+        if (settled && e->oldSize().isValid()) {
+            store(e->oldSize());
+        }
+
+        int index = indexOf(e->size());
+
+        if (index >= 0 && apply(entries.at(index))) {
+            entries.move(index, 0);
+            lastHit = true;
+            ++hits;
+        } else {
+            ++misses;
+        }
+
+        settledVersion = AnchorsBasePrivate::graphVersion(root);
+
+        return lastHit;
+    }
+
+    QWidget *root = NULL;
+    QList<QPointer<QWidget> > widgets;
+    QList<Entry> entries;
+    quint32 version = 0;
+    quint32 settledVersion = 0;
+    bool cacheable = true;
+    int capacity = 8;
+    int hits = 0;
+    int misses = 0;
+    const QResizeEvent *lastEvent = NULL;
+    QSize lastSize;
+    bool lastHit = false;
+
+    AnchorsLayoutCache *q_ptr;
+
+    Q_DECLARE_PUBLIC(AnchorsLayoutCache)
+
+    friend bool anchorsCacheResize(AnchorsLayoutCachePrivate *cache, const QResizeEvent *e);
 };
 
-QMap<const QWidget *, AnchorsBase *> AnchorsBasePrivate::widgetMap;
+static bool anchorsCacheResize(AnchorsLayoutCachePrivate *cache, const QResizeEvent *e)
+{
+    return cache->resize(e);
+}
 
-AnchorsBase::AnchorsBase(QWidget *w):
-    QObject(w)
+// geometry changes that don't come from an anchor pass make cached
+// layouts stale just like anchor changes do
+static void anchorsGeometryChanged(const QWidget *w)
 {
-    init(w);
+    if (AnchorsBasePrivate::passDepth == 0) {
+        AnchorsBasePrivate::touchGraph(w);
+    }
 }
 
-AnchorsBase::~AnchorsBase()
+static void anchorsWindowGone(const QWidget *window)
 {
-    Q_D(AnchorsBase);
+    AnchorsBasePrivate::graphVersions.remove(window);
+}
 
-    d->removeWidgetAnchorsBase(target(), this);
-    if (d->q_func() == this) {
-        delete d;
+AnchorsLayoutCache::AnchorsLayoutCache(QWidget *root):
+    QObject(root),
+    d_ptr(new AnchorsLayoutCachePrivate(this))
+{
+    Q_D(AnchorsLayoutCache);
+
+    d->root = root;
+
+    if (root) {
+        // the root's resize events reach the cache through its anchors
+        AnchorsBasePrivate::implicitAnchorsBase(root);
+        anchorsLayoutCaches[root] = d;
     }
 }
 
-QWidget *AnchorsBase::target() const
+AnchorsLayoutCache::~AnchorsLayoutCache()
 {
-    Q_D(const AnchorsBase);
+    Q_D(AnchorsLayoutCache);
 
-    return d->extendWidget->target();
+    if (anchorsLayoutCaches.value(d->root, NULL) == d) {
+        anchorsLayoutCaches.remove(d->root);
+    }
+
+    delete d_ptr;
 }
 
-bool AnchorsBase::enabled() const
+QWidget *AnchorsLayoutCache::root() const
 {
-    Q_D(const AnchorsBase);
+    Q_D(const AnchorsLayoutCache);
 
-    return d->extendWidget->enabled();
+    return d->root;
 }
 
-const AnchorsBase *AnchorsBase::anchors() const
+int AnchorsLayoutCache::capacity() const
 {
-    return this;
+    Q_D(const AnchorsLayoutCache);
+
+    return d->capacity;
 }
 
-const AnchorInfo *AnchorsBase::top() const
+int AnchorsLayoutCache::count() const
 {
-    Q_D(const AnchorsBase);
+    Q_D(const AnchorsLayoutCache);
 
-    return d->top;
+    return d->entries.size();
 }
 
-const AnchorInfo *AnchorsBase::bottom() const
+int AnchorsLayoutCache::hits() const
 {
-    Q_D(const AnchorsBase);
+    Q_D(const AnchorsLayoutCache);
 
-    return d->bottom;
+    return d->hits;
 }
 
-const AnchorInfo *AnchorsBase::left() const
+int AnchorsLayoutCache::misses() const
 {
-    Q_D(const AnchorsBase);
+    Q_D(const AnchorsLayoutCache);
 
-    return d->left;
+    return d->misses;
 }
 
-const AnchorInfo *AnchorsBase::right() const
+void AnchorsLayoutCache::setCapacity(int capacity)
 {
-    Q_D(const AnchorsBase);
+    Q_D(AnchorsLayoutCache);
 
-    return d->right;
+    d->capacity = qMax(0, capacity);
+    while (d->entries.size() > d->capacity) {
+        d->entries.removeLast();
+    }
 }
 
-const AnchorInfo *AnchorsBase::horizontalCenter() const
+void AnchorsLayoutCache::invalidate()
 {
-    Q_D(const AnchorsBase);
+    Q_D(AnchorsLayoutCache);
+
+    d->entries.clear();
+    d->settledVersion = 0;
+}
+
+// owns the parked work of windows that aren't active; it is a plain QObject
+// only for its event filter and idle timer
+class AnchorsSchedulerPrivate : public QObject
+{
+public:
+    ~AnchorsSchedulerPrivate()
+    {
+        foreach (const QWidget *window, priorities.keys()) {
+            untrack(window);
+        }
+    }
+
+    static AnchorsScheduler::Priority priorityOf(const QWidget *window)
+    {
+        if (!window->isVisible() || window->isMinimized()) {
+            return AnchorsScheduler::Suspended;
+        }
+
+        // occluded windows aren't exposed on platforms that report it
+        QWindow *handle = window->windowHandle();
+        if (handle && !handle->isExposed()) {
+            return AnchorsScheduler::Suspended;
+        }
+
+        return window->isActiveWindow() ? AnchorsScheduler::Immediate : AnchorsScheduler::Idle;
+    }
+
+    AnchorsScheduler::Priority priority(const QWidget *window)
+    {
+        if (!priorities.contains(window)) {
+            track(window);
+        }
+
+        return priorities.value(window);
+    }
+
+    void track(const QWidget *window)
+    {
+        QWidget *w = const_cast<QWidget *>(window);
+
+        priorities[window] = priorityOf(window);
+        w->installEventFilter(this);
+        if (w->windowHandle()) {
+            w->windowHandle()->installEventFilter(this);
+        }
+
+        connect(w, &QObject::destroyed, this, [this, window]() {
+            priorities.remove(window);
+            queues.remove(window);
+        });
+    }
+
+    void untrack(const QWidget *window)
+    {
+        QWidget *w = const_cast<QWidget *>(window);
+
+        w->removeEventFilter(this);
+        if (w->windowHandle()) {
+            w->windowHandle()->removeEventFilter(this);
+        }
+        disconnect(w, 0, this, 0);
+    }
+
+    bool park(AnchorsBasePrivate *d, int flag)
+    {
+        const QWidget *window = d->extendWidget->target()->window();
+        AnchorsScheduler::Priority p = priority(window);
+
+        if (p == AnchorsScheduler::Immediate) {
+            return false;
+        }
+
+        if (!d->parked) {
+            queues[window] << d;
+        }
+        d->parked |= flag;
+
+        if (p == AnchorsScheduler::Idle && !timer.isActive()) {
+            timer.start(0, this);
+        }
+
+        return true;
+    }
+
+    void unpark(AnchorsBasePrivate *d)
+    {
+        QHash<const QWidget *, QList<AnchorsBasePrivate *> >::iterator it = queues.begin();
+
+        while (it != queues.end()) {
+            if (it.value().removeOne(d)) {
+                if (it.value().isEmpty()) {
+                    queues.erase(it);
+                }
+                break;
+            }
+            ++it;
+        }
+
+        d->parked = 0;
+    }
+
+    void flush(const QWidget *window)
+    {
+        QList<AnchorsBasePrivate *> list = queues.take(window);
+
+        if (list.isEmpty()) {
+            return;
+        }
+
+        // the parked flags become ordinary dirty marks, so the pass orders
+        // them by their dependencies like any deferred batch
+        AnchorsBasePrivate::beginDefer();
+        foreach (AnchorsBasePrivate *d, list) {
+            int flags = d->parked;
+
+            d->parked = 0;
+            d->markDirty(flags);
+        }
+        AnchorsBasePrivate::endDefer();
+    }
+
+    void flushAll()
+    {
+        while (!queues.isEmpty()) {
+            flush(queues.begin().key());
+        }
+    }
+
+    bool eventFilter(QObject *o, QEvent *e) Q_DECL_OVERRIDE
+    {
+        switch (e->type()) {
+        case QEvent::ActivationChange:
+        case QEvent::WindowStateChange:
+        case QEvent::Show:
+        case QEvent::Hide:
+        case QEvent::Expose: {
+            QWidget *window = o->isWidgetType() ? static_cast<QWidget *>(o) : NULL;
+
+            if (!window) {
+                foreach (const QWidget *w, priorities.keys()) {
+                    if (w->windowHandle() == o) {
+                        window = const_cast<QWidget *>(w);
+                        break;
+                    }
+                }
+            }
+
+            if (!window || !priorities.contains(window)) {
+                break;
+            }
+
+            // the native window may only exist once the widget is shown
+            if (e->type() == QEvent::Show && window->windowHandle()) {
+                window->windowHandle()->installEventFilter(this);
+            }
+
+            AnchorsScheduler::Priority previous = priorities.value(window);
+            AnchorsScheduler::Priority p = priorityOf(window);
+            priorities[window] = p;
+
+            // a window coming into view gets its backlog before it is first
+            // painted, an idle slice would show the stale layout for a frame;
+            // a shown window may only be exposed later, so Show counts as well
+            bool revealed = previous == AnchorsScheduler::Suspended
+                    && (p != AnchorsScheduler::Suspended || e->type() == QEvent::Show);
+
+            // a window the user turns to gets its backlog before anything else
+            if (p == AnchorsScheduler::Immediate || revealed) {
+                flush(window);
+            } else if (p == AnchorsScheduler::Idle && queues.contains(window) && !timer.isActive()) {
+                timer.start(0, this);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        return QObject::eventFilter(o, e);
+    }
+
+    // one window per idle slice, so that input to the active window is
+    // handled between two background relayouts
+    void timerEvent(QTimerEvent *e) Q_DECL_OVERRIDE
+    {
+        if (e->timerId() != timer.timerId()) {
+            QObject::timerEvent(e);
+            return;
+        }
+
+        const QWidget *next = NULL;
+
+        foreach (const QWidget *window, queues.keys()) {
+            if (priorities.value(window) != AnchorsScheduler::Suspended) {
+                next = window;
+                break;
+            }
+        }
+
+        if (next) {
+            flush(next);
+        }
+
+        foreach (const QWidget *window, queues.keys()) {
+            if (priorities.value(window) != AnchorsScheduler::Suspended) {
+                return;
+            }
+        }
+
+        timer.stop();
+    }
+
+    QHash<const QWidget *, AnchorsScheduler::Priority> priorities;
+    QHash<const QWidget *, QList<AnchorsBasePrivate *> > queues;
+    QBasicTimer timer;
+};
+
+bool AnchorsBasePrivate::park(int flag)
+{
+    return scheduler->park(this, flag);
+}
+
+void AnchorsBasePrivate::unpark()
+{
+    if (scheduler) {
+        scheduler->unpark(this);
+    }
+}
+
+bool AnchorsScheduler::isEnabled()
+{
+    return AnchorsBasePrivate::scheduler;
+}
+
+void AnchorsScheduler::setEnabled(bool enabled)
+{
+    if (enabled == isEnabled()) {
+        return;
+    }
+
+    if (enabled) {
+        AnchorsBasePrivate::scheduler = new AnchorsSchedulerPrivate;
+    } else {
+        AnchorsSchedulerPrivate *scheduler = AnchorsBasePrivate::scheduler;
+
+        // nothing may stay parked once updates run synchronously again
+        scheduler->flushAll();
+        AnchorsBasePrivate::scheduler = NULL;
+        delete scheduler;
+    }
+}
+
+AnchorsScheduler::Priority AnchorsScheduler::priority(const QWidget *window)
+{
+    if (!window) {
+        return Immediate;
+    }
+
+    AnchorsSchedulerPrivate *scheduler = AnchorsBasePrivate::scheduler;
+
+    return scheduler ? scheduler->priority(window->window()) : Immediate;
+}
+
+int AnchorsScheduler::pendingCount(const QWidget *window)
+{
+    AnchorsSchedulerPrivate *scheduler = AnchorsBasePrivate::scheduler;
+
+    if (!scheduler) {
+        return 0;
+    }
+
+    if (window) {
+        return scheduler->queues.value(window->window()).size();
+    }
+
+    int count = 0;
+    foreach (const QList<AnchorsBasePrivate *> &list, scheduler->queues) {
+        count += list.size();
+    }
+
+    return count;
+}
+
+void AnchorsScheduler::flush(const QWidget *window)
+{
+    AnchorsSchedulerPrivate *scheduler = AnchorsBasePrivate::scheduler;
+
+    if (!scheduler) {
+        return;
+    }
+
+    if (window) {
+        scheduler->flush(window->window());
+    } else {
+        scheduler->flushAll();
+    }
+}
+
+class AnchorsIncrementalLayoutPrivate
+{
+    explicit AnchorsIncrementalLayoutPrivate(AnchorsIncrementalLayout *qq): q_ptr(qq) {}
+
+    // the order of one sweep over the dirty widgets, visible ones first;
+    // entries that got processed as a dependency of another are skipped
+    void fillQueue()
+    {
+        QList<QPointer<AnchorsBase> > hidden;
+
+        queue.clear();
+        for (AnchorsBasePrivate *d = AnchorsBasePrivate::dirtyFirst; d; d = d->dirtyNext) {
+            if (d->extendWidget->target()->isVisible()) {
+                queue << d->q_func();
+            } else {
+                hidden << d->q_func();
+            }
+        }
+        queue << hidden;
+        head = 0;
+    }
+
+    void slice()
+    {
+        Q_Q(AnchorsIncrementalLayout);
+
+        qint64 budget_nsecs = qint64(budget) * 1000000;
+        int processed = 0;
+        QElapsedTimer clock;
+
+        clock.start();
+
+        ++AnchorsBasePrivate::deferDepth;
+        AnchorsBasePrivate::beginPass();
+        while (AnchorsBasePrivate::dirtyFirst) {
+            // an item is only started if it is expected to fit the budget
+            if (processed && clock.nsecsElapsed() + averageCost > budget_nsecs) {
+                break;
+            }
+
+            if (head >= queue.size()) {
+                fillQueue();
+            }
+
+            QPointer<AnchorsBase> base = queue.at(head++);
+
+            if (!base || !base->d_func()->dirty) {
+                continue;
+            }
+
+            qint64 start = clock.nsecsElapsed();
+            base->d_func()->process();
+            averageCost = (averageCost * 7 + clock.nsecsElapsed() - start) / 8;
+            ++processed;
+        }
+        AnchorsBasePrivate::endPass();
+        --AnchorsBasePrivate::deferDepth;
+
+        qint64 nsecs = clock.nsecsElapsed();
+
+        if (nsecs > budget_nsecs) {
+            qWarning() << "Anchors: incremental layout slice took" << nsecs / 1000 << "us for" << processed
+                       << "widgets, budget is" << budget << "ms";
+            emit q->overrun(nsecs, processed);
+        }
+
+        if (AnchorsBasePrivate::dirtyFirst) {
+            timer.start(0, q);
+        } else {
+            queue.clear();
+            head = 0;
+            emit q->settled();
+        }
+    }
+
+    int budget = 8;
+    bool active = false;
+    QList<QPointer<AnchorsBase> > queue;
+    int head = 0;
+    qint64 averageCost = 0;
+    QBasicTimer timer;
 
-    return d->horizontalCenter;
-}
+    AnchorsIncrementalLayout *q_ptr;
 
-const AnchorInfo *AnchorsBase::verticalCenter() const
-{
-    Q_D(const AnchorsBase);
+    Q_DECLARE_PUBLIC(AnchorsIncrementalLayout)
 
-    return d->verticalCenter;
-}
+    friend class AnchorsBasePrivate;
+};
 
-QWidget *AnchorsBase::fill() const
+void AnchorsBasePrivate::requestSlice()
 {
-    Q_D(const AnchorsBase);
+    AnchorsIncrementalLayoutPrivate *d = incremental;
 
-    if (d->fill) {
-        return d->fill->target();
+    if (!d->timer.isActive()) {
+        d->timer.start(0, d->q_ptr);
     }
-
-    return NULL;
 }
 
-QWidget *AnchorsBase::centerIn() const
+AnchorsIncrementalLayout::AnchorsIncrementalLayout(QObject *parent):
+    QObject(parent),
+    d_ptr(new AnchorsIncrementalLayoutPrivate(this))
 {
-    Q_D(const AnchorsBase);
-
-    if (d->centerIn) {
-        return d->centerIn->target();
-    }
-
-    return NULL;
 }
 
-int AnchorsBase::margins() const
+AnchorsIncrementalLayout::~AnchorsIncrementalLayout()
 {
-    Q_D(const AnchorsBase);
+    stop();
 
-    return d->margins;
+    delete d_ptr;
 }
 
-int AnchorsBase::topMargin() const
+int AnchorsIncrementalLayout::budget() const
 {
-    Q_D(const AnchorsBase);
+    Q_D(const AnchorsIncrementalLayout);
 
-    return d->topMargin;
+    return d->budget;
 }
 
-int AnchorsBase::bottomMargin() const
+bool AnchorsIncrementalLayout::isActive() const
 {
-    Q_D(const AnchorsBase);
+    Q_D(const AnchorsIncrementalLayout);
 
-    return d->bottomMargin;
+    return d->active;
 }
 
-int AnchorsBase::leftMargin() const
+bool AnchorsIncrementalLayout::isSettled() const
 {
-    Q_D(const AnchorsBase);
-
-    return d->leftMargin;
+    return !AnchorsBasePrivate::dirtyFirst;
 }
 
-int AnchorsBase::rightMargin() const
+int AnchorsIncrementalLayout::pendingCount() const
 {
-    Q_D(const AnchorsBase);
+    int count = 0;
+
+    for (AnchorsBasePrivate *d = AnchorsBasePrivate::dirtyFirst; d; d = d->dirtyNext) {
+        ++count;
+    }
 
-    return d->rightMargin;
+    return count;
 }
 
-int AnchorsBase::horizontalCenterOffset() const
+void AnchorsIncrementalLayout::setBudget(int msecs)
 {
-    Q_D(const AnchorsBase);
+    Q_D(AnchorsIncrementalLayout);
 
-    return d->horizontalCenterOffset;
-}
+    msecs = qMax(1, msecs);
 
-int AnchorsBase::verticalCenterOffset() const
-{
-    Q_D(const AnchorsBase);
+    if (d->budget == msecs) {
+        return;
+    }
+
+    d->budget = msecs;
 
-    return d->verticalCenterOffset;
+    emit budgetChanged(msecs);
 }
 
-int AnchorsBase::alignWhenCentered() const
+void AnchorsIncrementalLayout::start()
 {
-    Q_D(const AnchorsBase);
+    Q_D(AnchorsIncrementalLayout);
 
-    return d->alignWhenCentered;
-}
+    if (d->active) {
+        return;
+    }
 
-AnchorsBase::AnchorError AnchorsBase::errorCode() const
-{
-    Q_D(const AnchorsBase);
+    // one incremental layout drives the dirty list at a time
+    if (AnchorsBasePrivate::incremental) {
+        AnchorsBasePrivate::incremental->q_func()->stop();
+    }
 
-    return d->errorCode;
-}
+    d->active = true;
+    AnchorsBasePrivate::incremental = d;
 
-QString AnchorsBase::errorString() const
-{
-    Q_D(const AnchorsBase);
+    if (AnchorsBasePrivate::dirtyFirst) {
+        AnchorsBasePrivate::requestSlice();
+    }
 
-    return d->errorString;
+    emit activeChanged(true);
 }
 
-bool AnchorsBase::isBinding(const AnchorInfo *info) const
+void AnchorsIncrementalLayout::stop()
 {
-    return info->targetInfo;
-}
+    Q_D(AnchorsIncrementalLayout);
 
-bool AnchorsBase::setAnchor(QWidget *w, const Qt::AnchorPoint &p, QWidget *target, const Qt::AnchorPoint &point)
-{
-    if (!w || !target) {
-        return false;
+    if (!d->active) {
+        return;
     }
 
-    AnchorsBase *base = AnchorsBasePrivate::getWidgetAnchorsBase(w);
-    if (!base) {
-        base = new AnchorsBase(w);
-    }
+    bool pending = AnchorsBasePrivate::dirtyFirst;
 
-    return base->setAnchor(p, target, point);
-}
+    d->active = false;
+    d->timer.stop();
+    d->queue.clear();
+    d->head = 0;
+    AnchorsBasePrivate::incremental = NULL;
 
-void AnchorsBase::clearAnchors(const QWidget *w)
-{
-    AnchorsBase *base = AnchorsBasePrivate::getWidgetAnchorsBase(w);
-    if (base) {
-        base->deleteLater();
+    // whatever is left is laid out synchronously, like without the mode
+    AnchorsBasePrivate::beginDefer();
+    AnchorsBasePrivate::endDefer();
+
+    emit activeChanged(false);
+    if (pending) {
+        emit settled();
     }
 }
 
-AnchorsBase *AnchorsBase::getAnchorBaseByWidget(const QWidget *w)
+void AnchorsIncrementalLayout::timerEvent(QTimerEvent *e)
 {
-    return AnchorsBasePrivate::getWidgetAnchorsBase(w);
-}
+    Q_D(AnchorsIncrementalLayout);
 
-void AnchorsBase::setEnabled(bool enabled)
-{
-    Q_D(AnchorsBase);
+    if (e->timerId() != d->timer.timerId()) {
+        QObject::timerEvent(e);
+        return;
+    }
 
-    d->extendWidget->setEnabled(enabled);
+    d->timer.stop();
+    d->slice();
 }
 
-bool AnchorsBase::setAnchor(const Qt::AnchorPoint &p, QWidget *target, const Qt::AnchorPoint &point)
+class AnchorsViewportCullingPrivate
 {
-    if (!target) {
-        return false;
+    explicit AnchorsViewportCullingPrivate(AnchorsViewportCulling *qq): q_ptr(qq) {}
+
+    static AnchorsViewportCullingPrivate *cullingOf(const QWidget *w)
+    {
+        // the content widget itself is sized by the scroll area, only its
+        // descendants are culled
+        for (const QWidget *p = w->parentWidget(); p && p->parentWidget(); p = p->parentWidget()) {
+            AnchorsViewportCullingPrivate *culling = AnchorsBasePrivate::cullings.value(p->parentWidget(), NULL);
+
+            if (culling) {
+                return p == culling->area->widget() ? culling : NULL;
+            }
+        }
+
+        return NULL;
     }
 
-    AnchorsBase *base = AnchorsBasePrivate::getWidgetAnchorsBase(target);
+    bool isVisible(const QWidget *w) const
+    {
+        QWidget *content = area->widget();
+        QRect rect(w->mapTo(content, QPoint(0, 0)), w->size());
+        QRect visible(-content->pos(), area->viewport()->size());
 
-    if (!base) {
-        base = new AnchorsBase(target);
+        if (orientation == Qt::Vertical) {
+            return rect.bottom() >= visible.top() - margin && rect.top() <= visible.bottom() + margin;
+        }
+
+        return rect.right() >= visible.left() - margin && rect.left() <= visible.right() + margin;
     }
 
-    const AnchorInfo *info = base->d_func()->getInfoByPoint(point);
+    // only the cross axis is culled: positions along the scroll axis, and
+    // with them the content size, are always resolved. Fill, centerIn and
+    // binding updates place both axes in one go and are never culled
+    bool cull(AnchorsBasePrivate *d, int flag)
+    {
+        int cross = orientation == Qt::Vertical ? AnchorsBasePrivate::HorizontalFlag
+                    : AnchorsBasePrivate::VerticalFlag;
+        QWidget *w = d->extendWidget->target();
+
+        if (flag == cross && !isVisible(w)) {
+            if (!d->culled) {
+                d->culling = this;
+                pending.insert(d);
+            }
+            d->culled |= flag;
+
+            return true;
+        }
+
+        // a visible widget must not read the stale geometry of a culled one,
+        // neither through its anchors nor through its bindings
+        AnchorsBasePrivate *list[AnchorsBasePrivate::MaxDependencies];
+        int count = d->dependencies(list);
+        QVarLengthArray<AnchorsBasePrivate *, 16> culled;
+
+        for (int i = 0; i < count; ++i) {
+            if (list[i]->culled) {
+                culled.append(list[i]);
+            }
+        }
+        foreach (const AnchorsBasePrivate::Binding &binding, d->bindings) {
+            foreach (const QPointer<AnchorsBase> &base, binding.dependencies) {
+                if (base && base->d_func()->culled) {
+                    culled.append(base->d_func());
+                }
+            }
+        }
+
+        if (!culled.isEmpty()) {
+            AnchorsBasePrivate::beginDefer();
+            for (int i = 0; i < culled.size(); ++i) {
+                if (culled.at(i)->culled) {
+                    culled.at(i)->uncull();
+                }
+            }
+            AnchorsBasePrivate::endDefer();
+        }
 
-    switch (p) {
-    case Qt::AnchorTop:
-        return setTop(info);
-    case Qt::AnchorBottom:
-        return setBottom(info);
-    case Qt::AnchorLeft:
-        return setLeft(info);
-    case Qt::AnchorRight:
-        return setRight(info);
-    case Qt::AnchorHorizontalCenter:
-        return setHorizontalCenter(info);
-    case Qt::AnchorVerticalCenter:
-        return setVerticalCenter(info);
-    default:
         return false;
     }
-}
 
-#define ANCHOR_BIND_INFO(point, Point, slotName, signalsname...)\
-    Q_D(AnchorsBase);\
-    if(*d->point == point)\
-        return true;\
-    ExtendWidget *tmp_w1 = NULL;\
-    ExtendWidget *tmp_w2 = NULL;\
-    if(d->point->targetInfo){\
-        tmp_w1 = d->point->targetInfo->base->d_func()->extendWidget;\
-    }\
-    QStringList signalList = QString(#signalsname).split("),");\
-    if(point){\
-        if(!d->isBindable(d->point)){\
-            d->errorCode = Conflict;\
-            d->errorString = "Conflict: CenterIn or Fill is anchored.";\
-            return false;\
-        }\
-        if (point->base == d->q_func()){\
-            d->errorCode = TargetInvalid;\
-            d->errorString = "Cannot anchor widget to self.";\
-            return false;\
-        }else if(target()->parentWidget() != point->base->target()){\
-            bool isBrother = false;\
-            foreach (const QWidget *w, target()->parentWidget()->findChildren<QWidget*>()) {\
-                if(w == point->base->target()){\
-                    isBrother = true;\
-                    break;\
-                }\
-            }\
-            if(!isBrother){\
-                d->errorCode = TargetInvalid;\
-                d->errorString = "Cannot anchor to an widget that isn't a parent or sibling.";\
-                return false;\
-            }\
-        }\
-        if(!d->checkInfo(d->point, point)){\
-            d->errorCode = PointInvalid;\
-            d->errorString = "Cannot anchor a vertical/horizontal edge to a horizontal/vertical edge.";\
-            return false;\
-        }\
-        int old_pos = d->getValueByInfo(point);\
-        AnchorInfo old_info = *d->point;\
-        *d->point = point;\
-        slotName();\
-        if(old_pos != d->getValueByInfo(point)){\
-            *d->point = old_info;\
-            slotName();\
-            d->errorCode = PointInvalid;\
-            d->errorString = "loop bind.";\
-            return false;\
-        }else{\
-            old_pos = d->getValueByInfo(d->point);\
-            int target_old_value = d->getValueByInfo(point);\
-            d->setValueByInfo(target_old_value + 1, point);\
-            if(old_pos != d->getValueByInfo(d->point)){\
-                *d->point = old_info;\
-                slotName();\
-                d->setValueByInfo(target_old_value, point);\
-                d->errorCode = PointInvalid;\
-                d->errorString = "loop bind.";\
-                return false;\
-            }\
-            d->setValueByInfo(target_old_value, point);\
-        }\
-        tmp_w2 = point->base->d_func()->extendWidget;\
-        if(tmp_w1 != tmp_w2){\
-            foreach(QString str, signalList){\
-                QByteArray arr = str.replace(" ", "").toLatin1();\
-                if(arr.right(1) != ")") arr += ")";\
-                if(tmp_w1)\
-                    disconnect(tmp_w1, QByteArray("2"+arr).data(), d->q_func(), SLOT(slotName()));\
-                if(arr.size() != 13 || target()->parentWidget() != point->base->target())\
-                    connect(tmp_w2, QByteArray("2"+arr).data(), d->q_func(), SLOT(slotName()));\
-            }\
-        }\
-    }else{\
-        foreach(QString str, signalList){\
-            QByteArray arr = str.replace(" ", "").toLatin1();\
-            if(arr.right(1) != ")") arr += ")";\
-            disconnect(tmp_w1, QByteArray("2"+arr).data(), d->q_func(), SLOT(slotName()));\
-        }\
-        *d->point = point;\
-    }\
-    if((isBinding(d->right) || isBinding(d->horizontalCenter)) && d->horizontalAnchorCount() == 1)\
-    {connect(d->extendWidget, SIGNAL(widthChanged(int)), d->q_func(), SLOT(updateHorizontal()));}\
-    else disconnect(d->extendWidget, SIGNAL(widthChanged(int)), d->q_func(), SLOT(updateHorizontal()));\
-    if((isBinding(d->bottom) || isBinding(d->verticalCenter)) && d->verticalAnchorCount() == 1)\
-    {connect(d->extendWidget, SIGNAL(heightChanged(int)), d->q_func(), SLOT(updateVertical()));}\
-    else disconnect(d->extendWidget, SIGNAL(heightChanged(int)), d->q_func(), SLOT(updateVertical()));\
-    emit point##Changed(d->point);\
-    return true;\
+    void resolve(bool all)
+    {
+        // the scroll area may already be going away when everything is resolved
+        if (pending.isEmpty() || (!all && !area->widget())) {
+            return;
+        }
 
-#define ANCHOR_BIND_WIDGET(point, Point)\
-    if(d->point->target() == point)\
-        return true;\
-    if(point){\
-        if (point == target()){\
-            d->errorCode = TargetInvalid;\
-            d->errorString = "Cannot anchor widget to self.";\
-            return false;\
-        }else if(target()->parentWidget() != point){\
-            bool isBrother = false;\
-            foreach (const QWidget *w, target()->parentWidget()->findChildren<QWidget*>()) {\
-                if(w == point){\
-                    isBrother = true;\
-                    break;\
-                }\
-            }\
-            if(!isBrother){\
-                d->errorCode = TargetInvalid;\
-                d->errorString = "Cannot anchor to an widget that isn't a parent or sibling.";\
-                return false;\
-            }\
-        }\
-        QRect old_rect = point->geometry();\
-        QWidget *old_widget = d->point->target();\
-        d->point->setTarget(point);\
-        update##Point();\
-        if(old_rect != point->geometry()){\
-            d->point->setTarget(old_widget);\
-            update##Point();\
-            d->errorCode = PointInvalid;\
-            d->errorString = "loop bind.";\
-            return false;\
-        }\
-        AnchorInfo *info = NULL;\
-        setTop(info);setLeft(info);setRight(info);setBottom(info);setHorizontalCenter(info);setVerticalCenter(info);setCenterIn((QWidget*)NULL);\
-        if(d->point == d->fill)\
-            setCenterIn((QWidget*)NULL);\
-        if(target()->parentWidget() == point)\
-            disconnect(d->point, SIGNAL(positionChanged(QPoint)), d->q_func(), SLOT(update##Point()));\
-        else connect(d->point, SIGNAL(positionChanged(QPoint)), d->q_func(), SLOT(update##Point()));\
-    }\
-    d->point->setTarget(point);\
-    if(d->centerIn){connect(d->extendWidget, SIGNAL(sizeChanged(QSize)), d->q_func(), SLOT(updateCenterIn()));}\
-    else disconnect(d->extendWidget, SIGNAL(sizeChanged(QSize)), d->q_func(), SLOT(updateCenterIn()));\
-    emit point##Changed(point);\
-    return true;\
+        AnchorsBasePrivate::beginDefer();
+        foreach (AnchorsBasePrivate *d, pending) {
+            if (all || isVisible(d->extendWidget->target())) {
+                d->uncull();
+            }
+        }
+        AnchorsBasePrivate::endDefer();
+    }
 
-bool AnchorsBase::setTop(const AnchorInfo *top)
-{
-    ANCHOR_BIND_INFO(top, Top, updateVertical , yChanged(int), heightChanged(int))
-}
+    QScrollArea *area = NULL;
+    QWidget *viewport = NULL;
+    int margin = 200;
+    Qt::Orientation orientation = Qt::Vertical;
+    QSet<AnchorsBasePrivate *> pending;
 
-bool AnchorsBase::setBottom(const AnchorInfo *bottom)
-{
-    ANCHOR_BIND_INFO(bottom, Bottom, updateVertical , yChanged(int), heightChanged(int))
-}
+    AnchorsViewportCulling *q_ptr;
 
-bool AnchorsBase::setLeft(const AnchorInfo *left)
-{
-    ANCHOR_BIND_INFO(left, Left, updateHorizontal, xChanged(int), widthChanged(int))
-}
+    Q_DECLARE_PUBLIC(AnchorsViewportCulling)
 
-bool AnchorsBase::setRight(const AnchorInfo *right)
+    friend class AnchorsBasePrivate;
+};
+
+bool AnchorsBasePrivate::cull(int flag)
 {
-    ANCHOR_BIND_INFO(right, Right, updateHorizontal, xChanged(int), widthChanged(int))
+    AnchorsViewportCullingPrivate *d = AnchorsViewportCullingPrivate::cullingOf(extendWidget->target());
+
+    return d && d->cull(this, flag);
 }
 
-bool AnchorsBase::setHorizontalCenter(const AnchorInfo *horizontalCenter)
+void AnchorsBasePrivate::uncull()
 {
-    ANCHOR_BIND_INFO(horizontalCenter, HorizontalCenter, updateHorizontal, xChanged(int), widthChanged(int))
+    int flags = culled;
+
+    dropCulled();
+    markDirty(flags);
 }
 
-bool AnchorsBase::setVerticalCenter(const AnchorInfo *verticalCenter)
+void AnchorsBasePrivate::dropCulled()
 {
-    ANCHOR_BIND_INFO(verticalCenter, VerticalCenter, updateVertical , yChanged(int), heightChanged(int))
+    culling->pending.remove(this);
+    culling = NULL;
+    culled = 0;
 }
 
-bool AnchorsBase::setFill(QWidget *fill)
+AnchorsViewportCulling::AnchorsViewportCulling(QScrollArea *area):
+    QObject(area),
+    d_ptr(new AnchorsViewportCullingPrivate(this))
 {
-    Q_D(AnchorsBase);
+    Q_D(AnchorsViewportCulling);
 
-    ANCHOR_BIND_WIDGET(fill, Fill)
+    d->area = area;
+    d->viewport = area->viewport();
+    AnchorsBasePrivate::cullings[d->viewport] = d;
+
+    d->viewport->installEventFilter(this);
+    connect(area->verticalScrollBar(), SIGNAL(valueChanged(int)), SLOT(updateViewport()));
+    connect(area->horizontalScrollBar(), SIGNAL(valueChanged(int)), SLOT(updateViewport()));
 }
 
-bool AnchorsBase::setCenterIn(QWidget *centerIn)
+AnchorsViewportCulling::~AnchorsViewportCulling()
 {
-    Q_D(AnchorsBase);
+    Q_D(AnchorsViewportCulling);
 
-    if (centerIn && d->fill->target()) {
-        d->errorCode = Conflict;
-        d->errorString = "Conflict: Fill is anchored.";
-        return false;
+    if (AnchorsBasePrivate::cullings.value(d->viewport, NULL) == d) {
+        AnchorsBasePrivate::cullings.remove(d->viewport);
     }
 
-    ANCHOR_BIND_WIDGET(centerIn, CenterIn)
+    // nothing may stay behind once the widgets are laid out eagerly again
+    resolveAll();
+
+    delete d_ptr;
 }
 
-bool AnchorsBase::setFill(AnchorsBase *fill)
+QScrollArea *AnchorsViewportCulling::scrollArea() const
 {
-    return setFill(fill->target());
+    Q_D(const AnchorsViewportCulling);
+
+    return d->area;
 }
 
-bool AnchorsBase::setCenterIn(AnchorsBase *centerIn)
+int AnchorsViewportCulling::margin() const
 {
-    return setCenterIn(centerIn->target());
+    Q_D(const AnchorsViewportCulling);
+
+    return d->margin;
 }
 
-void AnchorsBase::setMargins(int margins)
+Qt::Orientation AnchorsViewportCulling::orientation() const
 {
-    Q_D(AnchorsBase);
-
-    if (d->margins == margins) {
-        return;
-    }
+    Q_D(const AnchorsViewportCulling);
 
-    d->margins = margins;
+    return d->orientation;
+}
 
-    if (margins != 0) {
-        if (d->fill->target()) {
-            updateFill();
-        } else {
-            updateVertical();
-            updateHorizontal();
-        }
-    }
+int AnchorsViewportCulling::pendingCount() const
+{
+    Q_D(const AnchorsViewportCulling);
 
-    emit marginsChanged(margins);
+    return d->pending.size();
 }
 
-void AnchorsBase::setTopMargin(int topMargin)
+void AnchorsViewportCulling::setMargin(int margin)
 {
-    Q_D(AnchorsBase);
+    Q_D(AnchorsViewportCulling);
 
-    if (d->topMargin == topMargin) {
+    margin = qMax(0, margin);
+
+    if (d->margin == margin) {
         return;
     }
 
-    d->topMargin = topMargin;
-
-    if (d->fill->target()) {
-        updateFill();
-    } else if (isBinding(d->top)) {
-        updateVertical();
-    }
+    d->margin = margin;
+    updateViewport();
 
-    emit topMarginChanged(topMargin);
+    emit marginChanged(margin);
 }
 
-void AnchorsBase::setBottomMargin(int bottomMargin)
+void AnchorsViewportCulling::setOrientation(Qt::Orientation orientation)
 {
-    Q_D(AnchorsBase);
+    Q_D(AnchorsViewportCulling);
 
-    if (d->bottomMargin == bottomMargin) {
+    if (d->orientation == orientation) {
         return;
     }
 
-    d->bottomMargin = bottomMargin;
+    // the culled axis changes with the orientation, so the backlog can't stay
+    resolveAll();
+    d->orientation = orientation;
 
-    if (d->fill->target()) {
-        updateFill();
-    } else if (isBinding(d->bottom)) {
-        updateVertical();
-    }
+    emit orientationChanged(orientation);
+}
 
-    emit bottomMarginChanged(bottomMargin);
+void AnchorsViewportCulling::resolveAll()
+{
+    Q_D(AnchorsViewportCulling);
+
+    d->resolve(true);
 }
 
-void AnchorsBase::setLeftMargin(int leftMargin)
+bool AnchorsViewportCulling::eventFilter(QObject *o, QEvent *e)
 {
-    Q_D(AnchorsBase);
+    Q_D(AnchorsViewportCulling);
 
-    if (d->leftMargin == leftMargin) {
-        return;
+    if (o == d->viewport && e->type() == QEvent::Resize) {
+        updateViewport();
     }
 
-    d->leftMargin = leftMargin;
+    return QObject::eventFilter(o, e);
+}
 
-    if (d->fill->target()) {
-        updateFill();
-    } else if (isBinding(d->left)) {
-        updateHorizontal();
-    }
+void AnchorsViewportCulling::updateViewport()
+{
+    Q_D(AnchorsViewportCulling);
 
-    emit leftMarginChanged(leftMargin);
+    d->resolve(false);
 }
 
-void AnchorsBase::setRightMargin(int rightMargin)
+class AnchorLayoutPrivate
 {
-    Q_D(AnchorsBase);
+    explicit AnchorLayoutPrivate(AnchorLayout *qq): q_ptr(qq) {}
 
-    if (d->rightMargin == rightMargin) {
-        return;
-    }
+    static AnchorsBasePrivate *anchorsOf(QWidget *w, bool create)
+    {
+        if (!w) {
+            return NULL;
+        }
 
-    d->rightMargin = rightMargin;
+        AnchorsBase *base = create ? AnchorsBasePrivate::implicitAnchorsBase(w)
+                            : AnchorsBasePrivate::getWidgetAnchorsBase(w);
 
-    if (isBinding(d->right)) {
-        updateHorizontal();
+        return base ? base->d_func() : NULL;
     }
-    if (d->fill->target()) {
-        updateFill();
+
+    static int margin(int margin, int margins)
+    {
+        return margin == 0 ? margins : margin;
     }
 
-    emit rightMarginChanged(rightMargin);
-}
+    // lower bound of the parent extent needed to show an item at the given
+    // size, only edges anchored to the parent itself are taken into account
+    int requiredExtent(const QLayoutItem *item, Qt::Orientation orientation, bool minimum) const
+    {
+        QLayoutItem *layout_item = const_cast<QLayoutItem *>(item);
+        QWidget *w = layout_item->widget();
+        const QWidget *parent = q_ptr->parentWidget();
+        QSize size_hint = minimum ? item->minimumSize() : item->sizeHint();
+        bool horizontal = orientation == Qt::Horizontal;
+        int size = horizontal ? size_hint.width() : size_hint.height();
+        int current = w ? (horizontal ? w->geometry().right() : w->geometry().bottom()) + 1 : 0;
+        AnchorsBase *base = AnchorsBasePrivate::getWidgetAnchorsBase(w);
+
+        if (!base) {
+            return current;
+        }
 
-void AnchorsBase::setHorizontalCenterOffset(int horizontalCenterOffset)
-{
-    Q_D(AnchorsBase);
+        int margin1 = horizontal ? margin(base->leftMargin(), base->margins())
+                      : margin(base->topMargin(), base->margins());
+        int margin2 = horizontal ? margin(base->rightMargin(), base->margins())
+                      : margin(base->bottomMargin(), base->margins());
 
-    if (d->horizontalCenterOffset == horizontalCenterOffset) {
-        return;
-    }
+        if (base->fill() == parent) {
+            return margin1 + size + margin2;
+        }
 
-    d->horizontalCenterOffset = horizontalCenterOffset;
+        if (base->centerIn() == parent) {
+            return size;
+        }
 
-    if (isBinding(d->horizontalCenter)) {
-        updateHorizontal();
+        const AnchorInfo *first = horizontal ? base->left() : base->top();
+        const AnchorInfo *center = horizontal ? base->horizontalCenter() : base->verticalCenter();
+        const AnchorInfo *second = horizontal ? base->right() : base->bottom();
+        Qt::AnchorPoint start = horizontal ? Qt::AnchorLeft : Qt::AnchorTop;
+        Qt::AnchorPoint end = horizontal ? Qt::AnchorRight : Qt::AnchorBottom;
+        bool to_start = first->targetInfo && first->targetInfo->base->target() == parent
+                        && first->targetInfo->type == start;
+        bool to_end = second->targetInfo && second->targetInfo->base->target() == parent
+                      && second->targetInfo->type == end;
+        bool to_center = center->targetInfo && center->targetInfo->base->target() == parent
+                         && center->targetInfo->type != start && center->targetInfo->type != end;
+
+        if (to_start && to_end) {
+            return margin1 + size + margin2;
+        } else if (to_start) {
+            return margin1 + size;
+        } else if (to_end) {
+            return size + margin2;
+        } else if (to_center) {
+            int offset = horizontal ? base->horizontalCenterOffset() : base->verticalCenterOffset();
+            return size + 2 * qAbs(offset);
+        }
+
+        return current;
     }
 
-    emit horizontalCenterOffsetChanged(horizontalCenterOffset);
-}
+    QSize requiredSize(bool minimum) const
+    {
+        QSize size(0, 0);
 
-void AnchorsBase::setVerticalCenterOffset(int verticalCenterOffset)
-{
-    Q_D(AnchorsBase);
+        foreach (const QLayoutItem *item, items) {
+            if (item->isEmpty()) {
+                continue;
+            }
 
-    if (d->verticalCenterOffset == verticalCenterOffset) {
-        return;
+            size.setWidth(qMax(size.width(), requiredExtent(item, Qt::Horizontal, minimum)));
+            size.setHeight(qMax(size.height(), requiredExtent(item, Qt::Vertical, minimum)));
+        }
+
+        return size;
     }
 
-    d->verticalCenterOffset = verticalCenterOffset;
+    QList<QLayoutItem *> items;
+    mutable QSize sizeHint;
+    mutable QSize minimumSize;
+    bool requested = false;
 
-    if (isBinding(d->verticalCenter)) {
-        updateVertical();
+    AnchorLayout *q_ptr;
+
+    Q_DECLARE_PUBLIC(AnchorLayout)
+
+    friend class AnchorsBasePrivate;
+};
+
+void AnchorsBasePrivate::requestLayout()
+{
+    AnchorLayoutPrivate *d = layout->d_func();
+
+    // one LayoutRequest per pass is enough, the pass resolves every dirty item
+    if (!d->requested) {
+        d->requested = true;
+        layout->invalidate();
     }
+}
 
-    emit verticalCenterOffsetChanged(verticalCenterOffset);
+AnchorLayout::AnchorLayout(QWidget *parent):
+    QLayout(parent),
+    d_ptr(new AnchorLayoutPrivate(this))
+{
+    setContentsMargins(0, 0, 0, 0);
 }
 
-void AnchorsBase::setAlignWhenCentered(bool alignWhenCentered)
+AnchorLayout::~AnchorLayout()
 {
-    Q_D(AnchorsBase);
+    QLayoutItem *item;
 
-    if (d->alignWhenCentered == alignWhenCentered) {
-        return;
+    while ((item = takeAt(0))) {
+        delete item;
     }
 
-    d->alignWhenCentered = alignWhenCentered;
-    emit alignWhenCenteredChanged(alignWhenCentered);
+    delete d_ptr;
 }
 
-#define SET_POS(fun)\
-    ARect rect = target()->geometry();\
-    rect.set##fun(arg, point);\
-    target()->setMinimumSize(QSize(0,0));\
-    target()->setMaximumSize(QSize(16777215, 16777215));\
-    target()->setGeometry(rect);\
+void AnchorLayout::addItem(QLayoutItem *item)
+{
+    Q_D(AnchorLayout);
 
-#define MOVE_POS(fun)\
-    ARect rect = target()->geometry();\
-    rect.move##fun(arg);\
-    target()->move(rect.topLeft());\
+    d->items << item;
 
-void AnchorsBase::setTop(int arg, Qt::AnchorPoint point)
-{
-    SET_POS(Top)
+    AnchorsBasePrivate *anchors = d->anchorsOf(item->widget(), true);
+    if (anchors) {
+        anchors->layout = this;
+    }
+
+    invalidate();
 }
 
-void AnchorsBase::setBottom(int arg, Qt::AnchorPoint point)
+QLayoutItem *AnchorLayout::itemAt(int index) const
 {
-    SET_POS(Bottom)
+    Q_D(const AnchorLayout);
+
+    return d->items.value(index, NULL);
 }
 
-void AnchorsBase::setLeft(int arg, Qt::AnchorPoint point)
+QLayoutItem *AnchorLayout::takeAt(int index)
 {
-    SET_POS(Left)
+    Q_D(AnchorLayout);
+
+    if (index < 0 || index >= d->items.size()) {
+        return NULL;
+    }
+
+    QLayoutItem *item = d->items.takeAt(index);
+
+    AnchorsBasePrivate *anchors = d->anchorsOf(item->widget(), false);
+    if (anchors && anchors->layout == this) {
+        anchors->layout = NULL;
+    }
+
+    invalidate();
+
+    return item;
 }
 
-void AnchorsBase::setHorizontalCenter(int arg, Qt::AnchorPoint point)
+int AnchorLayout::count() const
 {
-    SET_POS(HorizontalCenter)
+    Q_D(const AnchorLayout);
+
+    return d->items.size();
 }
 
-void AnchorsBase::setVerticalCenter(int arg, Qt::AnchorPoint point)
+QSize AnchorLayout::sizeHint() const
 {
-    SET_POS(VerticalCenter)
+    Q_D(const AnchorLayout);
+
+    if (!d->sizeHint.isValid()) {
+        d->sizeHint = d->requiredSize(false);
+    }
+
+    return d->sizeHint;
 }
 
-void AnchorsBase::setRight(int arg, Qt::AnchorPoint point)
+QSize AnchorLayout::minimumSize() const
 {
-    SET_POS(Right)
+    Q_D(const AnchorLayout);
+
+    if (!d->minimumSize.isValid()) {
+        d->minimumSize = d->requiredSize(true);
+    }
+
+    return d->minimumSize;
 }
 
-void AnchorsBase::moveTop(int arg)
+Qt::Orientations AnchorLayout::expandingDirections() const
 {
-    MOVE_POS(Top)
+    return Qt::Horizontal | Qt::Vertical;
 }
 
-void AnchorsBase::moveBottom(int arg)
+void AnchorLayout::setGeometry(const QRect &rect)
 {
-    MOVE_POS(Bottom)
+    Q_D(AnchorLayout);
+
+    bool resized = rect != geometry();
+
+    d->requested = false;
+    QLayout::setGeometry(rect);
+
+    QWidget *parent = parentWidget();
+
+    // all anchored children are resolved in one deferred pass, items that
+    // do not depend on the parent are only recomputed if they are dirty
+    AnchorsBasePrivate::beginDefer();
+    if (resized && parent) {
+        foreach (QLayoutItem *item, d->items) {
+            AnchorsBasePrivate *anchors = d->anchorsOf(item->widget(), false);
+
+            if (anchors && anchors->anchoredTo(parent)) {
+                anchors->markDirty(anchors->boundFlags());
+            }
+        }
+    }
+    AnchorsBasePrivate::endDefer();
 }
 
-void AnchorsBase::moveLeft(int arg)
+void AnchorLayout::invalidate()
 {
-    MOVE_POS(Left)
+    Q_D(AnchorLayout);
+
+    d->sizeHint = QSize();
+    d->minimumSize = QSize();
+
+    QLayout::invalidate();
 }
 
-void AnchorsBase::moveRight(int arg)
+#define RESOLVE_AXIS(P1,P3)\
+    int index = 0;\
+    if(axis.bound[0]){\
+        int p1Value = roundValue(axis.values[0]);\
+        rect.move##P1(p1Value);\
+        if(axis.bound[1]){\
+            rect.set##P3(roundValue(2 * axis.values[1] - p1Value), Qt::Anchor##P1);\
+        }else if(axis.bound[2]){\
+            rect.set##P3(roundValue(axis.values[2]), Qt::Anchor##P1);\
+        }\
+    }else if(axis.bound[2]){\
+        int p3Value = roundValue(axis.values[2]);\
+        index = 2;\
+        rect.move##P3(p3Value);\
+        if(axis.bound[1]){\
+            rect.set##P1(roundValue(2 * axis.values[1] - p3Value), Qt::Anchor##P1);\
+        }\
+    }else if(axis.bound[1]){\
+        index = 1;\
+        rect.move##P1(centeredStart(axis.values[1], axis.size, axis.alignWhenCentered));\
+    }else{\
+        index = -1;\
+    }\
+
+// the arithmetic anchors always used: the axis is moved onto its first bound
+// point and stretched to the next one
+class AnchorsCascadeEngine : public AnchorsEngine
 {
-    MOVE_POS(Right)
-}
+public:
+    QString name() const Q_DECL_OVERRIDE
+    {
+        return "cascade";
+    }
 
-void AnchorsBase::moveHorizontalCenter(int arg)
+    int resolve(Axis &axis) const Q_DECL_OVERRIDE
+    {
+        if (axis.orientation == Qt::Vertical) {
+            ARect rect(QRect(0, axis.start, 1, axis.size));
+            RESOLVE_AXIS(Top, Bottom)
+            axis.start = rect.top();
+            axis.size = rect.height();
+            return index;
+        }
+
+        ARect rect(QRect(axis.start, 0, axis.size, 1));
+        RESOLVE_AXIS(Left, Right)
+        axis.start = rect.left();
+        axis.size = rect.width();
+        return index;
+    }
+};
+
+// the same semantics in closed form on the span, without going through a rect
+class AnchorsSpanEngine : public AnchorsEngine
 {
-    MOVE_POS(HorizontalCenter)
-}
+public:
+    QString name() const Q_DECL_OVERRIDE
+    {
+        return "span";
+    }
 
-void AnchorsBase::moveVerticalCenter(int arg)
+    int resolve(Axis &axis) const Q_DECL_OVERRIDE
+    {
+        if (axis.bound[0]) {
+            int start = roundValue(axis.values[0]);
+            int end = axis.bound[1] ? roundValue(2 * axis.values[1] - start)
+                      : axis.bound[2] ? roundValue(axis.values[2]) : start + axis.size - 1;
+
+            axis.start = start;
+            axis.size = end - start + 1;
+            return 0;
+        }
+
+        if (axis.bound[2]) {
+            int end = roundValue(axis.values[2]);
+
+            axis.start = axis.bound[1] ? roundValue(2 * axis.values[1] - end) : end - axis.size + 1;
+            axis.size = end - axis.start + 1;
+            return 2;
+        }
+
+        if (axis.bound[1]) {
+            axis.start = centeredStart(axis.values[1], axis.size, axis.alignWhenCentered);
+            return 1;
+        }
+
+        return -1;
+    }
+};
+
+AnchorsEngine::AnchorsEngine()
 {
-    MOVE_POS(VerticalCenter)
 }
 
-void AnchorsBase::moveCenter(const QPoint &arg)
+AnchorsEngine::~AnchorsEngine()
 {
-    MOVE_POS(Center)
 }
 
-#define UPDATE_GEOMETRY(p1,P1,p2,P2,p3,P3)\
-    Q_D(AnchorsBase);\
-    if(isBinding(d->p1)){\
-        int p1##Value = d->getTargetValueByInfo(d->p1);\
-        move##P1(p1##Value);\
-        if(isBinding(d->p2)){\
-            qreal value = d->getTargetValueByInfo(d->p2);\
-            set##P3(2 * value - p1##Value, Qt::Anchor##P1);\
-        }else if(isBinding(d->p3)){\
-            set##P3(d->getTargetValueByInfo(d->p3), Qt::Anchor##P1);\
-        }\
-    }else if(isBinding(d->p3)){\
-        int p3##Value = d->getTargetValueByInfo(d->p3);\
-        move##P3(p3##Value);\
-        if(isBinding(d->p2)){\
-            qreal value = d->getTargetValueByInfo(d->p2);\
-            set##P1(2 * value - p3##Value, Qt::Anchor##P1);\
-        }\
-    }else if(isBinding(d->p2)){\
-        move##P2(d->getTargetValueByInfo(d->p2));\
-    }\
-
-void AnchorsBase::updateVertical()
+AnchorsEngine *AnchorsEngine::cascade()
 {
-    UPDATE_GEOMETRY(top, Top, verticalCenter, VerticalCenter, bottom, Bottom)
+    static AnchorsCascadeEngine engine;
+
+    return &engine;
 }
 
-void AnchorsBase::updateHorizontal()
+AnchorsEngine *AnchorsEngine::span()
 {
-    UPDATE_GEOMETRY(left, Left, horizontalCenter, HorizontalCenter, right, Right)
+    static AnchorsSpanEngine engine;
+
+    return &engine;
 }
 
-void AnchorsBase::updateFill()
+// the selections belong to top-level windows, any widget stands for its own
+AnchorsEngine *AnchorsEngine::engine(const QWidget *window)
 {
-    Q_D(AnchorsBase);
+    if (!window) {
+        return cascade();
+    }
 
-    QRect rect = d->getWidgetRect(d->fill->target());
-    int offset = d->topMargin != 0 ? d->topMargin : d->margins;
-    rect.setTop(rect.top() + offset);
-    offset = d->bottomMargin != 0 ? d->bottomMargin : d->margins;
-    rect.setBottom(rect.bottom() - offset);
-    offset = d->leftMargin != 0 ? d->leftMargin : d->margins;
-    rect.setLeft(rect.left() + offset);
-    offset = d->rightMargin != 0 ? d->rightMargin : d->margins;
-    rect.setRight(rect.right() - offset);
+    AnchorsEngine *engine = AnchorsBasePrivate::engines.value(window->window()).engine;
 
-    target()->setFixedSize(rect.size());
-    target()->move(rect.topLeft());
+    return engine ? engine : cascade();
 }
 
-void AnchorsBase::updateCenterIn()
+void AnchorsEngine::setEngine(const QWidget *window, AnchorsEngine *engine)
 {
-    Q_D(AnchorsBase);
+    if (!window) {
+        return;
+    }
 
-    QRect rect = d->getWidgetRect(d->centerIn->target());
-    moveCenter(rect.center());
+    if (!engine || engine == cascade()) {
+        AnchorsBasePrivate::dropEngine(window->window());
+        return;
+    }
+
+    AnchorsBasePrivate::EngineSelection selection;
+    selection.engine = engine;
+    AnchorsBasePrivate::selectEngine(window->window(), selection);
 }
 
-AnchorsBase::AnchorsBase(AnchorsBasePrivate *dd):
-    QObject(dd->extendWidget->target()),
-    d_ptr(dd)
+void AnchorsEngine::compare(const QWidget *window, AnchorsEngine *first, AnchorsEngine *second)
 {
+    if (!first || !second || !window) {
+        setEngine(window, first ? first : second);
+        return;
+    }
+
+    // a new comparison starts from zero
+    AnchorsBasePrivate::EngineSelection selection;
+    selection.engine = first;
+    selection.reference = second;
+    selection.comparison.first = first->name();
+    selection.comparison.second = second->name();
+    AnchorsBasePrivate::selectEngine(window->window(), selection);
 }
 
-void AnchorsBase::init(QWidget *w)
+AnchorsEngineComparison AnchorsEngine::comparison(const QWidget *window)
 {
-    Q_D(AnchorsBase);
+    if (!window) {
+        return AnchorsEngineComparison();
+    }
 
-    AnchorsBase *base = AnchorsBasePrivate::getWidgetAnchorsBase(w);
+    return AnchorsBasePrivate::engines.value(window->window()).comparison;
+}
 
-    if (base) {
-        if (d && d->q_func() == this) {
-            delete d;
-        }
+// every bound value becomes a pixel the way centers do, so fractional and
+// negative points follow the configured rounding instead of truncating
+int AnchorsEngine::roundValue(qreal value)
+{
+    return AnchorsBasePrivate::roundValue(value);
+}
 
-        d_ptr = base->d_func();
-    } else if (d && d->q_func() == this) {
-        d->removeWidgetAnchorsBase(target(), this);
-        d->setWidgetAnchorsBase(w, this);
-        d->extendWidget->setTarget(w);
-    } else {
-        base = new AnchorsBase(w, false);
-        d_ptr = base->d_func();
+int AnchorsEngine::centeredStart(qreal center, int size, bool alignWhenCentered)
+{
+    if (alignWhenCentered) {
+        return AnchorsBasePrivate::roundValue(center) - size / 2;
     }
+
+    return AnchorsBasePrivate::roundValue(center - size / 2.0);
 }
 
-AnchorsBase::AnchorsBase(QWidget *w, bool):
-    QObject(w),
-    d_ptr(new AnchorsBasePrivate(this))
+void AnchorInfo::setTargetInfo(const AnchorInfo *info)
 {
-    Q_D(AnchorsBase);
+    if (info == targetInfo) {
+        return;
+    }
 
-    d->extendWidget = new ExtendWidget(w, this);
-    connect(d->extendWidget, SIGNAL(enabledChanged(bool)), SIGNAL(enabledChanged(bool)));
-    connect(d->fill, SIGNAL(sizeChanged(QSize)), SLOT(updateFill()));
-    connect(d->centerIn, SIGNAL(sizeChanged(QSize)), SLOT(updateCenterIn()));
+    if (targetInfo) {
+        targetInfo->base->d_func()->release(this);
+    }
 
-    d->setWidgetAnchorsBase(w, this);
+    targetInfo = info;
+
+    if (info) {
+        info->base->d_func()->incoming.insert(this);
+    } else {
+        base->d_func()->requestReclaim();
+    }
 }
 
 void ARect::setTop(int arg, Qt::AnchorPoint point)
@@ -2,11 +2,15 @@
 #define ANCHORS_H
 
 #include <QObject>
+#include <QExplicitlySharedDataPointer>
+#include <QLayout>
 #include <QPointer>
+#include <QtMath>
 #include <QResizeEvent>
 #include <QMoveEvent>
 #include <QWidget>
 #include <QDebug>
+#include <functional>
 
 class ExtendWidgetPrivate;
 class ExtendWidget: public QObject
@@ -46,6 +50,78 @@ private:
     ExtendWidgetPrivate *d_ptr;
 
     Q_DECLARE_PRIVATE(ExtendWidget)
+    friend class AnchorsBasePrivate;
+};
+
+class AnchorsObserver
+{
+public:
+    enum UpdateType {
+        VerticalUpdate,
+        HorizontalUpdate,
+        FillUpdate,
+        CenterInUpdate
+    };
+
+    AnchorsObserver();
+    virtual ~AnchorsObserver();
+
+    virtual void eventBegin(const QWidget *w, QEvent::Type type);
+    virtual void eventEnd(const QWidget *w, QEvent::Type type);
+    virtual void updateBegin(const QWidget *w, UpdateType type);
+    virtual void updateEnd(const QWidget *w, UpdateType type, qint64 nsecs);
+    virtual void geometryAboutToBeCommitted(const QWidget *w, const QRect &geometry);
+    virtual void geometryCommitted(const QWidget *w, const QRect &geometry);
+    virtual void repaintAboutToBeRequested(const QWidget *parent, const QRect &rect);
+    virtual void repaintRequested(const QWidget *parent, const QRect &rect);
+    virtual void oscillationDetected(const QList<const QWidget *> &widgets);
+
+    static bool isActive();
+};
+
+struct AnchorsEngineComparison {
+    QString first;
+    QString second;
+    qint64 resolves = 0;
+    qint64 mismatches = 0;
+    qint64 firstNsecs = 0;
+    qint64 secondNsecs = 0;
+};
+
+class AnchorsEngine
+{
+public:
+    // one axis of a widget: the start, center and end points in this order
+    struct Axis {
+        Qt::Orientation orientation;
+        int start;
+        int size;
+        bool bound[3];
+        qreal values[3];
+        bool alignWhenCentered;
+    };
+
+    AnchorsEngine();
+    virtual ~AnchorsEngine();
+
+    virtual QString name() const = 0;
+    // places the axis on its bound points, returns the index of the point
+    // that stays fixed or -1 when none is bound
+    virtual int resolve(Axis &axis) const = 0;
+
+    static AnchorsEngine *cascade();
+    static AnchorsEngine *span();
+    static AnchorsEngine *engine(const QWidget *window);
+    static void setEngine(const QWidget *window, AnchorsEngine *engine);
+    static void compare(const QWidget *window, AnchorsEngine *first, AnchorsEngine *second);
+    static AnchorsEngineComparison comparison(const QWidget *window);
+
+protected:
+    static int roundValue(qreal value);
+    static int centeredStart(qreal center, int size, bool alignWhenCentered);
+
+private:
+    Q_DISABLE_COPY(AnchorsEngine)
 };
 
 class AnchorsBase;
@@ -55,6 +131,7 @@ struct AnchorInfo {
         type(t)
     {
     }
+    AnchorInfo(const AnchorInfo &other) = default;
 
     AnchorsBase *base;
     Qt::AnchorPoint type;
@@ -82,10 +159,20 @@ struct AnchorInfo {
 
     const AnchorInfo &operator=(const AnchorInfo *info)
     {
-        targetInfo = info;
+        setTargetInfo(info);
+
+        return *this;
+    }
+
+    const AnchorInfo &operator=(const AnchorInfo &info)
+    {
+        setTargetInfo(info.targetInfo);
 
         return *this;
     }
+
+    // keeps the incoming anchors of the target's widget counted
+    void setTargetInfo(const AnchorInfo *info);
 };
 
 class ARect: public QRect
@@ -109,7 +196,7 @@ public:
 
     inline void moveHorizontalCenter(int arg)
     {
-        moveLeft(arg - width() / 2.0);
+        moveLeft(qFloor(arg - width() / 2.0));
     }
 
     inline qreal verticalCenter()
@@ -119,7 +206,7 @@ public:
 
     inline void moveVerticalCenter(int arg)
     {
-        moveTop(arg - height() / 2.0);
+        moveTop(qFloor(arg - height() / 2.0));
     }
 
     void setTop(int arg, Qt::AnchorPoint point);
@@ -154,21 +241,59 @@ class AnchorsBase : public QObject
     Q_PROPERTY(int horizontalCenterOffset READ horizontalCenterOffset WRITE setHorizontalCenterOffset NOTIFY horizontalCenterOffsetChanged)
     Q_PROPERTY(int verticalCenterOffset READ verticalCenterOffset WRITE setVerticalCenterOffset NOTIFY verticalCenterOffsetChanged)
     Q_PROPERTY(bool alignWhenCentered READ alignWhenCentered WRITE setAlignWhenCentered NOTIFY alignWhenCenteredChanged)
+    Q_PROPERTY(qreal aspectRatio READ aspectRatio WRITE setAspectRatio NOTIFY aspectRatioChanged)
 
 public:
     explicit AnchorsBase(QWidget *w);
     ~AnchorsBase();
 
+    // new (w) allocates from the arena of the window of w
+    static void *operator new(size_t size);
+    static void *operator new(size_t size, const QWidget *w);
+    static void *operator new(size_t size, void *where) { return where; }
+    static void operator delete(void *ptr);
+    static void operator delete(void *ptr, const QWidget *w);
+    static void operator delete(void *ptr, void *where) { Q_UNUSED(ptr) Q_UNUSED(where) }
+
     enum AnchorError {
         NoError,
         Conflict,
         TargetInvalid,
         PointInvalid,
-        LoopBind
+        LoopBind,
+        Oscillation
+    };
+
+    enum CenterRounding {
+        RoundDown,
+        RoundUp,
+        RoundNearest
+    };
+
+    enum BindingProperty {
+        LeftProperty = Qt::AnchorLeft,
+        HorizontalCenterProperty = Qt::AnchorHorizontalCenter,
+        RightProperty = Qt::AnchorRight,
+        TopProperty = Qt::AnchorTop,
+        VerticalCenterProperty = Qt::AnchorVerticalCenter,
+        BottomProperty = Qt::AnchorBottom,
+        WidthProperty,
+        HeightProperty
+    };
+
+    enum MarginProperty {
+        MarginsProperty,
+        TopMarginProperty,
+        BottomMarginProperty,
+        LeftMarginProperty,
+        RightMarginProperty,
+        HorizontalCenterOffsetProperty,
+        VerticalCenterOffsetProperty
     };
 
     QWidget *target() const;
     bool enabled() const;
+    bool isRetained() const;
     const AnchorsBase *anchors() const;
     const AnchorInfo *top() const;
     const AnchorInfo *bottom() const;
@@ -186,16 +311,42 @@ public:
     int horizontalCenterOffset() const;
     int verticalCenterOffset() const;
     int alignWhenCentered() const;
+    qreal aspectRatio() const;
     AnchorError errorCode() const;
     QString errorString() const;
     bool isBinding(const AnchorInfo *info) const;
+    bool hasBinding(BindingProperty property) const;
+    QList<QWidget *> bindingDependencies(BindingProperty property) const;
+    QString marginVariable(MarginProperty property) const;
+
+    bool setBinding(BindingProperty property, const std::function<qreal()> &expression);
+    bool setSizeBinding(BindingProperty property, QWidget *source, BindingProperty sourceProperty,
+                        qreal ratio = 1, int offset = 0);
+    void clearBinding(BindingProperty property);
+    bool setMarginVariable(MarginProperty property, const QString &name);
+    void clearMarginVariable(MarginProperty property);
 
     static bool setAnchor(QWidget *w, const Qt::AnchorPoint &p, QWidget *target, const Qt::AnchorPoint &point);
     static void clearAnchors(const QWidget *w);
+    static void clearWindowAnchors(const QWidget *window);
     static AnchorsBase *getAnchorBaseByWidget(const QWidget *w);
+    static AnchorsBase *createAnchorBase(QWidget *w);
+    static CenterRounding centerRounding();
+    static void setCenterRounding(CenterRounding rounding);
+    static int iterationLimit();
+    static void setIterationLimit(int limit);
+    static bool repaintCoalescing();
+    static void setRepaintCoalescing(bool enabled);
+    static bool autoReclaim();
+    static void setAutoReclaim(bool enabled);
+    static qreal valueOf(QWidget *w, Qt::AnchorPoint point);
+    static int widthOf(QWidget *w);
+    static int heightOf(QWidget *w);
+    static bool isSizeAnchored(const QWidget *w, Qt::Orientation orientation);
 
 public slots:
     void setEnabled(bool enabled);
+    void setRetained(bool retained);
     bool setAnchor(const Qt::AnchorPoint &p, QWidget *target, const Qt::AnchorPoint &point);
     bool setTop(const AnchorInfo *top);
     bool setBottom(const AnchorInfo *bottom);
@@ -215,6 +366,7 @@ public slots:
     void setHorizontalCenterOffset(int horizontalCenterOffset);
     void setVerticalCenterOffset(int verticalCenterOffset);
     void setAlignWhenCentered(bool alignWhenCentered);
+    void setAspectRatio(qreal aspectRatio);
 
     void setTop(int arg, Qt::AnchorPoint point);
     void setBottom(int arg, Qt::AnchorPoint point);
@@ -236,6 +388,7 @@ private slots:
     void updateHorizontal();
     void updateFill();
     void updateCenterIn();
+    void updateBindings();
 
 signals:
     void enabledChanged(bool enabled);
@@ -255,6 +408,8 @@ signals:
     void horizontalCenterOffsetChanged(int horizontalCenterOffset);
     void verticalCenterOffsetChanged(int verticalCenterOffset);
     void alignWhenCenteredChanged(bool alignWhenCentered);
+    void aspectRatioChanged(qreal aspectRatio);
+    void bindingChanged(AnchorsBase::BindingProperty property);
 
 protected:
     explicit AnchorsBase(AnchorsBasePrivate *dd);
@@ -266,32 +421,288 @@ private:
     AnchorsBasePrivate *d_ptr = NULL;
 
     Q_DECLARE_PRIVATE(AnchorsBase)
+
+    friend struct AnchorInfo;
+    friend class AnchorsBasePrivate;
+    friend class AnchorsTemplate;
+    friend class AnchorsTemplatePrivate;
+    friend class AnchorLayout;
+    friend class AnchorLayoutPrivate;
+    friend class AnchorsTransactionPrivate;
+    friend class AnchorsLayoutCachePrivate;
+    friend class AnchorsIncrementalLayoutPrivate;
+    friend class AnchorsViewportCullingPrivate;
+};
+
+class AnchorsTransactionPrivate;
+class AnchorsTransaction
+{
+public:
+    AnchorsTransaction();
+    ~AnchorsTransaction();
+
+    bool isActive() const;
+    AnchorsBase::AnchorError errorCode() const;
+    QString errorString() const;
+
+    bool commit();
+    void rollback();
+
+private:
+    AnchorsTransactionPrivate *d_ptr;
+
+    Q_DISABLE_COPY(AnchorsTransaction)
+    Q_DECLARE_PRIVATE(AnchorsTransaction)
+};
+
+class AnchorsVariables
+{
+public:
+    static bool contains(const QString &name);
+    static int value(const QString &name);
+    static QStringList names();
+    static int dependentCount(const QString &name);
+
+    static void setValue(const QString &name, int value);
+    static void setValues(const QHash<QString, int> &values);
+    static void remove(const QString &name);
+
+private:
+    AnchorsVariables();
+};
+
+class AnchorsTemplatePrivate;
+class AnchorsTemplate
+{
+public:
+    enum Target {
+        NoTarget,
+        ParentTarget,
+        PreviousTarget,
+        NextTarget
+    };
+
+    AnchorsTemplate();
+    AnchorsTemplate(const AnchorsTemplate &other);
+    ~AnchorsTemplate();
+
+    AnchorsTemplate &operator=(const AnchorsTemplate &other);
+
+    Target anchorTarget(Qt::AnchorPoint point) const;
+    Qt::AnchorPoint anchorTargetPoint(Qt::AnchorPoint point) const;
+    Target fill() const;
+    Target centerIn() const;
+    int margin(AnchorsBase::MarginProperty property) const;
+    bool alignWhenCentered() const;
+    qreal aspectRatio() const;
+
+    AnchorsTemplate &setAnchor(Qt::AnchorPoint point, Target target, Qt::AnchorPoint targetPoint);
+    AnchorsTemplate &setFill(Target target);
+    AnchorsTemplate &setCenterIn(Target target);
+    AnchorsTemplate &setMargin(AnchorsBase::MarginProperty property, int value);
+    AnchorsTemplate &setAlignWhenCentered(bool alignWhenCentered);
+    AnchorsTemplate &setAspectRatio(qreal aspectRatio);
+
+    bool apply(QWidget *w) const;
+    bool apply(const QList<QWidget *> &widgets) const;
+
+private:
+    QExplicitlySharedDataPointer<AnchorsTemplatePrivate> d_ptr;
+
+    Q_DECLARE_PRIVATE(AnchorsTemplate)
+};
+
+class AnchorsLayoutCachePrivate;
+class AnchorsLayoutCache : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int capacity READ capacity WRITE setCapacity)
+
+public:
+    explicit AnchorsLayoutCache(QWidget *root);
+    ~AnchorsLayoutCache();
+
+    QWidget *root() const;
+    int capacity() const;
+    int count() const;
+    int hits() const;
+    int misses() const;
+
+public slots:
+    void setCapacity(int capacity);
+    void invalidate();
+
+private:
+    AnchorsLayoutCachePrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(AnchorsLayoutCache)
+};
+
+class AnchorsScheduler
+{
+public:
+    enum Priority {
+        Immediate,
+        Idle,
+        Suspended
+    };
+
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+    static Priority priority(const QWidget *window);
+    static int pendingCount(const QWidget *window = 0);
+    static void flush(const QWidget *window = 0);
+
+private:
+    AnchorsScheduler();
+};
+
+class AnchorsIncrementalLayoutPrivate;
+class AnchorsIncrementalLayout : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int budget READ budget WRITE setBudget NOTIFY budgetChanged)
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
+    Q_PROPERTY(bool settled READ isSettled NOTIFY settled)
+
+public:
+    explicit AnchorsIncrementalLayout(QObject *parent = 0);
+    ~AnchorsIncrementalLayout();
+
+    int budget() const;
+    bool isActive() const;
+    bool isSettled() const;
+    int pendingCount() const;
+
+public slots:
+    void setBudget(int msecs);
+    void start();
+    void stop();
+
+signals:
+    void budgetChanged(int msecs);
+    void activeChanged(bool active);
+    void settled();
+    void overrun(qint64 nsecs, int processed);
+
+protected:
+    void timerEvent(QTimerEvent *e) Q_DECL_OVERRIDE;
+
+private:
+    AnchorsIncrementalLayoutPrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(AnchorsIncrementalLayout)
+};
+
+class QScrollArea;
+class AnchorsViewportCullingPrivate;
+class AnchorsViewportCulling : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int margin READ margin WRITE setMargin NOTIFY marginChanged)
+    Q_PROPERTY(Qt::Orientation orientation READ orientation WRITE setOrientation NOTIFY orientationChanged)
+
+public:
+    explicit AnchorsViewportCulling(QScrollArea *area);
+    ~AnchorsViewportCulling();
+
+    QScrollArea *scrollArea() const;
+    int margin() const;
+    Qt::Orientation orientation() const;
+    int pendingCount() const;
+
+public slots:
+    void setMargin(int margin);
+    void setOrientation(Qt::Orientation orientation);
+    void resolveAll();
+
+signals:
+    void marginChanged(int margin);
+    void orientationChanged(Qt::Orientation orientation);
+
+protected:
+    bool eventFilter(QObject *o, QEvent *e) Q_DECL_OVERRIDE;
+
+private slots:
+    void updateViewport();
+
+private:
+    AnchorsViewportCullingPrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(AnchorsViewportCulling)
+};
+
+class AnchorLayoutPrivate;
+class AnchorLayout : public QLayout
+{
+    Q_OBJECT
+
+public:
+    explicit AnchorLayout(QWidget *parent = 0);
+    ~AnchorLayout();
+
+    void addItem(QLayoutItem *item) Q_DECL_OVERRIDE;
+    QLayoutItem *itemAt(int index) const Q_DECL_OVERRIDE;
+    QLayoutItem *takeAt(int index) Q_DECL_OVERRIDE;
+    int count() const Q_DECL_OVERRIDE;
+
+    QSize sizeHint() const Q_DECL_OVERRIDE;
+    QSize minimumSize() const Q_DECL_OVERRIDE;
+    Qt::Orientations expandingDirections() const Q_DECL_OVERRIDE;
+    void setGeometry(const QRect &rect) Q_DECL_OVERRIDE;
+    void invalidate() Q_DECL_OVERRIDE;
+
+private:
+    AnchorLayoutPrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(AnchorLayout)
+
+    friend class AnchorsBasePrivate;
 };
 
 template<class T>
-class Anchors : public AnchorsBase
+class Anchors
 {
 public:
-    inline Anchors(): AnchorsBase((QWidget*)NULL), m_widget(NULL) {}
-    inline Anchors(T *w): AnchorsBase(w), m_widget(w) {}
-    inline Anchors(const Anchors &me): AnchorsBase(me.m_widget), m_widget(me.m_widget) {}
+    inline Anchors(): m_widget(NULL) {}
+    inline Anchors(T *w): m_widget(w) {}
+    inline Anchors(const Anchors &me) = default;
+    inline Anchors(Anchors &&me): m_widget(me.m_widget), m_base(me.m_base)
+    {
+        me.m_widget = NULL;
+        me.m_base = NULL;
+    }
 
-    inline T &operator=(const Anchors &me)
+    inline Anchors &operator=(const Anchors &me) = default;
+    inline Anchors &operator=(Anchors &&me)
     {
-        m_widget = me.m_widget;
-        init(m_widget);
-        return *m_widget;
+        qSwap(m_widget, me.m_widget);
+        qSwap(m_base, me.m_base);
+        return *this;
     }
-    inline T &operator=(T *w)
+    inline Anchors &operator=(T *w)
     {
-        m_widget = w;
-        init(w);
-        return *m_widget;
+        if (m_widget != w) {
+            m_widget = w;
+            m_base = NULL;
+        }
+        return *this;
     }
+
     inline T *widget() const
     {
         return m_widget;
     }
+    inline AnchorsBase *base() const
+    {
+        if (!m_base) {
+            m_base = AnchorsBase::createAnchorBase(m_widget);
+        }
+        return m_base;
+    }
     inline T *operator ->() const
     {
         return m_widget;
@@ -309,8 +720,105 @@ public:
         return *m_widget;
     }
 
+    // a handle without a widget reads as unanchored and ignores changes
+    inline QWidget *target() const { return m_widget ? base()->target() : NULL; }
+    inline bool enabled() const { return m_widget ? base()->enabled() : false; }
+    inline const AnchorInfo *top() const { return m_widget ? base()->top() : NULL; }
+    inline const AnchorInfo *bottom() const { return m_widget ? base()->bottom() : NULL; }
+    inline const AnchorInfo *left() const { return m_widget ? base()->left() : NULL; }
+    inline const AnchorInfo *right() const { return m_widget ? base()->right() : NULL; }
+    inline const AnchorInfo *horizontalCenter() const { return m_widget ? base()->horizontalCenter() : NULL; }
+    inline const AnchorInfo *verticalCenter() const { return m_widget ? base()->verticalCenter() : NULL; }
+    inline QWidget *fill() const { return m_widget ? base()->fill() : NULL; }
+    inline QWidget *centerIn() const { return m_widget ? base()->centerIn() : NULL; }
+    inline int margins() const { return m_widget ? base()->margins() : 0; }
+    inline int topMargin() const { return m_widget ? base()->topMargin() : 0; }
+    inline int bottomMargin() const { return m_widget ? base()->bottomMargin() : 0; }
+    inline int leftMargin() const { return m_widget ? base()->leftMargin() : 0; }
+    inline int rightMargin() const { return m_widget ? base()->rightMargin() : 0; }
+    inline int horizontalCenterOffset() const { return m_widget ? base()->horizontalCenterOffset() : 0; }
+    inline int verticalCenterOffset() const { return m_widget ? base()->verticalCenterOffset() : 0; }
+    inline int alignWhenCentered() const { return m_widget ? base()->alignWhenCentered() : 0; }
+    inline qreal aspectRatio() const { return m_widget ? base()->aspectRatio() : 0; }
+    inline AnchorsBase::AnchorError errorCode() const { return m_widget ? base()->errorCode() : AnchorsBase::NoError; }
+    inline QString errorString() const { return m_widget ? base()->errorString() : QString(); }
+    inline bool isBinding(const AnchorInfo *info) const { return m_widget ? base()->isBinding(info) : false; }
+    inline bool hasBinding(AnchorsBase::BindingProperty property) const { return m_widget ? base()->hasBinding(property) : false; }
+    inline QList<QWidget *> bindingDependencies(AnchorsBase::BindingProperty property) const
+    {
+        return m_widget ? base()->bindingDependencies(property) : QList<QWidget *>();
+    }
+    inline QString marginVariable(AnchorsBase::MarginProperty property) const
+    {
+        return m_widget ? base()->marginVariable(property) : QString();
+    }
+    inline qreal valueOf(Qt::AnchorPoint point) const { return AnchorsBase::valueOf(m_widget, point); }
+    inline int widthOf() const { return AnchorsBase::widthOf(m_widget); }
+    inline int heightOf() const { return AnchorsBase::heightOf(m_widget); }
+
+    inline void setEnabled(bool enabled) { if (m_widget) { base()->setEnabled(enabled); } }
+    inline bool setAnchor(const Qt::AnchorPoint &p, QWidget *target, const Qt::AnchorPoint &point)
+    {
+        return m_widget ? base()->setAnchor(p, target, point) : false;
+    }
+    inline bool setTop(const AnchorInfo *top) { return m_widget ? base()->setTop(top) : false; }
+    inline bool setBottom(const AnchorInfo *bottom) { return m_widget ? base()->setBottom(bottom) : false; }
+    inline bool setLeft(const AnchorInfo *left) { return m_widget ? base()->setLeft(left) : false; }
+    inline bool setRight(const AnchorInfo *right) { return m_widget ? base()->setRight(right) : false; }
+    inline bool setHorizontalCenter(const AnchorInfo *horizontalCenter) { return m_widget ? base()->setHorizontalCenter(horizontalCenter) : false; }
+    inline bool setVerticalCenter(const AnchorInfo *verticalCenter) { return m_widget ? base()->setVerticalCenter(verticalCenter) : false; }
+    inline bool setFill(QWidget *fill) { return m_widget ? base()->setFill(fill) : false; }
+    inline bool setCenterIn(QWidget *centerIn) { return m_widget ? base()->setCenterIn(centerIn) : false; }
+    inline bool setFill(AnchorsBase *fill) { return m_widget ? base()->setFill(fill) : false; }
+    inline bool setCenterIn(AnchorsBase *centerIn) { return m_widget ? base()->setCenterIn(centerIn) : false; }
+    template<class U>
+    inline bool setFill(const Anchors<U> &fill) { return m_widget ? base()->setFill(fill.widget()) : false; }
+    template<class U>
+    inline bool setCenterIn(const Anchors<U> &centerIn) { return m_widget ? base()->setCenterIn(centerIn.widget()) : false; }
+    inline void setMargins(int margins) { if (m_widget) { base()->setMargins(margins); } }
+    inline void setTopMargin(int topMargin) { if (m_widget) { base()->setTopMargin(topMargin); } }
+    inline void setBottomMargin(int bottomMargin) { if (m_widget) { base()->setBottomMargin(bottomMargin); } }
+    inline void setLeftMargin(int leftMargin) { if (m_widget) { base()->setLeftMargin(leftMargin); } }
+    inline void setRightMargin(int rightMargin) { if (m_widget) { base()->setRightMargin(rightMargin); } }
+    inline void setHorizontalCenterOffset(int horizontalCenterOffset) { if (m_widget) { base()->setHorizontalCenterOffset(horizontalCenterOffset); } }
+    inline void setVerticalCenterOffset(int verticalCenterOffset) { if (m_widget) { base()->setVerticalCenterOffset(verticalCenterOffset); } }
+    inline void setAlignWhenCentered(bool alignWhenCentered) { if (m_widget) { base()->setAlignWhenCentered(alignWhenCentered); } }
+    inline void setAspectRatio(qreal aspectRatio) { if (m_widget) { base()->setAspectRatio(aspectRatio); } }
+    inline bool setBinding(AnchorsBase::BindingProperty property, const std::function<qreal()> &expression)
+    {
+        return m_widget ? base()->setBinding(property, expression) : false;
+    }
+    inline bool setSizeBinding(AnchorsBase::BindingProperty property, QWidget *source,
+                               AnchorsBase::BindingProperty sourceProperty, qreal ratio = 1, int offset = 0)
+    {
+        return m_widget ? base()->setSizeBinding(property, source, sourceProperty, ratio, offset) : false;
+    }
+    inline void clearBinding(AnchorsBase::BindingProperty property) { if (m_widget) { base()->clearBinding(property); } }
+    inline bool setMarginVariable(AnchorsBase::MarginProperty property, const QString &name)
+    {
+        return m_widget ? base()->setMarginVariable(property, name) : false;
+    }
+    inline void clearMarginVariable(AnchorsBase::MarginProperty property) { if (m_widget) { base()->clearMarginVariable(property); } }
+
+    inline void setTop(int arg, Qt::AnchorPoint point) { if (m_widget) { base()->setTop(arg, point); } }
+    inline void setBottom(int arg, Qt::AnchorPoint point) { if (m_widget) { base()->setBottom(arg, point); } }
+    inline void setLeft(int arg, Qt::AnchorPoint point) { if (m_widget) { base()->setLeft(arg, point); } }
+    inline void setRight(int arg, Qt::AnchorPoint point) { if (m_widget) { base()->setRight(arg, point); } }
+    inline void setHorizontalCenter(int arg, Qt::AnchorPoint point) { if (m_widget) { base()->setHorizontalCenter(arg, point); } }
+    inline void setVerticalCenter(int arg, Qt::AnchorPoint point) { if (m_widget) { base()->setVerticalCenter(arg, point); } }
+
+    inline void moveTop(int arg) { if (m_widget) { base()->moveTop(arg); } }
+    inline void moveBottom(int arg) { if (m_widget) { base()->moveBottom(arg); } }
+    inline void moveLeft(int arg) { if (m_widget) { base()->moveLeft(arg); } }
+    inline void moveRight(int arg) { if (m_widget) { base()->moveRight(arg); } }
+    inline void moveHorizontalCenter(int arg) { if (m_widget) { base()->moveHorizontalCenter(arg); } }
+    inline void moveVerticalCenter(int arg) { if (m_widget) { base()->moveVerticalCenter(arg); } }
+    inline void moveCenter(const QPoint &arg) { if (m_widget) { base()->moveCenter(arg); } }
+
 private:
     T *m_widget;
+    // the anchor state is owned by the widget, handles only cache a weak reference
+    mutable QPointer<AnchorsBase> m_base;
 };
 
 #endif // ANCHORS_H
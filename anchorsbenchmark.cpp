@@ -0,0 +1,402 @@
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QMouseEvent>
+#include <QPair>
+#include <QWidget>
+#include <QtMath>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "anchors.h"
+#include "anchorsbenchmark.h"
+#include "anchorsgraph.h"
+#include "dragwidget.h"
+
+class AnchorsBenchmarkCounter : public AnchorsObserver
+{
+public:
+    void updateEnd(const QWidget *w, UpdateType type, qint64 nsecs) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(w)
+        Q_UNUSED(type)
+        Q_UNUSED(nsecs)
+
+        ++updates;
+    }
+
+    void geometryCommitted(const QWidget *w, const QRect &geometry) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(w)
+        Q_UNUSED(geometry)
+
+        ++commits;
+    }
+
+    int commits = 0;
+    int updates = 0;
+};
+
+class AnchorsBenchmarkPrivate
+{
+    explicit AnchorsBenchmarkPrivate(AnchorsBenchmark *qq): q_ptr(qq) {}
+
+    // xorshift32, so that a seed generates the same shape on every platform
+    quint32 random()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        return state;
+    }
+
+    qreal uniform()
+    {
+        return random() / 4294967296.0;
+    }
+
+    DragWidget *create()
+    {
+        DragWidget *w = new DragWidget(root);
+
+        w->resize(24 + random() % 24, 16 + random() % 16);
+        ++widgetCount;
+
+        return w;
+    }
+
+    void anchorToRoot(DragWidget *w, int index)
+    {
+        AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+        switch (index % 3) {
+        case 0:
+            base->setAnchor(Qt::AnchorLeft, root, Qt::AnchorLeft);
+            base->setAnchor(Qt::AnchorTop, root, Qt::AnchorTop);
+            base->setMargins(1 + random() % 200);
+            break;
+        case 1:
+            base->setAnchor(Qt::AnchorRight, root, Qt::AnchorRight);
+            base->setAnchor(Qt::AnchorBottom, root, Qt::AnchorBottom);
+            base->setMargins(1 + random() % 200);
+            break;
+        default:
+            base->setAnchor(Qt::AnchorHorizontalCenter, root, Qt::AnchorHorizontalCenter);
+            base->setAnchor(Qt::AnchorVerticalCenter, root, Qt::AnchorVerticalCenter);
+            base->setHorizontalCenterOffset(int(random() % 300) - 150);
+            base->setVerticalCenterOffset(int(random() % 200) - 100);
+            break;
+        }
+
+        anchored << base;
+    }
+
+    void anchorTo(DragWidget *w, DragWidget *target)
+    {
+        AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+        AnchorsBase *target_base = AnchorsBase::createAnchorBase(target);
+        qreal r = uniform();
+
+        if (r < shape.fillShare) {
+            base->setFill(target);
+        } else if (r < shape.fillShare + shape.centerInShare) {
+            base->setCenterIn(target);
+        } else if (random() % 2) {
+            base->setTop(target_base->bottom());
+            base->setLeft(target_base->left());
+        } else {
+            base->setLeft(target_base->right());
+            base->setTop(target_base->top());
+        }
+
+        base->setMargins(4);
+        anchored << base;
+    }
+
+    // trees of anchor chains: every head is either anchored to the root, so
+    // window resizes move it, or left free to be dragged around
+    void build()
+    {
+        AnchorsTransaction transaction;
+        int tree = 0;
+
+        while (widgetCount < shape.widgets) {
+            DragWidget *head = create();
+
+            if (tree % 2) {
+                head->move(random() % 700, random() % 500);
+                draggable << head;
+            } else {
+                anchorToRoot(head, tree / 2);
+            }
+
+            QList<QPair<DragWidget *, int> > queue;
+            queue << qMakePair(head, 1);
+
+            while (!queue.isEmpty() && widgetCount < shape.widgets) {
+                QPair<DragWidget *, int> node = queue.takeFirst();
+
+                if (node.second >= shape.depth) {
+                    continue;
+                }
+
+                for (int i = 0; i < shape.fanOut && widgetCount < shape.widgets; ++i) {
+                    DragWidget *child = create();
+
+                    anchorTo(child, node.first);
+                    queue << qMakePair(child, node.second + 1);
+                }
+            }
+
+            ++tree;
+        }
+    }
+
+    int changeMargins()
+    {
+        if (anchored.isEmpty()) {
+            return 0;
+        }
+
+        marginDebt += shape.marginChangeRate * anchored.size();
+
+        int count = int(marginDebt);
+        marginDebt -= count;
+
+        if (!count) {
+            return 0;
+        }
+
+        AnchorsTransaction transaction;
+
+        for (int i = 0; i < count; ++i) {
+            AnchorsBase *base = anchored.at(random() % anchored.size());
+
+            base->setMargins(base->margins() == 4 ? 8 : 4);
+        }
+
+        return count;
+    }
+
+    AnchorsBenchmarkShape shape;
+    QString graphFileName;
+    AnchorsEngine *engine = NULL;
+    AnchorsEngine *reference = NULL;
+    AnchorsEngineComparison comparison;
+    QWidget *root = NULL;
+    QList<DragWidget *> draggable;
+    QList<AnchorsBase *> anchored;
+    quint32 state = 1;
+    qreal marginDebt = 0;
+    int widgetCount = 0;
+    int anchoredCount = 0;
+
+    AnchorsBenchmark *q_ptr;
+
+    Q_DECLARE_PUBLIC(AnchorsBenchmark)
+};
+
+AnchorsBenchmark::AnchorsBenchmark(const AnchorsBenchmarkShape &shape):
+    d_ptr(new AnchorsBenchmarkPrivate(this))
+{
+    Q_D(AnchorsBenchmark);
+
+    d->shape = shape;
+}
+
+AnchorsBenchmark::~AnchorsBenchmark()
+{
+    delete d_ptr;
+}
+
+AnchorsBenchmarkShape AnchorsBenchmark::shape() const
+{
+    Q_D(const AnchorsBenchmark);
+
+    return d->shape;
+}
+
+int AnchorsBenchmark::widgetCount() const
+{
+    Q_D(const AnchorsBenchmark);
+
+    return d->widgetCount;
+}
+
+int AnchorsBenchmark::anchoredCount() const
+{
+    Q_D(const AnchorsBenchmark);
+
+    return d->anchoredCount;
+}
+
+QString AnchorsBenchmark::graphFileName() const
+{
+    Q_D(const AnchorsBenchmark);
+
+    return d->graphFileName;
+}
+
+AnchorsEngine *AnchorsBenchmark::engine() const
+{
+    Q_D(const AnchorsBenchmark);
+
+    return d->engine;
+}
+
+AnchorsEngine *AnchorsBenchmark::referenceEngine() const
+{
+    Q_D(const AnchorsBenchmark);
+
+    return d->reference;
+}
+
+AnchorsEngineComparison AnchorsBenchmark::comparison() const
+{
+    Q_D(const AnchorsBenchmark);
+
+    return d->comparison;
+}
+
+void AnchorsBenchmark::setGraphFileName(const QString &fileName)
+{
+    Q_D(AnchorsBenchmark);
+
+    d->graphFileName = fileName;
+}
+
+void AnchorsBenchmark::setEngine(AnchorsEngine *engine, AnchorsEngine *reference)
+{
+    Q_D(AnchorsBenchmark);
+
+    d->engine = engine;
+    d->reference = reference;
+}
+
+QList<AnchorsBenchmarkPass> AnchorsBenchmark::run()
+{
+    Q_D(AnchorsBenchmark);
+
+    QList<AnchorsBenchmarkPass> passes;
+    QWidget root;
+
+    root.setAttribute(Qt::WA_DontShowOnScreen);
+    root.resize(800, 600);
+
+    // the initial layout already goes through the selected engines
+    if (d->reference) {
+        AnchorsEngine::compare(&root, d->engine ? d->engine : AnchorsEngine::cascade(), d->reference);
+    } else {
+        AnchorsEngine::setEngine(&root, d->engine);
+    }
+
+    d->root = &root;
+    d->state = d->shape.seed ? d->shape.seed : 1;
+    d->marginDebt = 0;
+    d->widgetCount = 0;
+    d->build();
+    d->anchoredCount = d->anchored.size();
+
+    root.show();
+    QCoreApplication::processEvents();
+
+    if (!d->graphFileName.isEmpty()) {
+        AnchorsGraph graph(&root);
+
+        if (!graph.save(d->graphFileName)) {
+            qWarning() << d->graphFileName << graph.errorString();
+        }
+    }
+
+    AnchorsBenchmarkCounter counter;
+    int total = d->shape.drags + d->shape.resizes;
+
+    for (int i = 0; i < total; ++i) {
+        bool resize = qint64(i + 1) * d->shape.resizes / total > qint64(i) * d->shape.resizes / total;
+        AnchorsBenchmarkPass pass;
+        QElapsedTimer timer;
+
+        if (d->draggable.isEmpty()) {
+            resize = true;
+        }
+
+        counter.commits = 0;
+        counter.updates = 0;
+
+        if (resize) {
+            int step = i % 16;
+
+            timer.start();
+            pass.marginChanges = d->changeMargins();
+            root.resize(800 + step * 12, 600 + step * 8);
+            pass.nsecs = timer.nsecsElapsed();
+            pass.kind = AnchorsBenchmarkPass::Resize;
+        } else {
+            DragWidget *w = d->draggable.at(i % d->draggable.size());
+            QPoint pos = w->rect().center();
+            // zig-zag so that the dragged heads stay around their start position
+            QPoint delta = (i / d->draggable.size()) % 2 ? QPoint(-3, -2) : QPoint(3, 2);
+            QMouseEvent press(QEvent::MouseButtonPress, pos, Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+            QMouseEvent move(QEvent::MouseMove, pos + delta, Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+            QMouseEvent release(QEvent::MouseButtonRelease, pos + delta, Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+
+            QApplication::sendEvent(w, &press);
+            timer.start();
+            pass.marginChanges = d->changeMargins();
+            QApplication::sendEvent(w, &move);
+            pass.nsecs = timer.nsecsElapsed();
+            QApplication::sendEvent(w, &release);
+            pass.kind = AnchorsBenchmarkPass::Drag;
+        }
+
+        pass.commits = counter.commits;
+        pass.updates = counter.updates;
+        passes << pass;
+    }
+
+    d->comparison = AnchorsEngine::comparison(&root);
+    AnchorsEngine::setEngine(&root, NULL);
+
+    d->draggable.clear();
+    d->anchored.clear();
+    d->root = NULL;
+
+    return passes;
+}
+
+qint64 AnchorsBenchmark::percentile(const QList<AnchorsBenchmarkPass> &passes, qreal ratio)
+{
+    if (passes.isEmpty()) {
+        return 0;
+    }
+
+    QList<qint64> values;
+    foreach (const AnchorsBenchmarkPass &pass, passes) {
+        values << pass.nsecs;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    return values.at(qBound(0, qCeil(ratio * values.size()) - 1, values.size() - 1));
+}
+
+qint64 AnchorsBenchmark::peakMemoryUsage()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef Q_OS_MAC
+        return usage.ru_maxrss;
+#else
+        return qint64(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+
+    return -1;
+}
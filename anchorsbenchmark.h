@@ -0,0 +1,62 @@
+#ifndef ANCHORSBENCHMARK_H
+#define ANCHORSBENCHMARK_H
+
+#include <QList>
+#include <QString>
+
+#include "anchors.h"
+
+struct AnchorsBenchmarkShape {
+    int widgets = 500;
+    int depth = 4;
+    int fanOut = 2;
+    qreal fillShare = 0.1;
+    qreal centerInShare = 0.1;
+    qreal marginChangeRate = 0.02;
+    int drags = 500;
+    int resizes = 500;
+    uint seed = 1;
+};
+
+struct AnchorsBenchmarkPass {
+    enum Kind {
+        Drag,
+        Resize
+    };
+
+    Kind kind;
+    qint64 nsecs;
+    int commits;
+    int updates;
+    int marginChanges;
+};
+
+class AnchorsBenchmarkPrivate;
+class AnchorsBenchmark
+{
+public:
+    explicit AnchorsBenchmark(const AnchorsBenchmarkShape &shape = AnchorsBenchmarkShape());
+    ~AnchorsBenchmark();
+
+    AnchorsBenchmarkShape shape() const;
+    int widgetCount() const;
+    int anchoredCount() const;
+    QString graphFileName() const;
+    AnchorsEngine *engine() const;
+    AnchorsEngine *referenceEngine() const;
+    AnchorsEngineComparison comparison() const;
+
+    void setGraphFileName(const QString &fileName);
+    void setEngine(AnchorsEngine *engine, AnchorsEngine *reference = 0);
+    QList<AnchorsBenchmarkPass> run();
+
+    static qint64 percentile(const QList<AnchorsBenchmarkPass> &passes, qreal ratio);
+    static qint64 peakMemoryUsage();
+
+private:
+    AnchorsBenchmarkPrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(AnchorsBenchmark)
+};
+
+#endif // ANCHORSBENCHMARK_H
@@ -0,0 +1,572 @@
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPair>
+#include <QSet>
+#include <QVector>
+#include <QWidget>
+
+#include <algorithm>
+
+#include "anchorsgraph.h"
+
+class AnchorsGraphPrivate
+{
+    explicit AnchorsGraphPrivate(AnchorsGraph *qq): q_ptr(qq) {}
+
+    static const char *pointName(Qt::AnchorPoint point)
+    {
+        switch (point) {
+        case Qt::AnchorLeft:
+            return "left";
+        case Qt::AnchorHorizontalCenter:
+            return "horizontalCenter";
+        case Qt::AnchorRight:
+            return "right";
+        case Qt::AnchorTop:
+            return "top";
+        case Qt::AnchorVerticalCenter:
+            return "verticalCenter";
+        default:
+            return "bottom";
+        }
+    }
+
+    static const char *propertyName(AnchorsBase::BindingProperty property)
+    {
+        switch (property) {
+        case AnchorsBase::WidthProperty:
+            return "width";
+        case AnchorsBase::HeightProperty:
+            return "height";
+        default:
+            return pointName(Qt::AnchorPoint(property));
+        }
+    }
+
+    static const char *kindName(AnchorsGraphEdge::Kind kind)
+    {
+        switch (kind) {
+        case AnchorsGraphEdge::Fill:
+            return "fill";
+        case AnchorsGraphEdge::CenterIn:
+            return "centerIn";
+        case AnchorsGraphEdge::Binding:
+            return "binding";
+        default:
+            return "anchor";
+        }
+    }
+
+    static int margin(const AnchorsBase *base, Qt::AnchorPoint point)
+    {
+        int margin = 0;
+
+        switch (point) {
+        case Qt::AnchorLeft:
+            margin = base->leftMargin();
+            break;
+        case Qt::AnchorRight:
+            margin = base->rightMargin();
+            break;
+        case Qt::AnchorTop:
+            margin = base->topMargin();
+            break;
+        case Qt::AnchorBottom:
+            margin = base->bottomMargin();
+            break;
+        case Qt::AnchorHorizontalCenter:
+            return base->horizontalCenterOffset();
+        default:
+            return base->verticalCenterOffset();
+        }
+
+        return margin == 0 ? base->margins() : margin;
+    }
+
+    int nodeOf(const QWidget *w)
+    {
+        int index = indexes.value(w, -1);
+
+        if (index < 0) {
+            AnchorsGraphNode node;
+
+            node.widget = w;
+            node.name = w->objectName().isEmpty() ? QString(w->metaObject()->className()) : w->objectName();
+            node.geometry = w->geometry();
+            node.fanIn = 0;
+            node.fanOut = 0;
+            node.depth = 0;
+
+            index = nodes.size();
+            indexes[w] = index;
+            nodes << node;
+        }
+
+        return index;
+    }
+
+    void addEdge(AnchorsGraphEdge::Kind kind, const QWidget *from, const QWidget *to, int margin,
+                 Qt::AnchorPoint point = Qt::AnchorLeft, Qt::AnchorPoint targetPoint = Qt::AnchorLeft,
+                 AnchorsBase::BindingProperty property = AnchorsBase::LeftProperty)
+    {
+        AnchorsGraphEdge edge;
+
+        edge.kind = kind;
+        edge.from = nodeOf(from);
+        edge.to = nodeOf(to);
+        edge.point = point;
+        edge.targetPoint = targetPoint;
+        edge.property = property;
+        edge.margin = margin;
+
+        edges << edge;
+    }
+
+    void collect(const QWidget *w)
+    {
+        const AnchorsBase *base = AnchorsBase::getAnchorBaseByWidget(w);
+
+        if (!base) {
+            return;
+        }
+
+        const AnchorInfo *infos[] = {base->top(), base->bottom(), base->left(), base->right(),
+                                     base->horizontalCenter(), base->verticalCenter()};
+
+        for (int i = 0; i < 6; ++i) {
+            const AnchorInfo *target = infos[i]->targetInfo;
+
+            if (target) {
+                addEdge(AnchorsGraphEdge::Anchor, w, target->base->target(), margin(base, infos[i]->type),
+                        infos[i]->type, target->type);
+            }
+        }
+
+        if (base->fill()) {
+            addEdge(AnchorsGraphEdge::Fill, w, base->fill(), base->margins());
+        }
+        if (base->centerIn()) {
+            addEdge(AnchorsGraphEdge::CenterIn, w, base->centerIn(), 0);
+        }
+
+        for (int p = AnchorsBase::LeftProperty; p <= AnchorsBase::HeightProperty; ++p) {
+            AnchorsBase::BindingProperty property = AnchorsBase::BindingProperty(p);
+
+            foreach (QWidget *dependency, base->bindingDependencies(property)) {
+                // reading its own geometry is no dependency between widgets
+                if (dependency != w) {
+                    addEdge(AnchorsGraphEdge::Binding, w, dependency, 0, Qt::AnchorLeft, Qt::AnchorLeft, property);
+                }
+            }
+        }
+    }
+
+    // the length of the longest anchor chain ending at the node, loops can
+    // only come from expression bindings and are cut where they close
+    int depthOf(int index)
+    {
+        if (state.at(index) == Done) {
+            return nodes.at(index).depth;
+        }
+        if (state.at(index) == Visiting) {
+            return -1;
+        }
+
+        state[index] = Visiting;
+
+        int depth = 0;
+        foreach (int target, targets.at(index)) {
+            int d = depthOf(target);
+
+            if (d >= 0 && d + 1 > depth) {
+                depth = d + 1;
+                next[index] = target;
+            }
+        }
+
+        state[index] = Done;
+        nodes[index].depth = depth;
+
+        return depth;
+    }
+
+    void analyze()
+    {
+        int count = nodes.size();
+
+        targets = QVector<QList<int> >(count);
+        dependents = QVector<QList<int> >(count);
+        next = QVector<int>(count, -1);
+        state = QVector<int>(count, Unvisited);
+
+        foreach (const AnchorsGraphEdge &edge, edges) {
+            if (!targets.at(edge.from).contains(edge.to)) {
+                targets[edge.from] << edge.to;
+                dependents[edge.to] << edge.from;
+            }
+        }
+
+        for (int i = 0; i < count; ++i) {
+            nodes[i].fanIn = dependents.at(i).size();
+            nodes[i].fanOut = targets.at(i).size();
+        }
+        for (int i = 0; i < count; ++i) {
+            depthOf(i);
+        }
+    }
+
+    QList<int> ranked(int count, int AnchorsGraphNode::*field) const
+    {
+        QList<QPair<int, int> > list;
+
+        for (int i = 0; i < nodes.size(); ++i) {
+            int value = nodes.at(i).*field;
+
+            if (value > 0) {
+                list << qMakePair(-value, i);
+            }
+        }
+
+        std::sort(list.begin(), list.end());
+
+        QList<int> result;
+        for (int i = 0; i < list.size() && i < count; ++i) {
+            result << list.at(i).second;
+        }
+
+        return result;
+    }
+
+    enum {
+        Unvisited,
+        Visiting,
+        Done
+    };
+
+    const QWidget *window = NULL;
+    QList<AnchorsGraphNode> nodes;
+    QList<AnchorsGraphEdge> edges;
+    QHash<const QWidget *, int> indexes;
+    QVector<QList<int> > targets;
+    QVector<QList<int> > dependents;
+    QVector<int> next;
+    QVector<int> state;
+    QString errorString;
+
+    AnchorsGraph *q_ptr;
+
+    Q_DECLARE_PUBLIC(AnchorsGraph)
+};
+
+AnchorsGraph::AnchorsGraph(const QWidget *window):
+    d_ptr(new AnchorsGraphPrivate(this))
+{
+    if (window) {
+        rebuild(window);
+    }
+}
+
+AnchorsGraph::~AnchorsGraph()
+{
+    delete d_ptr;
+}
+
+const QWidget *AnchorsGraph::window() const
+{
+    Q_D(const AnchorsGraph);
+
+    return d->window;
+}
+
+QList<AnchorsGraphNode> AnchorsGraph::nodes() const
+{
+    Q_D(const AnchorsGraph);
+
+    return d->nodes;
+}
+
+QList<AnchorsGraphEdge> AnchorsGraph::edges() const
+{
+    Q_D(const AnchorsGraph);
+
+    return d->edges;
+}
+
+QString AnchorsGraph::errorString() const
+{
+    Q_D(const AnchorsGraph);
+
+    return d->errorString;
+}
+
+QList<QList<int> > AnchorsGraph::longestChains(int count) const
+{
+    Q_D(const AnchorsGraph);
+
+    QList<QList<int> > chains;
+    QSet<int> used;
+
+    // chains are reported from the widget that moves first to the one that
+    // is reached last, a node shows up in one chain at most
+    foreach (int index, d->ranked(d->nodes.size(), &AnchorsGraphNode::depth)) {
+        if (chains.size() >= count) {
+            break;
+        }
+        if (used.contains(index)) {
+            continue;
+        }
+
+        QList<int> chain;
+        for (int i = index; i >= 0; i = d->next.at(i)) {
+            chain.prepend(i);
+            used << i;
+        }
+
+        chains << chain;
+    }
+
+    return chains;
+}
+
+QList<int> AnchorsGraph::highestFanIn(int count) const
+{
+    Q_D(const AnchorsGraph);
+
+    return d->ranked(count, &AnchorsGraphNode::fanIn);
+}
+
+QList<int> AnchorsGraph::highestFanOut(int count) const
+{
+    Q_D(const AnchorsGraph);
+
+    return d->ranked(count, &AnchorsGraphNode::fanOut);
+}
+
+QList<int> AnchorsGraph::touchedByResize() const
+{
+    Q_D(const AnchorsGraph);
+
+    QList<int> list;
+    int root = d->indexes.value(d->window, -1);
+
+    if (root < 0) {
+        return list;
+    }
+
+    QVector<bool> seen(d->nodes.size(), false);
+    QList<int> queue;
+
+    // children see their parent in its own coordinates, the top and left
+    // edges of the window stay where they are when it is resized
+    foreach (const AnchorsGraphEdge &edge, d->edges) {
+        if (edge.to == root && !seen.at(edge.from)
+                && (edge.kind != AnchorsGraphEdge::Anchor
+                    || (edge.targetPoint != Qt::AnchorLeft && edge.targetPoint != Qt::AnchorTop))) {
+            seen[edge.from] = true;
+            queue << edge.from;
+        }
+    }
+
+    // from there on every moved widget is assumed to move its dependents
+    while (!queue.isEmpty()) {
+        int index = queue.takeFirst();
+
+        list << index;
+        foreach (int dependent, d->dependents.at(index)) {
+            if (!seen.at(dependent) && dependent != root) {
+                seen[dependent] = true;
+                queue << dependent;
+            }
+        }
+    }
+
+    return list;
+}
+
+QByteArray AnchorsGraph::toDot() const
+{
+    Q_D(const AnchorsGraph);
+
+    QList<QList<int> > chains = longestChains(1);
+    QSet<QPair<int, int> > critical;
+    QByteArray dot;
+
+    if (!chains.isEmpty()) {
+        const QList<int> &chain = chains.first();
+
+        for (int i = 1; i < chain.size(); ++i) {
+            critical << qMakePair(chain.at(i), chain.at(i - 1));
+        }
+    }
+
+    dot += "digraph anchors {\n";
+    dot += QString("    // widgets touched per root resize: %1 of %2\n")
+           .arg(touchedByResize().size()).arg(d->nodes.size()).toUtf8();
+    if (!chains.isEmpty()) {
+        dot += QString("    // longest chain: %1 links\n").arg(chains.first().size() - 1).toUtf8();
+    }
+    dot += "    node [shape=box];\n";
+
+    for (int i = 0; i < d->nodes.size(); ++i) {
+        const AnchorsGraphNode &node = d->nodes.at(i);
+        QString label = node.name;
+
+        label.replace("\\", "\\\\").replace("\"", "\\\"");
+        dot += QString("    n%1 [label=\"%2\\n%3,%4 %5x%6\\nin %7 out %8 depth %9\"];\n")
+               .arg(i).arg(label).arg(node.geometry.x()).arg(node.geometry.y())
+               .arg(node.geometry.width()).arg(node.geometry.height())
+               .arg(node.fanIn).arg(node.fanOut).arg(node.depth).toUtf8();
+    }
+
+    foreach (const AnchorsGraphEdge &edge, d->edges) {
+        QString label;
+        QString style;
+
+        switch (edge.kind) {
+        case AnchorsGraphEdge::Fill:
+            label = QString("fill %1").arg(edge.margin);
+            style = ", style=bold";
+            break;
+        case AnchorsGraphEdge::CenterIn:
+            label = "centerIn";
+            style = ", style=dashed";
+            break;
+        case AnchorsGraphEdge::Binding:
+            label = QString("%1 = f()").arg(d->propertyName(edge.property));
+            style = ", style=dotted";
+            break;
+        default:
+            label = QString("%1: %2 %3").arg(d->pointName(edge.point)).arg(d->pointName(edge.targetPoint))
+                    .arg(edge.margin);
+            break;
+        }
+
+        if (critical.contains(qMakePair(edge.from, edge.to))) {
+            style += ", color=red";
+        }
+
+        dot += QString("    n%1 -> n%2 [label=\"%3\"%4];\n").arg(edge.from).arg(edge.to).arg(label).arg(style)
+               .toUtf8();
+    }
+
+    dot += "}\n";
+
+    return dot;
+}
+
+QByteArray AnchorsGraph::toJson() const
+{
+    Q_D(const AnchorsGraph);
+
+    QJsonArray node_array;
+    for (int i = 0; i < d->nodes.size(); ++i) {
+        const AnchorsGraphNode &node = d->nodes.at(i);
+        QJsonObject object;
+        QJsonArray geometry;
+
+        geometry << node.geometry.x() << node.geometry.y() << node.geometry.width() << node.geometry.height();
+
+        object.insert("id", i);
+        object.insert("name", node.name);
+        object.insert("class", node.widget->metaObject()->className());
+        object.insert("geometry", geometry);
+        object.insert("fan_in", node.fanIn);
+        object.insert("fan_out", node.fanOut);
+        object.insert("depth", node.depth);
+        node_array.append(object);
+    }
+
+    QJsonArray edge_array;
+    foreach (const AnchorsGraphEdge &edge, d->edges) {
+        QJsonObject object;
+
+        object.insert("kind", d->kindName(edge.kind));
+        object.insert("from", edge.from);
+        object.insert("to", edge.to);
+        if (edge.kind == AnchorsGraphEdge::Anchor) {
+            object.insert("point", d->pointName(edge.point));
+            object.insert("target_point", d->pointName(edge.targetPoint));
+        } else if (edge.kind == AnchorsGraphEdge::Binding) {
+            object.insert("property", d->propertyName(edge.property));
+        }
+        if (edge.kind != AnchorsGraphEdge::CenterIn && edge.kind != AnchorsGraphEdge::Binding) {
+            object.insert("margin", edge.margin);
+        }
+        edge_array.append(object);
+    }
+
+    QJsonArray chain_array;
+    foreach (const QList<int> &chain, longestChains()) {
+        QJsonArray array;
+
+        foreach (int index, chain) {
+            array.append(index);
+        }
+        chain_array.append(array);
+    }
+
+    QJsonArray fan_in_array;
+    foreach (int index, highestFanIn()) {
+        fan_in_array.append(index);
+    }
+
+    QJsonArray fan_out_array;
+    foreach (int index, highestFanOut()) {
+        fan_out_array.append(index);
+    }
+
+    QJsonObject analysis;
+    analysis.insert("longest_chains", chain_array);
+    analysis.insert("highest_fan_in", fan_in_array);
+    analysis.insert("highest_fan_out", fan_out_array);
+    analysis.insert("touched_by_resize", touchedByResize().size());
+
+    QJsonObject root;
+    root.insert("window", d->indexes.value(d->window, -1));
+    root.insert("nodes", node_array);
+    root.insert("edges", edge_array);
+    root.insert("analysis", analysis);
+
+    return QJsonDocument(root).toJson();
+}
+
+bool AnchorsGraph::save(const QString &fileName)
+{
+    Q_D(AnchorsGraph);
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        d->errorString = file.errorString();
+        return false;
+    }
+
+    file.write(fileName.endsWith(".json", Qt::CaseInsensitive) ? toJson() : toDot());
+    d->errorString.clear();
+
+    return true;
+}
+
+void AnchorsGraph::rebuild(const QWidget *window)
+{
+    Q_D(AnchorsGraph);
+
+    d->window = window;
+    d->nodes.clear();
+    d->edges.clear();
+    d->indexes.clear();
+
+    if (window) {
+        // the window is always node zero, so that resize reports have a root
+        d->nodeOf(window);
+        d->collect(window);
+        foreach (const QWidget *w, window->findChildren<QWidget *>()) {
+            d->collect(w);
+        }
+    }
+
+    d->analyze();
+}
@@ -0,0 +1,66 @@
+#ifndef ANCHORSGRAPH_H
+#define ANCHORSGRAPH_H
+
+#include <QList>
+#include <QRect>
+#include <QString>
+
+#include "anchors.h"
+
+struct AnchorsGraphNode {
+    const QWidget *widget;
+    QString name;
+    QRect geometry;
+    int fanIn;
+    int fanOut;
+    int depth;
+};
+
+struct AnchorsGraphEdge {
+    enum Kind {
+        Anchor,
+        Fill,
+        CenterIn,
+        Binding
+    };
+
+    Kind kind;
+    int from;
+    int to;
+    Qt::AnchorPoint point;
+    Qt::AnchorPoint targetPoint;
+    AnchorsBase::BindingProperty property;
+    int margin;
+};
+
+class AnchorsGraphPrivate;
+class AnchorsGraph
+{
+public:
+    explicit AnchorsGraph(const QWidget *window = 0);
+    ~AnchorsGraph();
+
+    const QWidget *window() const;
+    QList<AnchorsGraphNode> nodes() const;
+    QList<AnchorsGraphEdge> edges() const;
+    QString errorString() const;
+
+    QList<QList<int> > longestChains(int count = 3) const;
+    QList<int> highestFanIn(int count = 5) const;
+    QList<int> highestFanOut(int count = 5) const;
+    QList<int> touchedByResize() const;
+
+    QByteArray toDot() const;
+    QByteArray toJson() const;
+    bool save(const QString &fileName);
+
+    void rebuild(const QWidget *window);
+
+private:
+    AnchorsGraphPrivate *d_ptr;
+
+    Q_DISABLE_COPY(AnchorsGraph)
+    Q_DECLARE_PRIVATE(AnchorsGraph)
+};
+
+#endif // ANCHORSGRAPH_H
@@ -0,0 +1,358 @@
+#include <QCursor>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPainter>
+#include <QPointer>
+#include <QTimer>
+
+#include "anchorsheatmap.h"
+
+class AnchorsHeatMapPrivate
+{
+    explicit AnchorsHeatMapPrivate(AnchorsHeatMap *qq): q_ptr(qq) {}
+
+    struct Record {
+        QPointer<QWidget> widget;
+        QList<qint64> commits;
+        QList<QPair<qint64, qint64> > updates;
+    };
+
+    bool accept(const QWidget *w) const
+    {
+        return window && w && w != q_ptr && w->window() == window;
+    }
+
+    Record &record(const QWidget *w)
+    {
+        Record &r = records[w];
+
+        if (!r.widget) {
+            r.widget = const_cast<QWidget *>(w);
+            r.commits.clear();
+            r.updates.clear();
+        }
+
+        return r;
+    }
+
+    // true when anything went out of the interval, the overlay is only
+    // repainted when what it shows changed
+    bool prune()
+    {
+        qint64 oldest = clock.elapsed() - interval;
+        bool pruned = false;
+
+        QHash<const QWidget *, Record>::iterator it = records.begin();
+        while (it != records.end()) {
+            Record &r = it.value();
+
+            while (!r.commits.isEmpty() && r.commits.first() < oldest) {
+                r.commits.removeFirst();
+                pruned = true;
+            }
+            while (!r.updates.isEmpty() && r.updates.first().first < oldest) {
+                r.updates.removeFirst();
+                pruned = true;
+            }
+
+            if (!r.widget || (r.commits.isEmpty() && r.updates.isEmpty())) {
+                it = records.erase(it);
+                pruned = true;
+            } else {
+                ++it;
+            }
+        }
+
+        return pruned;
+    }
+
+    // the refresh timer only runs while there is something to show
+    void recorded()
+    {
+        changed = true;
+
+        if (!timer->isActive()) {
+            timer->start();
+        }
+    }
+
+    qint64 cost(const Record &r) const
+    {
+        qint64 nsecs = 0;
+
+        for (int i = 0; i < r.updates.size(); ++i) {
+            nsecs += r.updates.at(i).second;
+        }
+
+        return nsecs;
+    }
+
+    qreal heat(const Record &r) const
+    {
+        // every 0.1 ms spent in update slots weighs as much as one extra commit
+        return r.commits.size() + r.updates.size() + cost(r) / 100000.0;
+    }
+
+    QRect mappedRect(const QWidget *w) const
+    {
+        return QRect(w->mapTo(window, QPoint(0, 0)), w->size());
+    }
+
+    QWidget *window;
+    QHash<const QWidget *, Record> records;
+    QElapsedTimer clock;
+    QTimer *timer = NULL;
+    int interval = 2000;
+    bool changed = false;
+
+    AnchorsHeatMap *q_ptr;
+
+    Q_DECLARE_PUBLIC(AnchorsHeatMap)
+};
+
+AnchorsHeatMap::AnchorsHeatMap(QWidget *window):
+    QWidget(window),
+    d_ptr(new AnchorsHeatMapPrivate(this))
+{
+    Q_D(AnchorsHeatMap);
+
+    d->window = window;
+    d->clock.start();
+    d->timer = new QTimer(this);
+    d->timer->setInterval(100);
+
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_NoSystemBackground);
+
+    connect(d->timer, SIGNAL(timeout()), SLOT(refresh()));
+
+    if (window) {
+        window->installEventFilter(this);
+        setGeometry(window->rect());
+        raise();
+        show();
+    }
+}
+
+AnchorsHeatMap::~AnchorsHeatMap()
+{
+    delete d_ptr;
+}
+
+int AnchorsHeatMap::interval() const
+{
+    Q_D(const AnchorsHeatMap);
+
+    return d->interval;
+}
+
+int AnchorsHeatMap::refreshInterval() const
+{
+    Q_D(const AnchorsHeatMap);
+
+    return d->timer->interval();
+}
+
+int AnchorsHeatMap::commitCount(const QWidget *w) const
+{
+    Q_D(const AnchorsHeatMap);
+
+    return d->records.value(w).commits.size();
+}
+
+int AnchorsHeatMap::updateCount(const QWidget *w) const
+{
+    Q_D(const AnchorsHeatMap);
+
+    return d->records.value(w).updates.size();
+}
+
+qint64 AnchorsHeatMap::updateCost(const QWidget *w) const
+{
+    Q_D(const AnchorsHeatMap);
+
+    return d->cost(d->records.value(w));
+}
+
+AnchorsHeatMap *AnchorsHeatMap::attach(QWidget *window)
+{
+    if (!window) {
+        return NULL;
+    }
+
+    foreach (QObject *obj, window->children()) {
+        AnchorsHeatMap *map = qobject_cast<AnchorsHeatMap *>(obj);
+
+        if (map) {
+            return map;
+        }
+    }
+
+    return new AnchorsHeatMap(window);
+}
+
+void AnchorsHeatMap::detach(QWidget *window)
+{
+    if (!window) {
+        return;
+    }
+
+    foreach (QObject *obj, window->children()) {
+        AnchorsHeatMap *map = qobject_cast<AnchorsHeatMap *>(obj);
+
+        if (map) {
+            map->deleteLater();
+        }
+    }
+}
+
+void AnchorsHeatMap::setInterval(int interval)
+{
+    Q_D(AnchorsHeatMap);
+
+    if (d->interval == interval) {
+        return;
+    }
+
+    d->interval = interval;
+    emit intervalChanged(interval);
+}
+
+void AnchorsHeatMap::setRefreshInterval(int refreshInterval)
+{
+    Q_D(AnchorsHeatMap);
+
+    if (d->timer->interval() == refreshInterval) {
+        return;
+    }
+
+    d->timer->setInterval(refreshInterval);
+    emit refreshIntervalChanged(refreshInterval);
+}
+
+void AnchorsHeatMap::clear()
+{
+    Q_D(AnchorsHeatMap);
+
+    d->records.clear();
+    d->changed = false;
+    d->timer->stop();
+    update();
+}
+
+bool AnchorsHeatMap::eventFilter(QObject *o, QEvent *e)
+{
+    Q_D(AnchorsHeatMap);
+
+    if (o == d->window) {
+        if (e->type() == QEvent::Resize) {
+            setGeometry(d->window->rect());
+        } else if (e->type() == QEvent::ChildAdded) {
+            raise();
+        }
+    }
+
+    return false;
+}
+
+void AnchorsHeatMap::paintEvent(QPaintEvent *e)
+{
+    Q_UNUSED(e)
+    Q_D(AnchorsHeatMap);
+
+    qreal max_heat = 0;
+    foreach (const AnchorsHeatMapPrivate::Record &r, d->records) {
+        if (r.widget && r.widget->isVisible()) {
+            max_heat = qMax(max_heat, d->heat(r));
+        }
+    }
+
+    if (max_heat <= 0) {
+        return;
+    }
+
+    QPainter pa(this);
+    QPoint cursor_pos = mapFromGlobal(QCursor::pos());
+    const QWidget *hovered = NULL;
+    QRect hovered_rect;
+
+    foreach (const AnchorsHeatMapPrivate::Record &r, d->records) {
+        if (!r.widget || !r.widget->isVisible()) {
+            continue;
+        }
+
+        qreal ratio = d->heat(r) / max_heat;
+        QRect rect = d->mappedRect(r.widget);
+        QColor color = QColor::fromHsvF((1 - ratio) / 6, 1, 1, 0.15 + 0.5 * ratio);
+
+        pa.fillRect(rect, color);
+
+        if (rect.contains(cursor_pos) && (!hovered || hovered_rect.contains(rect))) {
+            hovered = r.widget;
+            hovered_rect = rect;
+        }
+    }
+
+    if (hovered) {
+        const AnchorsHeatMapPrivate::Record &r = d->records[hovered];
+        QString name = hovered->objectName().isEmpty() ? QString(hovered->metaObject()->className())
+                                                       : hovered->objectName();
+        QString text = QString("%1\ncommits: %2\nupdates: %3 (%4 us)")
+                       .arg(name).arg(r.commits.size()).arg(r.updates.size())
+                       .arg(d->cost(r) / 1000);
+        QRect text_rect = pa.fontMetrics().boundingRect(QRect(0, 0, width(), height()), 0, text);
+
+        text_rect.adjust(-4, -4, 4, 4);
+        text_rect.moveTopLeft(cursor_pos + QPoint(12, 12));
+        if (text_rect.right() > width()) {
+            text_rect.moveRight(cursor_pos.x() - 12);
+        }
+        if (text_rect.bottom() > height()) {
+            text_rect.moveBottom(cursor_pos.y() - 12);
+        }
+
+        pa.setPen(Qt::red);
+        pa.drawRect(hovered_rect.adjusted(0, 0, -1, -1));
+        pa.fillRect(text_rect, QColor(0, 0, 0, 200));
+        pa.setPen(Qt::white);
+        pa.drawText(text_rect.adjusted(4, 4, -4, -4), 0, text);
+    }
+
+    pa.end();
+}
+
+void AnchorsHeatMap::updateEnd(const QWidget *w, UpdateType type, qint64 nsecs)
+{
+    Q_UNUSED(type)
+    Q_D(AnchorsHeatMap);
+
+    if (d->accept(w)) {
+        d->record(w).updates.append(qMakePair(d->clock.elapsed(), nsecs));
+        d->recorded();
+    }
+}
+
+void AnchorsHeatMap::geometryCommitted(const QWidget *w, const QRect &geometry)
+{
+    Q_UNUSED(geometry)
+    Q_D(AnchorsHeatMap);
+
+    if (d->accept(w)) {
+        d->record(w).commits.append(d->clock.elapsed());
+        d->recorded();
+    }
+}
+
+void AnchorsHeatMap::refresh()
+{
+    Q_D(AnchorsHeatMap);
+
+    if (d->prune() || d->changed) {
+        d->changed = false;
+        update();
+    }
+
+    if (d->records.isEmpty()) {
+        d->timer->stop();
+    }
+}
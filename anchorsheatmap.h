@@ -0,0 +1,55 @@
+#ifndef ANCHORSHEATMAP_H
+#define ANCHORSHEATMAP_H
+
+#include <QWidget>
+
+#include "anchors.h"
+
+class AnchorsHeatMapPrivate;
+class AnchorsHeatMap : public QWidget, public AnchorsObserver
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int interval READ interval WRITE setInterval NOTIFY intervalChanged)
+    Q_PROPERTY(int refreshInterval READ refreshInterval WRITE setRefreshInterval NOTIFY refreshIntervalChanged)
+
+public:
+    explicit AnchorsHeatMap(QWidget *window);
+    ~AnchorsHeatMap();
+
+    int interval() const;
+    int refreshInterval() const;
+
+    int commitCount(const QWidget *w) const;
+    int updateCount(const QWidget *w) const;
+    qint64 updateCost(const QWidget *w) const;
+
+    static AnchorsHeatMap *attach(QWidget *window);
+    static void detach(QWidget *window);
+
+public slots:
+    void setInterval(int interval);
+    void setRefreshInterval(int refreshInterval);
+    void clear();
+
+signals:
+    void intervalChanged(int interval);
+    void refreshIntervalChanged(int refreshInterval);
+
+protected:
+    bool eventFilter(QObject *o, QEvent *e) Q_DECL_OVERRIDE;
+    void paintEvent(QPaintEvent *e) Q_DECL_OVERRIDE;
+
+    void updateEnd(const QWidget *w, UpdateType type, qint64 nsecs) Q_DECL_OVERRIDE;
+    void geometryCommitted(const QWidget *w, const QRect &geometry) Q_DECL_OVERRIDE;
+
+private slots:
+    void refresh();
+
+private:
+    AnchorsHeatMapPrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(AnchorsHeatMap)
+};
+
+#endif // ANCHORSHEATMAP_H
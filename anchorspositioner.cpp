@@ -0,0 +1,378 @@
+#include <QChildEvent>
+#include <QCoreApplication>
+#include <QResizeEvent>
+#include <QVector>
+
+#include "anchors.h"
+#include "anchorspositioner.h"
+
+class AnchorsPositionerPrivate
+{
+    explicit AnchorsPositionerPrivate(AnchorsPositioner *qq): q_ptr(qq) {}
+    virtual ~AnchorsPositionerPrivate() {}
+
+    QList<QWidget *> items;
+    QSize sizeHint;
+    int spacing = 0;
+    int dirtyFrom = -1;
+    bool pending = false;
+
+    AnchorsPositioner *q_ptr;
+
+    Q_DECLARE_PUBLIC(AnchorsPositioner)
+
+    friend class AnchorsRow;
+    friend class AnchorsColumn;
+    friend class AnchorsFlow;
+    friend class AnchorsGridPrivate;
+};
+
+class AnchorsGridPrivate : public AnchorsPositionerPrivate
+{
+    explicit AnchorsGridPrivate(AnchorsGrid *qq): AnchorsPositionerPrivate(qq) {}
+
+    int columns = 4;
+
+    Q_DECLARE_PUBLIC(AnchorsGrid)
+};
+
+AnchorsPositioner::AnchorsPositioner(AnchorsPositionerPrivate *dd, QWidget *parent):
+    QWidget(parent),
+    d_ptr(dd)
+{
+}
+
+AnchorsPositioner::~AnchorsPositioner()
+{
+    delete d_ptr;
+}
+
+int AnchorsPositioner::spacing() const
+{
+    Q_D(const AnchorsPositioner);
+
+    return d->spacing;
+}
+
+QSize AnchorsPositioner::sizeHint() const
+{
+    Q_D(const AnchorsPositioner);
+
+    return d->sizeHint.isValid() ? d->sizeHint : QWidget::sizeHint();
+}
+
+void AnchorsPositioner::setSpacing(int spacing)
+{
+    Q_D(AnchorsPositioner);
+
+    if (d->spacing == spacing) {
+        return;
+    }
+
+    d->spacing = spacing;
+    requestPositioning();
+
+    emit spacingChanged(spacing);
+}
+
+void AnchorsPositioner::forceLayout()
+{
+    Q_D(AnchorsPositioner);
+
+    if (!d->pending) {
+        return;
+    }
+
+    int from = d->dirtyFrom;
+
+    d->pending = false;
+    d->dirtyFrom = -1;
+
+    QMargins margins = contentsMargins();
+    QSize size = positionItems(d->items, from, contentsRect());
+
+    size += QSize(margins.left() + margins.right(), margins.top() + margins.bottom());
+
+    if (size != d->sizeHint) {
+        d->sizeHint = size;
+        updateGeometry();
+    }
+
+    // the content only sizes the axes the positioner's own anchors leave
+    // open, on the others it stays an implicit size in sizeHint()
+    if (AnchorsBase::isSizeAnchored(this, Qt::Horizontal)) {
+        size.setWidth(width());
+    }
+    if (AnchorsBase::isSizeAnchored(this, Qt::Vertical)) {
+        size.setHeight(height());
+    }
+
+    resize(size);
+}
+
+void AnchorsPositioner::requestPositioning(int from)
+{
+    Q_D(AnchorsPositioner);
+
+    d->dirtyFrom = d->dirtyFrom < 0 ? from : qMin(d->dirtyFrom, from);
+
+    // any number of child changes before the event loop runs share one pass
+    if (!d->pending) {
+        d->pending = true;
+        QCoreApplication::postEvent(this, new QEvent(QEvent::LayoutRequest));
+    }
+}
+
+bool AnchorsPositioner::event(QEvent *e)
+{
+    if (e->type() == QEvent::LayoutRequest) {
+        forceLayout();
+    } else if (e->type() == QEvent::ContentsRectChange) {
+        requestPositioning();
+    }
+
+    return QWidget::event(e);
+}
+
+bool AnchorsPositioner::eventFilter(QObject *o, QEvent *e)
+{
+    Q_D(AnchorsPositioner);
+
+    switch (e->type()) {
+    case QEvent::Resize:
+    case QEvent::ShowToParent:
+    case QEvent::HideToParent: {
+        int index = d->items.indexOf(static_cast<QWidget *>(o));
+
+        if (index >= 0) {
+            requestPositioning(index);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    return QWidget::eventFilter(o, e);
+}
+
+void AnchorsPositioner::childEvent(QChildEvent *e)
+{
+    Q_D(AnchorsPositioner);
+
+    if (e->child()->isWidgetType()) {
+        QWidget *w = static_cast<QWidget *>(e->child());
+
+        if (e->type() == QEvent::ChildAdded && !d->items.contains(w)) {
+            d->items.append(w);
+            w->installEventFilter(this);
+            requestPositioning(d->items.size() - 1);
+        } else if (e->type() == QEvent::ChildRemoved) {
+            int index = d->items.indexOf(w);
+
+            if (index >= 0) {
+                d->items.removeAt(index);
+                w->removeEventFilter(this);
+                requestPositioning(index);
+            }
+        }
+    }
+
+    QWidget::childEvent(e);
+}
+
+AnchorsRow::AnchorsRow(QWidget *parent):
+    AnchorsPositioner(new AnchorsPositionerPrivate(this), parent)
+{
+}
+
+QSize AnchorsRow::positionItems(const QList<QWidget *> &items, int from, const QRect &contents)
+{
+    int x = contents.left();
+    int height = 0;
+    bool empty = true;
+
+    // items before the first changed one keep their place, only the cursor
+    // has to walk over them
+    for (int i = 0; i < items.size(); ++i) {
+        QWidget *w = items.at(i);
+
+        if (w->isHidden()) {
+            continue;
+        }
+
+        if (i >= from) {
+            w->move(x, contents.top());
+        }
+
+        x += w->width() + spacing();
+        height = qMax(height, w->height());
+        empty = false;
+    }
+
+    return QSize(empty ? 0 : x - spacing() - contents.left(), height);
+}
+
+AnchorsColumn::AnchorsColumn(QWidget *parent):
+    AnchorsPositioner(new AnchorsPositionerPrivate(this), parent)
+{
+}
+
+QSize AnchorsColumn::positionItems(const QList<QWidget *> &items, int from, const QRect &contents)
+{
+    int y = contents.top();
+    int width = 0;
+    bool empty = true;
+
+    for (int i = 0; i < items.size(); ++i) {
+        QWidget *w = items.at(i);
+
+        if (w->isHidden()) {
+            continue;
+        }
+
+        if (i >= from) {
+            w->move(contents.left(), y);
+        }
+
+        y += w->height() + spacing();
+        width = qMax(width, w->width());
+        empty = false;
+    }
+
+    return QSize(width, empty ? 0 : y - spacing() - contents.top());
+}
+
+AnchorsGrid::AnchorsGrid(QWidget *parent):
+    AnchorsPositioner(new AnchorsGridPrivate(this), parent)
+{
+}
+
+int AnchorsGrid::columns() const
+{
+    Q_D(const AnchorsGrid);
+
+    return d->columns;
+}
+
+void AnchorsGrid::setColumns(int columns)
+{
+    Q_D(AnchorsGrid);
+
+    columns = qMax(1, columns);
+
+    if (d->columns == columns) {
+        return;
+    }
+
+    d->columns = columns;
+    requestPositioning();
+
+    emit columnsChanged(columns);
+}
+
+QSize AnchorsGrid::positionItems(const QList<QWidget *> &items, int from, const QRect &contents)
+{
+    // one item can widen its whole column or heighten its whole row, so
+    // every cell is placed again
+    Q_UNUSED(from)
+    Q_D(AnchorsGrid);
+
+    QVector<int> widths(d->columns, 0);
+    QVector<int> heights;
+    int count = 0;
+
+    foreach (QWidget *w, items) {
+        if (w->isHidden()) {
+            continue;
+        }
+
+        int column = count % d->columns;
+        int row = count / d->columns;
+
+        if (row >= heights.size()) {
+            heights.append(0);
+        }
+
+        widths[column] = qMax(widths.at(column), w->width());
+        heights[row] = qMax(heights.at(row), w->height());
+        ++count;
+    }
+
+    if (!count) {
+        return QSize(0, 0);
+    }
+
+    QVector<int> xs(d->columns, 0);
+    QVector<int> ys(heights.size(), 0);
+    int x = contents.left();
+    int y = contents.top();
+
+    for (int i = 0; i < xs.size(); ++i) {
+        xs[i] = x;
+        x += widths.at(i) + spacing();
+    }
+    for (int i = 0; i < ys.size(); ++i) {
+        ys[i] = y;
+        y += heights.at(i) + spacing();
+    }
+
+    count = 0;
+    foreach (QWidget *w, items) {
+        if (w->isHidden()) {
+            continue;
+        }
+
+        w->move(xs.at(count % d->columns), ys.at(count / d->columns));
+        ++count;
+    }
+
+    return QSize(x - spacing() - contents.left(), y - spacing() - contents.top());
+}
+
+AnchorsFlow::AnchorsFlow(QWidget *parent):
+    AnchorsPositioner(new AnchorsPositionerPrivate(this), parent)
+{
+}
+
+QSize AnchorsFlow::positionItems(const QList<QWidget *> &items, int from, const QRect &contents)
+{
+    // a changed item can move the line breaks before it, so the flow is
+    // always placed from its first item
+    Q_UNUSED(from)
+
+    int x = contents.left();
+    int y = contents.top();
+    int line_height = 0;
+    bool empty = true;
+
+    foreach (QWidget *w, items) {
+        if (w->isHidden()) {
+            continue;
+        }
+
+        if (x > contents.left() && x + w->width() > contents.left() + contents.width()) {
+            x = contents.left();
+            y += line_height + spacing();
+            line_height = 0;
+        }
+
+        w->move(x, y);
+
+        x += w->width() + spacing();
+        line_height = qMax(line_height, w->height());
+        empty = false;
+    }
+
+    return QSize(contents.width(), empty ? 0 : y + line_height - contents.top());
+}
+
+void AnchorsFlow::resizeEvent(QResizeEvent *e)
+{
+    // the flow only takes its height from the content, a new width rewraps it
+    if (e->size().width() != e->oldSize().width()) {
+        requestPositioning();
+    }
+
+    AnchorsPositioner::resizeEvent(e);
+}
@@ -0,0 +1,101 @@
+#ifndef ANCHORSPOSITIONER_H
+#define ANCHORSPOSITIONER_H
+
+#include <QWidget>
+
+class AnchorsPositionerPrivate;
+class AnchorsPositioner : public QWidget
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int spacing READ spacing WRITE setSpacing NOTIFY spacingChanged)
+
+public:
+    ~AnchorsPositioner();
+
+    int spacing() const;
+    QSize sizeHint() const Q_DECL_OVERRIDE;
+
+public slots:
+    void setSpacing(int spacing);
+    void forceLayout();
+
+signals:
+    void spacingChanged(int spacing);
+
+protected:
+    explicit AnchorsPositioner(AnchorsPositionerPrivate *dd, QWidget *parent);
+
+    void requestPositioning(int from = 0);
+    virtual QSize positionItems(const QList<QWidget *> &items, int from, const QRect &contents) = 0;
+
+    bool event(QEvent *e) Q_DECL_OVERRIDE;
+    bool eventFilter(QObject *o, QEvent *e) Q_DECL_OVERRIDE;
+    void childEvent(QChildEvent *e) Q_DECL_OVERRIDE;
+
+    AnchorsPositionerPrivate *d_ptr;
+
+private:
+    Q_DECLARE_PRIVATE(AnchorsPositioner)
+};
+
+class AnchorsRow : public AnchorsPositioner
+{
+    Q_OBJECT
+
+public:
+    explicit AnchorsRow(QWidget *parent = 0);
+
+protected:
+    QSize positionItems(const QList<QWidget *> &items, int from, const QRect &contents) Q_DECL_OVERRIDE;
+};
+
+class AnchorsColumn : public AnchorsPositioner
+{
+    Q_OBJECT
+
+public:
+    explicit AnchorsColumn(QWidget *parent = 0);
+
+protected:
+    QSize positionItems(const QList<QWidget *> &items, int from, const QRect &contents) Q_DECL_OVERRIDE;
+};
+
+class AnchorsGridPrivate;
+class AnchorsGrid : public AnchorsPositioner
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int columns READ columns WRITE setColumns NOTIFY columnsChanged)
+
+public:
+    explicit AnchorsGrid(QWidget *parent = 0);
+
+    int columns() const;
+
+public slots:
+    void setColumns(int columns);
+
+signals:
+    void columnsChanged(int columns);
+
+protected:
+    QSize positionItems(const QList<QWidget *> &items, int from, const QRect &contents) Q_DECL_OVERRIDE;
+
+private:
+    Q_DECLARE_PRIVATE(AnchorsGrid)
+};
+
+class AnchorsFlow : public AnchorsPositioner
+{
+    Q_OBJECT
+
+public:
+    explicit AnchorsFlow(QWidget *parent = 0);
+
+protected:
+    QSize positionItems(const QList<QWidget *> &items, int from, const QRect &contents) Q_DECL_OVERRIDE;
+    void resizeEvent(QResizeEvent *e) Q_DECL_OVERRIDE;
+};
+
+#endif // ANCHORSPOSITIONER_H
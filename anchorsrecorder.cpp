@@ -0,0 +1,623 @@
+#include <QDataStream>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QPointer>
+#include <QStringList>
+#include <QWidget>
+
+#include "anchors.h"
+#include "anchorsrecorder.h"
+
+static const quint32 TraceMagic = 0x414e4352; // "ANCR"
+// 2 adds the aspect ratio, the margin variables and their values
+static const quint32 TraceVersion = 2;
+
+static const Qt::AnchorPoint tracePoints[] = {
+    Qt::AnchorTop,
+    Qt::AnchorBottom,
+    Qt::AnchorLeft,
+    Qt::AnchorRight,
+    Qt::AnchorHorizontalCenter,
+    Qt::AnchorVerticalCenter
+};
+
+static const AnchorsBase::BindingProperty traceBindings[] = {
+    AnchorsBase::TopProperty,
+    AnchorsBase::BottomProperty,
+    AnchorsBase::LeftProperty,
+    AnchorsBase::RightProperty,
+    AnchorsBase::HorizontalCenterProperty,
+    AnchorsBase::VerticalCenterProperty,
+    AnchorsBase::WidthProperty,
+    AnchorsBase::HeightProperty
+};
+
+struct AnchorsTrace {
+    struct Widget {
+        qint32 parent;
+        QString name;
+        QRect geometry;
+    };
+
+    struct Anchor {
+        qint32 widget;
+        qint32 targets[6];
+        qint8 points[6];
+        qint32 fill;
+        qint32 centerIn;
+        qint32 margins[7];
+        bool alignWhenCentered;
+        qreal aspectRatio;
+        QString variables[7];
+    };
+
+    struct Event {
+        qint64 timestamp;
+        QRect geometry;
+    };
+
+    void snapshot(QWidget *root)
+    {
+        QHash<const QWidget *, qint32> indexes;
+
+        widgets.clear();
+        anchors.clear();
+        variables.clear();
+        events.clear();
+        unrecorded.clear();
+
+        QList<QWidget *> list;
+        list << root;
+        // popups and dialogs are windows of their own, and so are their
+        // children; only what lives in the recorded window is kept
+        foreach (QWidget *w, root->findChildren<QWidget *>()) {
+            if (w->window() == root->window()) {
+                list << w;
+            }
+        }
+
+        foreach (QWidget *w, list) {
+            Widget data;
+
+            data.parent = w == root ? -1 : indexes.value(w->parentWidget(), -1);
+            data.name = w->objectName();
+            data.geometry = w->geometry();
+
+            indexes[w] = widgets.size();
+            widgets << data;
+        }
+
+        foreach (QWidget *w, list) {
+            const AnchorsBase *base = AnchorsBase::getAnchorBaseByWidget(w);
+
+            if (w == root || !base) {
+                continue;
+            }
+
+            const AnchorInfo *infos[] = {base->top(), base->bottom(), base->left(),
+                                         base->right(), base->horizontalCenter(),
+                                         base->verticalCenter()
+                                        };
+            Anchor data;
+
+            data.widget = indexes.value(w);
+            for (int i = 0; i < 6; ++i) {
+                const AnchorInfo *target = infos[i]->targetInfo;
+
+                data.targets[i] = target ? indexes.value(target->base->target(), -1) : -1;
+                data.points[i] = target ? target->type : -1;
+            }
+            data.fill = indexes.value(base->fill(), -1);
+            data.centerIn = indexes.value(base->centerIn(), -1);
+            data.margins[0] = base->margins();
+            data.margins[1] = base->topMargin();
+            data.margins[2] = base->bottomMargin();
+            data.margins[3] = base->leftMargin();
+            data.margins[4] = base->rightMargin();
+            data.margins[5] = base->horizontalCenterOffset();
+            data.margins[6] = base->verticalCenterOffset();
+            data.alignWhenCentered = base->alignWhenCentered();
+            data.aspectRatio = base->aspectRatio();
+            for (int i = 0; i < 7; ++i) {
+                data.variables[i] = base->marginVariable(AnchorsBase::MarginProperty(i));
+                if (!data.variables[i].isEmpty()) {
+                    variables.insert(data.variables[i], AnchorsVariables::value(data.variables[i]));
+                }
+            }
+
+            // expressions are code, the replay keeps these widgets where
+            // they were recorded
+            for (int i = 0; i < 8; ++i) {
+                if (base->hasBinding(traceBindings[i])) {
+                    unrecorded << w;
+                    break;
+                }
+            }
+
+            anchors << data;
+        }
+    }
+
+    bool save(QIODevice *device) const
+    {
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << (quint32)widgets.size();
+        foreach (const Widget &w, widgets) {
+            stream << w.parent << w.name << w.geometry;
+        }
+
+        stream << (quint32)anchors.size();
+        foreach (const Anchor &a, anchors) {
+            stream << a.widget;
+            for (int i = 0; i < 6; ++i) {
+                stream << a.targets[i] << a.points[i];
+            }
+            stream << a.fill << a.centerIn;
+            for (int i = 0; i < 7; ++i) {
+                stream << a.margins[i];
+            }
+            stream << a.alignWhenCentered << a.aspectRatio;
+            for (int i = 0; i < 7; ++i) {
+                stream << a.variables[i];
+            }
+        }
+
+        stream << variables;
+
+        stream << (quint32)events.size();
+        foreach (const Event &e, events) {
+            stream << e.timestamp << e.geometry;
+        }
+
+        QDataStream out(device);
+        out << TraceMagic << TraceVersion << qCompress(data);
+
+        return out.status() == QDataStream::Ok;
+    }
+
+    bool load(QIODevice *device)
+    {
+        QDataStream in(device);
+        quint32 magic = 0;
+        quint32 version = 0;
+        QByteArray data;
+
+        in >> magic >> version;
+        if (magic != TraceMagic || version < 1 || version > TraceVersion) {
+            return false;
+        }
+
+        in >> data;
+        data = qUncompress(data);
+
+        QDataStream stream(data);
+        quint32 count = 0;
+
+        stream.setVersion(QDataStream::Qt_5_0);
+        widgets.clear();
+        anchors.clear();
+        variables.clear();
+        events.clear();
+
+        stream >> count;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+            Widget w;
+
+            stream >> w.parent >> w.name >> w.geometry;
+            if (w.parent >= (qint32)i || (i > 0 && w.parent < 0)) {
+                return false;
+            }
+            widgets << w;
+        }
+
+        stream >> count;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+            Anchor a;
+
+            stream >> a.widget;
+            for (int j = 0; j < 6; ++j) {
+                stream >> a.targets[j] >> a.points[j];
+            }
+            stream >> a.fill >> a.centerIn;
+            for (int j = 0; j < 7; ++j) {
+                stream >> a.margins[j];
+            }
+            stream >> a.alignWhenCentered;
+            a.aspectRatio = 0;
+            if (version >= 2) {
+                stream >> a.aspectRatio;
+                for (int j = 0; j < 7; ++j) {
+                    stream >> a.variables[j];
+                }
+            }
+
+            if (a.widget <= 0 || a.widget >= widgets.size()) {
+                return false;
+            }
+            anchors << a;
+        }
+
+        if (version >= 2) {
+            stream >> variables;
+        }
+
+        stream >> count;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+            Event e;
+
+            stream >> e.timestamp >> e.geometry;
+            events << e;
+        }
+
+        return stream.status() == QDataStream::Ok && !widgets.isEmpty();
+    }
+
+    QList<Widget> widgets;
+    QList<Anchor> anchors;
+    QHash<QString, qint32> variables;
+    QList<Event> events;
+    // widgets with bindings, only known while recording
+    QList<const QWidget *> unrecorded;
+};
+
+class AnchorsRecorderPrivate
+{
+    explicit AnchorsRecorderPrivate(AnchorsRecorder *qq): q_ptr(qq) {}
+
+    void record()
+    {
+        QRect geometry = root->geometry();
+
+        if (!trace.events.isEmpty() && trace.events.last().geometry == geometry) {
+            return;
+        }
+
+        AnchorsTrace::Event e;
+        e.timestamp = clock.elapsed();
+        e.geometry = geometry;
+        trace.events << e;
+    }
+
+    QPointer<QWidget> root;
+    bool recording = false;
+    AnchorsTrace trace;
+    QElapsedTimer clock;
+    QString errorString;
+
+    AnchorsRecorder *q_ptr;
+
+    Q_DECLARE_PUBLIC(AnchorsRecorder)
+};
+
+AnchorsRecorder::AnchorsRecorder(QObject *parent):
+    QObject(parent),
+    d_ptr(new AnchorsRecorderPrivate(this))
+{
+}
+
+AnchorsRecorder::~AnchorsRecorder()
+{
+    stop();
+    delete d_ptr;
+}
+
+QWidget *AnchorsRecorder::root() const
+{
+    Q_D(const AnchorsRecorder);
+
+    return d->root;
+}
+
+bool AnchorsRecorder::isRecording() const
+{
+    Q_D(const AnchorsRecorder);
+
+    return d->recording;
+}
+
+int AnchorsRecorder::eventCount() const
+{
+    Q_D(const AnchorsRecorder);
+
+    return d->trace.events.size();
+}
+
+QString AnchorsRecorder::errorString() const
+{
+    Q_D(const AnchorsRecorder);
+
+    return d->errorString;
+}
+
+bool AnchorsRecorder::save(const QString &fileName)
+{
+    Q_D(AnchorsRecorder);
+
+    if (d->trace.widgets.isEmpty()) {
+        d->errorString = "Nothing has been recorded.";
+        return false;
+    }
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly)) {
+        d->errorString = file.errorString();
+        return false;
+    }
+
+    if (!d->trace.save(&file)) {
+        d->errorString = "Write failed.";
+        return false;
+    }
+
+    d->errorString.clear();
+
+    return true;
+}
+
+void AnchorsRecorder::start(QWidget *root)
+{
+    Q_D(AnchorsRecorder);
+
+    stop();
+
+    if (!root) {
+        return;
+    }
+
+    d->root = root;
+    d->trace.snapshot(root);
+    d->errorString.clear();
+    if (!d->trace.unrecorded.isEmpty()) {
+        QStringList names;
+
+        foreach (const QWidget *w, d->trace.unrecorded) {
+            names << (w->objectName().isEmpty() ? QString(w->metaObject()->className()) : w->objectName());
+        }
+
+        d->errorString = QString("Bindings are not recorded, replayed at their recorded geometry: %1.")
+                         .arg(names.join(", "));
+        qWarning() << "AnchorsRecorder:" << d->errorString;
+    }
+    d->clock.start();
+    d->recording = true;
+    root->installEventFilter(this);
+
+    emit rootChanged(root);
+    emit recordingChanged(true);
+}
+
+void AnchorsRecorder::stop()
+{
+    Q_D(AnchorsRecorder);
+
+    if (!d->recording) {
+        return;
+    }
+
+    if (d->root) {
+        d->root->removeEventFilter(this);
+    }
+
+    d->recording = false;
+    emit recordingChanged(false);
+}
+
+bool AnchorsRecorder::eventFilter(QObject *o, QEvent *e)
+{
+    Q_D(AnchorsRecorder);
+
+    if (d->recording && o == d->root
+            && (e->type() == QEvent::Resize || e->type() == QEvent::Move)) {
+        d->record();
+    }
+
+    return false;
+}
+
+class AnchorsReplayCounter : public AnchorsObserver
+{
+public:
+    void updateEnd(const QWidget *w, UpdateType type, qint64 nsecs) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(w)
+        Q_UNUSED(type)
+        Q_UNUSED(nsecs)
+
+        ++updates;
+    }
+
+    void geometryCommitted(const QWidget *w, const QRect &geometry) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(w)
+        Q_UNUSED(geometry)
+
+        ++commits;
+    }
+
+    int commits = 0;
+    int updates = 0;
+};
+
+class AnchorsReplayPrivate
+{
+    AnchorsReplayPrivate(AnchorsReplay *qq): q_ptr(qq) {}
+
+    QList<QWidget *> build(QWidget *host) const
+    {
+        QList<QWidget *> list;
+
+        foreach (const AnchorsTrace::Widget &data, trace.widgets) {
+            QWidget *w = new QWidget(data.parent < 0 ? host : list.at(data.parent));
+
+            w->setObjectName(data.name);
+            w->setGeometry(data.geometry);
+            list << w;
+        }
+
+        return list;
+    }
+
+    void bind(const QList<QWidget *> &list) const
+    {
+        // the replay shares the variables of the application, they are
+        // only added where missing
+        for (QHash<QString, qint32>::const_iterator it = trace.variables.constBegin();
+             it != trace.variables.constEnd(); ++it) {
+            if (!AnchorsVariables::contains(it.key())) {
+                AnchorsVariables::setValue(it.key(), it.value());
+            }
+        }
+
+        foreach (const AnchorsTrace::Anchor &data, trace.anchors) {
+            QWidget *w = list.at(data.widget);
+            AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+            for (int i = 0; i < 6; ++i) {
+                if (data.targets[i] >= 0 && data.targets[i] < list.size()) {
+                    base->setAnchor(tracePoints[i], list.at(data.targets[i]),
+                                    (Qt::AnchorPoint)data.points[i]);
+                }
+            }
+            if (data.fill >= 0 && data.fill < list.size()) {
+                base->setFill(list.at(data.fill));
+            }
+            if (data.centerIn >= 0 && data.centerIn < list.size()) {
+                base->setCenterIn(list.at(data.centerIn));
+            }
+
+            base->setMargins(data.margins[0]);
+            base->setTopMargin(data.margins[1]);
+            base->setBottomMargin(data.margins[2]);
+            base->setLeftMargin(data.margins[3]);
+            base->setRightMargin(data.margins[4]);
+            base->setHorizontalCenterOffset(data.margins[5]);
+            base->setVerticalCenterOffset(data.margins[6]);
+            base->setAlignWhenCentered(data.alignWhenCentered);
+            base->setAspectRatio(data.aspectRatio);
+            for (int i = 0; i < 7; ++i) {
+                if (!data.variables[i].isEmpty()) {
+                    base->setMarginVariable(AnchorsBase::MarginProperty(i), data.variables[i]);
+                }
+            }
+        }
+    }
+
+    AnchorsTrace trace;
+    QString errorString;
+
+    AnchorsReplay *q_ptr;
+
+    Q_DECLARE_PUBLIC(AnchorsReplay)
+};
+
+AnchorsReplay::AnchorsReplay():
+    d_ptr(new AnchorsReplayPrivate(this))
+{
+}
+
+AnchorsReplay::~AnchorsReplay()
+{
+    delete d_ptr;
+}
+
+bool AnchorsReplay::load(const QString &fileName)
+{
+    Q_D(AnchorsReplay);
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        d->errorString = file.errorString();
+        return false;
+    }
+
+    if (!d->trace.load(&file)) {
+        d->trace = AnchorsTrace();
+        d->errorString = "Invalid anchors trace file.";
+        return false;
+    }
+
+    d->errorString.clear();
+
+    return true;
+}
+
+QString AnchorsReplay::errorString() const
+{
+    Q_D(const AnchorsReplay);
+
+    return d->errorString;
+}
+
+int AnchorsReplay::widgetCount() const
+{
+    Q_D(const AnchorsReplay);
+
+    return d->trace.widgets.size();
+}
+
+int AnchorsReplay::anchoredCount() const
+{
+    Q_D(const AnchorsReplay);
+
+    return d->trace.anchors.size();
+}
+
+int AnchorsReplay::eventCount() const
+{
+    Q_D(const AnchorsReplay);
+
+    return d->trace.events.size();
+}
+
+QList<AnchorsReplayPass> AnchorsReplay::run()
+{
+    Q_D(AnchorsReplay);
+
+    QList<AnchorsReplayPass> passes;
+
+    if (d->trace.widgets.isEmpty()) {
+        return passes;
+    }
+
+    // the recorded root is replayed as a child of an invisible host so that
+    // its geometry changes are delivered synchronously on every platform
+    QWidget host;
+    host.setAttribute(Qt::WA_DontShowOnScreen);
+
+    QList<QWidget *> list = d->build(&host);
+    QWidget *root = list.first();
+
+    host.resize(root->geometry().united(QRect(0, 0, 1, 1)).size());
+    host.show();
+    d->bind(list);
+
+    AnchorsReplayCounter counter;
+
+    foreach (const AnchorsTrace::Event &e, d->trace.events) {
+        QElapsedTimer timer;
+        AnchorsReplayPass pass;
+
+        counter.commits = 0;
+        counter.updates = 0;
+
+        // only the size matters, children are laid out relative to the root
+        timer.start();
+        root->setGeometry(QRect(QPoint(0, 0), e.geometry.size()));
+        pass.nsecs = timer.nsecsElapsed();
+
+        pass.timestamp = e.timestamp;
+        pass.geometry = e.geometry;
+        pass.commits = counter.commits;
+        pass.updates = counter.updates;
+        passes << pass;
+    }
+
+    return passes;
+}
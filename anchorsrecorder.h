@@ -0,0 +1,75 @@
+#ifndef ANCHORSRECORDER_H
+#define ANCHORSRECORDER_H
+
+#include <QObject>
+#include <QRect>
+#include <QList>
+
+class QWidget;
+
+class AnchorsRecorderPrivate;
+class AnchorsRecorder : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QWidget *root READ root NOTIFY rootChanged)
+    Q_PROPERTY(bool recording READ isRecording NOTIFY recordingChanged)
+
+public:
+    explicit AnchorsRecorder(QObject *parent = 0);
+    ~AnchorsRecorder();
+
+    QWidget *root() const;
+    bool isRecording() const;
+    int eventCount() const;
+    QString errorString() const;
+
+    bool save(const QString &fileName);
+
+public slots:
+    void start(QWidget *root);
+    void stop();
+
+signals:
+    void rootChanged(QWidget *root);
+    void recordingChanged(bool recording);
+
+protected:
+    bool eventFilter(QObject *o, QEvent *e) Q_DECL_OVERRIDE;
+
+private:
+    AnchorsRecorderPrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(AnchorsRecorder)
+};
+
+struct AnchorsReplayPass {
+    qint64 timestamp;
+    QRect geometry;
+    qint64 nsecs;
+    int commits;
+    int updates;
+};
+
+class AnchorsReplayPrivate;
+class AnchorsReplay
+{
+public:
+    AnchorsReplay();
+    ~AnchorsReplay();
+
+    bool load(const QString &fileName);
+    QString errorString() const;
+    int widgetCount() const;
+    int anchoredCount() const;
+    int eventCount() const;
+
+    QList<AnchorsReplayPass> run();
+
+private:
+    AnchorsReplayPrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(AnchorsReplay)
+};
+
+#endif // ANCHORSRECORDER_H
@@ -0,0 +1,416 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QGuiApplication>
+#include <QPointer>
+#include <QScreen>
+#include <QWidget>
+#include <QWindow>
+
+#include "anchors.h"
+#include "anchorsscreen.h"
+
+class AnchorsScreenPrivate
+{
+    explicit AnchorsScreenPrivate(AnchorsScreen *qq): q_ptr(qq) {}
+
+    struct Anchor {
+        bool bound = false;
+        Qt::AnchorPoint screenPoint = Qt::AnchorTop;
+        int margin = 0;
+    };
+
+    static qreal valueOf(const QRect &rect, Qt::AnchorPoint point)
+    {
+        switch (point) {
+        case Qt::AnchorTop:
+            return rect.top();
+        case Qt::AnchorBottom:
+            return rect.bottom() + 1;
+        case Qt::AnchorHorizontalCenter:
+            return rect.left() + rect.width() / 2.0;
+        case Qt::AnchorLeft:
+            return rect.left();
+        case Qt::AnchorRight:
+            return rect.right() + 1;
+        case Qt::AnchorVerticalCenter:
+            return rect.top() + rect.height() / 2.0;
+        default:
+            return 0;
+        }
+    }
+
+    static bool isVertical(Qt::AnchorPoint point)
+    {
+        return point == Qt::AnchorTop || point == Qt::AnchorVerticalCenter || point == Qt::AnchorBottom;
+    }
+
+    // the same margin rules as between widgets: start edges move inwards
+    // by the margin, end edges by the margin and the last pixel
+    qreal targetValue(Qt::AnchorPoint point, const QRect &screen) const
+    {
+        const Anchor &anchor = anchors[point];
+        qreal value = valueOf(screen, anchor.screenPoint);
+
+        if (point == Qt::AnchorBottom || point == Qt::AnchorRight) {
+            return value - anchor.margin - 1;
+        }
+
+        return value + anchor.margin;
+    }
+
+    QRect resolve() const
+    {
+        Q_Q(const AnchorsScreen);
+
+        QRect screen = q->screenRect();
+        QRect rect = window->geometry();
+
+        if (!screen.isValid()) {
+            return rect;
+        }
+
+        AnchorsEngine *engine = AnchorsEngine::engine(window);
+
+        for (int i = 0; i < 2; ++i) {
+            bool vertical = i == 1;
+            int first = vertical ? Qt::AnchorTop : Qt::AnchorLeft;
+            AnchorsEngine::Axis axis;
+
+            axis.orientation = vertical ? Qt::Vertical : Qt::Horizontal;
+            axis.start = vertical ? rect.top() : rect.left();
+            axis.size = vertical ? rect.height() : rect.width();
+            axis.alignWhenCentered = false;
+
+            for (int j = 0; j < 3; ++j) {
+                Qt::AnchorPoint point = Qt::AnchorPoint(first + j);
+
+                axis.bound[j] = anchors[point].bound;
+                axis.values[j] = axis.bound[j] ? targetValue(point, screen) : 0;
+            }
+
+            int fixed = engine->resolve(axis);
+
+            if (fixed < 0) {
+                continue;
+            }
+
+            // the size limits of the window win, its anchored point stays put
+            int minimum = vertical ? window->minimumHeight() : window->minimumWidth();
+            int maximum = vertical ? window->maximumHeight() : window->maximumWidth();
+            int size = qBound(minimum, axis.size, maximum);
+
+            if (size != axis.size) {
+                if (fixed == 2) {
+                    axis.start += axis.size - size;
+                } else if (fixed == 1) {
+                    axis.start += (axis.size - size) / 2;
+                }
+                axis.size = size;
+            }
+
+            if (vertical) {
+                rect.moveTop(axis.start);
+                rect.setHeight(axis.size);
+            } else {
+                rect.moveLeft(axis.start);
+                rect.setWidth(axis.size);
+            }
+        }
+
+        return rect;
+    }
+
+    void connectScreen()
+    {
+        Q_Q(AnchorsScreen);
+
+        QScreen *current = q->screen();
+
+        if (current == connected) {
+            return;
+        }
+
+        if (connected) {
+            QObject::disconnect(connected, 0, q, 0);
+        }
+
+        connected = current;
+
+        if (connected) {
+            QObject::connect(connected, SIGNAL(geometryChanged(QRect)), q, SLOT(requestUpdate()));
+            QObject::connect(connected, SIGNAL(availableGeometryChanged(QRect)), q, SLOT(requestUpdate()));
+        }
+    }
+
+    void connectWindow()
+    {
+        Q_Q(AnchorsScreen);
+
+        // the native window only exists once the widget was shown
+        if (window->windowHandle()) {
+            QObject::connect(window->windowHandle(), SIGNAL(screenChanged(QScreen*)),
+                             q, SLOT(windowScreenChanged(QScreen*)), Qt::UniqueConnection);
+        }
+    }
+
+    QWidget *window = NULL;
+    QPointer<QScreen> screen;
+    QPointer<QScreen> connected;
+    AnchorsScreen::Area area = AnchorsScreen::AvailableGeometry;
+    Anchor anchors[6];
+    QRect simulatedGeometry;
+    QRect simulatedAvailableGeometry;
+    bool simulated = false;
+    bool pending = false;
+    bool committing = false;
+    int commits = 0;
+
+    AnchorsScreen *q_ptr;
+
+    Q_DECLARE_PUBLIC(AnchorsScreen)
+};
+
+AnchorsScreen::AnchorsScreen(QWidget *window):
+    QObject(window),
+    d_ptr(new AnchorsScreenPrivate(this))
+{
+    Q_D(AnchorsScreen);
+
+    d->window = window;
+    window->installEventFilter(this);
+    d->connectWindow();
+    d->connectScreen();
+}
+
+AnchorsScreen::~AnchorsScreen()
+{
+    delete d_ptr;
+}
+
+QWidget *AnchorsScreen::window() const
+{
+    Q_D(const AnchorsScreen);
+
+    return d->window;
+}
+
+QScreen *AnchorsScreen::screen() const
+{
+    Q_D(const AnchorsScreen);
+
+    if (d->screen) {
+        return d->screen;
+    }
+
+    // without an explicit screen the window's own one is followed
+    if (d->window->windowHandle() && d->window->windowHandle()->screen()) {
+        return d->window->windowHandle()->screen();
+    }
+
+    return QGuiApplication::primaryScreen();
+}
+
+AnchorsScreen::Area AnchorsScreen::area() const
+{
+    Q_D(const AnchorsScreen);
+
+    return d->area;
+}
+
+QRect AnchorsScreen::screenRect() const
+{
+    Q_D(const AnchorsScreen);
+
+    if (d->simulated) {
+        return d->area == Geometry ? d->simulatedGeometry : d->simulatedAvailableGeometry;
+    }
+
+    QScreen *current = screen();
+
+    if (!current) {
+        return QRect();
+    }
+
+    return d->area == Geometry ? current->geometry() : current->availableGeometry();
+}
+
+int AnchorsScreen::commitCount() const
+{
+    Q_D(const AnchorsScreen);
+
+    return d->commits;
+}
+
+bool AnchorsScreen::setAnchor(Qt::AnchorPoint point, Qt::AnchorPoint screenPoint, int margin)
+{
+    Q_D(AnchorsScreen);
+
+    if (!d->window->isWindow()) {
+        qWarning() << "AnchorsScreen: only top-level widgets can anchor to a screen";
+        return false;
+    }
+
+    if (AnchorsScreenPrivate::isVertical(point) != AnchorsScreenPrivate::isVertical(screenPoint)) {
+        return false;
+    }
+
+    AnchorsScreenPrivate::Anchor &anchor = d->anchors[point];
+
+    anchor.bound = true;
+    anchor.screenPoint = screenPoint;
+    anchor.margin = margin;
+    requestUpdate();
+
+    return true;
+}
+
+void AnchorsScreen::clearAnchor(Qt::AnchorPoint point)
+{
+    Q_D(AnchorsScreen);
+
+    // the window keeps its geometry, like a widget whose anchor is removed
+    d->anchors[point].bound = false;
+}
+
+bool AnchorsScreen::isAnchored(Qt::AnchorPoint point) const
+{
+    Q_D(const AnchorsScreen);
+
+    return d->anchors[point].bound;
+}
+
+void AnchorsScreen::setSimulatedScreen(const QRect &geometry, const QRect &availableGeometry)
+{
+    Q_D(AnchorsScreen);
+
+    d->simulated = true;
+    d->simulatedGeometry = geometry;
+    d->simulatedAvailableGeometry = availableGeometry;
+    requestUpdate();
+}
+
+void AnchorsScreen::clearSimulatedScreen()
+{
+    Q_D(AnchorsScreen);
+
+    if (!d->simulated) {
+        return;
+    }
+
+    d->simulated = false;
+    requestUpdate();
+}
+
+void AnchorsScreen::setScreen(QScreen *screen)
+{
+    Q_D(AnchorsScreen);
+
+    if (d->screen == screen) {
+        return;
+    }
+
+    d->screen = screen;
+    d->connectScreen();
+    requestUpdate();
+
+    emit screenChanged(this->screen());
+}
+
+void AnchorsScreen::setArea(Area area)
+{
+    Q_D(AnchorsScreen);
+
+    if (d->area == area) {
+        return;
+    }
+
+    d->area = area;
+    requestUpdate();
+
+    emit areaChanged(area);
+}
+
+void AnchorsScreen::requestUpdate()
+{
+    Q_D(AnchorsScreen);
+
+    // a screen change usually arrives as several signals, together with
+    // the window's own resizes they end in one native geometry commit
+    if (!d->pending) {
+        d->pending = true;
+        QCoreApplication::postEvent(this, new QEvent(QEvent::LayoutRequest));
+    }
+}
+
+void AnchorsScreen::forceUpdate()
+{
+    Q_D(AnchorsScreen);
+
+    d->pending = false;
+
+    QRect rect = d->resolve();
+
+    if (rect == d->window->geometry()) {
+        return;
+    }
+
+    d->committing = true;
+    d->window->setGeometry(rect);
+    d->committing = false;
+    ++d->commits;
+
+    emit committed(rect);
+}
+
+bool AnchorsScreen::event(QEvent *e)
+{
+    Q_D(AnchorsScreen);
+
+    if (e->type() == QEvent::LayoutRequest && d->pending) {
+        forceUpdate();
+        return true;
+    }
+
+    return QObject::event(e);
+}
+
+bool AnchorsScreen::eventFilter(QObject *o, QEvent *e)
+{
+    Q_D(AnchorsScreen);
+
+    if (o == d->window) {
+        switch (e->type()) {
+        case QEvent::Resize:
+            // a window anchored by one edge only has to follow its own size
+            if (!d->committing) {
+                requestUpdate();
+            }
+            break;
+        case QEvent::Show:
+            d->connectWindow();
+            d->connectScreen();
+            requestUpdate();
+            break;
+        default:
+            break;
+        }
+    }
+
+    return QObject::eventFilter(o, e);
+}
+
+void AnchorsScreen::windowScreenChanged(QScreen *screen)
+{
+    Q_D(AnchorsScreen);
+
+    Q_UNUSED(screen)
+
+    if (d->screen) {
+        return;
+    }
+
+    d->connectScreen();
+    requestUpdate();
+
+    emit screenChanged(this->screen());
+}
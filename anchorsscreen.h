@@ -0,0 +1,63 @@
+#ifndef ANCHORSSCREEN_H
+#define ANCHORSSCREEN_H
+
+#include <QObject>
+#include <QRect>
+
+class QScreen;
+class QWidget;
+
+class AnchorsScreenPrivate;
+class AnchorsScreen : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QScreen *screen READ screen WRITE setScreen NOTIFY screenChanged)
+
+public:
+    enum Area {
+        Geometry,
+        AvailableGeometry
+    };
+
+    explicit AnchorsScreen(QWidget *window);
+    ~AnchorsScreen();
+
+    QWidget *window() const;
+    QScreen *screen() const;
+    Area area() const;
+    QRect screenRect() const;
+    int commitCount() const;
+
+    bool setAnchor(Qt::AnchorPoint point, Qt::AnchorPoint screenPoint, int margin = 0);
+    void clearAnchor(Qt::AnchorPoint point);
+    bool isAnchored(Qt::AnchorPoint point) const;
+
+    void setSimulatedScreen(const QRect &geometry, const QRect &availableGeometry);
+    void clearSimulatedScreen();
+
+public slots:
+    void setScreen(QScreen *screen);
+    void setArea(Area area);
+    void requestUpdate();
+    void forceUpdate();
+
+signals:
+    void screenChanged(QScreen *screen);
+    void areaChanged(Area area);
+    void committed(const QRect &geometry);
+
+protected:
+    bool event(QEvent *e) Q_DECL_OVERRIDE;
+    bool eventFilter(QObject *o, QEvent *e) Q_DECL_OVERRIDE;
+
+private slots:
+    void windowScreenChanged(QScreen *screen);
+
+private:
+    AnchorsScreenPrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(AnchorsScreen)
+};
+
+#endif // ANCHORSSCREEN_H
@@ -0,0 +1,254 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "anchorstracer.h"
+
+class AnchorsTracerPrivate
+{
+    explicit AnchorsTracerPrivate(AnchorsTracer *qq): q_ptr(qq) {}
+
+    struct Event {
+        char phase;
+        const char *name;
+        const char *category;
+        qint64 nsecs;
+        QString widget;
+        QRect geometry;
+    };
+
+    static const char *eventName(QEvent::Type type)
+    {
+        switch (type) {
+        case QEvent::Move:
+            return "Move";
+        case QEvent::Resize:
+            return "Resize";
+        default:
+            return "Event";
+        }
+    }
+
+    static const char *updateName(AnchorsObserver::UpdateType type)
+    {
+        switch (type) {
+        case AnchorsObserver::VerticalUpdate:
+            return "updateVertical";
+        case AnchorsObserver::HorizontalUpdate:
+            return "updateHorizontal";
+        case AnchorsObserver::FillUpdate:
+            return "updateFill";
+        default:
+            return "updateCenterIn";
+        }
+    }
+
+    void append(char phase, const char *name, const char *category, const QWidget *w,
+                const QRect &geometry = QRect())
+    {
+        Event e;
+
+        e.phase = phase;
+        e.name = name;
+        e.category = category;
+        e.nsecs = clock.nsecsElapsed();
+        if (phase == 'B' && w) {
+            e.widget = w->objectName().isEmpty() ? QString(w->metaObject()->className())
+                                                 : w->objectName();
+        }
+        e.geometry = geometry;
+
+        events.append(e);
+    }
+
+    QList<Event> events;
+    QElapsedTimer clock;
+    QString errorString;
+    bool recording = false;
+
+    AnchorsTracer *q_ptr;
+
+    Q_DECLARE_PUBLIC(AnchorsTracer)
+};
+
+AnchorsTracer::AnchorsTracer(QObject *parent):
+    QObject(parent),
+    d_ptr(new AnchorsTracerPrivate(this))
+{
+}
+
+AnchorsTracer::~AnchorsTracer()
+{
+    delete d_ptr;
+}
+
+bool AnchorsTracer::isRecording() const
+{
+    Q_D(const AnchorsTracer);
+
+    return d->recording;
+}
+
+int AnchorsTracer::eventCount() const
+{
+    Q_D(const AnchorsTracer);
+
+    return d->events.size();
+}
+
+QString AnchorsTracer::errorString() const
+{
+    Q_D(const AnchorsTracer);
+
+    return d->errorString;
+}
+
+QByteArray AnchorsTracer::toJson() const
+{
+    Q_D(const AnchorsTracer);
+
+    qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray trace_events;
+
+    foreach (const AnchorsTracerPrivate::Event &e, d->events) {
+        QJsonObject object;
+
+        object.insert("name", e.name);
+        object.insert("cat", e.category);
+        object.insert("ph", QString(QChar(e.phase)));
+        object.insert("ts", e.nsecs / 1000.0);
+        object.insert("pid", pid);
+        object.insert("tid", 1);
+
+        if (e.phase == 'B') {
+            QJsonObject args;
+
+            args.insert("objectName", e.widget);
+            if (e.geometry.isValid()) {
+                args.insert("geometry", QString("%1,%2 %3x%4").arg(e.geometry.x()).arg(e.geometry.y())
+                            .arg(e.geometry.width()).arg(e.geometry.height()));
+            }
+            object.insert("args", args);
+        }
+
+        trace_events.append(object);
+    }
+
+    QJsonObject root;
+    root.insert("traceEvents", trace_events);
+    root.insert("displayTimeUnit", "ns");
+
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool AnchorsTracer::save(const QString &fileName)
+{
+    Q_D(AnchorsTracer);
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        d->errorString = file.errorString();
+        return false;
+    }
+
+    file.write(toJson());
+    d->errorString.clear();
+
+    return true;
+}
+
+void AnchorsTracer::start()
+{
+    Q_D(AnchorsTracer);
+
+    if (d->recording) {
+        return;
+    }
+
+    if (!d->clock.isValid()) {
+        d->clock.start();
+    }
+
+    d->recording = true;
+    emit recordingChanged(true);
+}
+
+void AnchorsTracer::stop()
+{
+    Q_D(AnchorsTracer);
+
+    if (!d->recording) {
+        return;
+    }
+
+    d->recording = false;
+    emit recordingChanged(false);
+}
+
+void AnchorsTracer::clear()
+{
+    Q_D(AnchorsTracer);
+
+    d->events.clear();
+    d->clock.start();
+}
+
+void AnchorsTracer::eventBegin(const QWidget *w, QEvent::Type type)
+{
+    Q_D(AnchorsTracer);
+
+    if (d->recording) {
+        d->append('B', d->eventName(type), "event", w);
+    }
+}
+
+void AnchorsTracer::eventEnd(const QWidget *w, QEvent::Type type)
+{
+    Q_D(AnchorsTracer);
+
+    if (d->recording) {
+        d->append('E', d->eventName(type), "event", w);
+    }
+}
+
+void AnchorsTracer::updateBegin(const QWidget *w, UpdateType type)
+{
+    Q_D(AnchorsTracer);
+
+    if (d->recording) {
+        d->append('B', d->updateName(type), "update", w);
+    }
+}
+
+void AnchorsTracer::updateEnd(const QWidget *w, UpdateType type, qint64 nsecs)
+{
+    Q_UNUSED(nsecs)
+    Q_D(AnchorsTracer);
+
+    if (d->recording) {
+        d->append('E', d->updateName(type), "update", w);
+    }
+}
+
+void AnchorsTracer::geometryAboutToBeCommitted(const QWidget *w, const QRect &geometry)
+{
+    Q_D(AnchorsTracer);
+
+    if (d->recording) {
+        d->append('B', "setGeometry", "commit", w, geometry);
+    }
+}
+
+void AnchorsTracer::geometryCommitted(const QWidget *w, const QRect &geometry)
+{
+    Q_UNUSED(geometry)
+    Q_D(AnchorsTracer);
+
+    if (d->recording) {
+        d->append('E', "setGeometry", "commit", w);
+    }
+}
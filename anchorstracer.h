@@ -0,0 +1,48 @@
+#ifndef ANCHORSTRACER_H
+#define ANCHORSTRACER_H
+
+#include <QObject>
+
+#include "anchors.h"
+
+class AnchorsTracerPrivate;
+class AnchorsTracer : public QObject, public AnchorsObserver
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool recording READ isRecording NOTIFY recordingChanged)
+
+public:
+    explicit AnchorsTracer(QObject *parent = 0);
+    ~AnchorsTracer();
+
+    bool isRecording() const;
+    int eventCount() const;
+    QString errorString() const;
+
+    QByteArray toJson() const;
+    bool save(const QString &fileName);
+
+public slots:
+    void start();
+    void stop();
+    void clear();
+
+signals:
+    void recordingChanged(bool recording);
+
+protected:
+    void eventBegin(const QWidget *w, QEvent::Type type) Q_DECL_OVERRIDE;
+    void eventEnd(const QWidget *w, QEvent::Type type) Q_DECL_OVERRIDE;
+    void updateBegin(const QWidget *w, UpdateType type) Q_DECL_OVERRIDE;
+    void updateEnd(const QWidget *w, UpdateType type, qint64 nsecs) Q_DECL_OVERRIDE;
+    void geometryAboutToBeCommitted(const QWidget *w, const QRect &geometry) Q_DECL_OVERRIDE;
+    void geometryCommitted(const QWidget *w, const QRect &geometry) Q_DECL_OVERRIDE;
+
+private:
+    AnchorsTracerPrivate *d_ptr;
+
+    Q_DECLARE_PRIVATE(AnchorsTracer)
+};
+
+#endif // ANCHORSTRACER_H
@@ -1,46 +1,254 @@
-#include "mainwindow.h"
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QDebug>
-#include "anchors.h"
-#include "dragwidget.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopedPointer>
+#include <QTextStream>
+#include "anchorsbenchmark.h"
+#include "anchorsrecorder.h"
+#include "anchorstracer.h"
+
+static int replay(const QString &fileName)
+{
+    AnchorsReplay replay;
+    QTextStream out(stdout);
+
+    if (!replay.load(fileName)) {
+        qWarning() << fileName << replay.errorString();
+        return 1;
+    }
+
+    out << "# widgets: " << replay.widgetCount() << ", anchored: " << replay.anchoredCount()
+        << ", events: " << replay.eventCount() << "\n";
+    out << "pass,timestamp_ms,width,height,nsecs,commits,updates\n";
+
+    QList<AnchorsReplayPass> passes = replay.run();
+    for (int i = 0; i < passes.size(); ++i) {
+        const AnchorsReplayPass &pass = passes.at(i);
+
+        out << i << "," << pass.timestamp << "," << pass.geometry.width() << ","
+            << pass.geometry.height() << "," << pass.nsecs << "," << pass.commits << ","
+            << pass.updates << "\n";
+    }
+
+    return 0;
+}
+
+static AnchorsEngine *engineByName(const QString &name)
+{
+    if (name == "cascade") {
+        return AnchorsEngine::cascade();
+    } else if (name == "span") {
+        return AnchorsEngine::span();
+    }
+
+    return NULL;
+}
+
+static int benchmark(const AnchorsBenchmarkShape &shape, bool json, const QString &fileName,
+                     const QString &traceFileName, const QString &graphFileName,
+                     AnchorsEngine *engine, AnchorsEngine *reference)
+{
+    QFile file;
+
+    if (fileName.isEmpty()) {
+        file.open(stdout, QIODevice::WriteOnly);
+    } else {
+        file.setFileName(fileName);
+
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning() << fileName << file.errorString();
+            return 1;
+        }
+    }
+
+    // the tracer only exists when asked for, so untraced runs pay nothing for it
+    QScopedPointer<AnchorsTracer> tracer(traceFileName.isEmpty() ? NULL : new AnchorsTracer);
+    if (tracer) {
+        tracer->start();
+    }
+
+    AnchorsBenchmark benchmark(shape);
+    benchmark.setGraphFileName(graphFileName);
+    benchmark.setEngine(engine, reference);
+    QList<AnchorsBenchmarkPass> passes = benchmark.run();
+
+    if (tracer) {
+        tracer->stop();
+        if (!tracer->save(traceFileName)) {
+            qWarning() << traceFileName << tracer->errorString();
+        }
+    }
+
+    qint64 commits = 0;
+
+    foreach (const AnchorsBenchmarkPass &pass, passes) {
+        commits += pass.commits;
+    }
+
+    qint64 p50 = AnchorsBenchmark::percentile(passes, 0.5);
+    qint64 p99 = AnchorsBenchmark::percentile(passes, 0.99);
+    qreal commits_per_pass = passes.isEmpty() ? 0 : qreal(commits) / passes.size();
+    qint64 peak_rss = AnchorsBenchmark::peakMemoryUsage();
+    AnchorsEngineComparison comparison = benchmark.comparison();
+
+    if (json) {
+        QJsonObject shape_object;
+        shape_object.insert("widgets", shape.widgets);
+        shape_object.insert("depth", shape.depth);
+        shape_object.insert("fan_out", shape.fanOut);
+        shape_object.insert("fill_share", shape.fillShare);
+        shape_object.insert("center_in_share", shape.centerInShare);
+        shape_object.insert("margin_change_rate", shape.marginChangeRate);
+        shape_object.insert("drags", shape.drags);
+        shape_object.insert("resizes", shape.resizes);
+        shape_object.insert("seed", qint64(shape.seed));
+
+        QJsonObject summary;
+        summary.insert("widgets", benchmark.widgetCount());
+        summary.insert("anchored", benchmark.anchoredCount());
+        summary.insert("passes", passes.size());
+        summary.insert("p50_nsecs", p50);
+        summary.insert("p99_nsecs", p99);
+        summary.insert("commits_per_pass", commits_per_pass);
+        summary.insert("peak_rss_bytes", peak_rss);
+
+        QJsonArray pass_array;
+        foreach (const AnchorsBenchmarkPass &pass, passes) {
+            QJsonObject pass_object;
+            pass_object.insert("kind", pass.kind == AnchorsBenchmarkPass::Drag ? "drag" : "resize");
+            pass_object.insert("nsecs", pass.nsecs);
+            pass_object.insert("commits", pass.commits);
+            pass_object.insert("updates", pass.updates);
+            pass_object.insert("margin_changes", pass.marginChanges);
+            pass_array.append(pass_object);
+        }
+
+        QJsonObject root;
+        root.insert("shape", shape_object);
+        root.insert("summary", summary);
+
+        if (reference) {
+            QJsonObject engines;
+            engines.insert("first", comparison.first);
+            engines.insert("second", comparison.second);
+            engines.insert("resolves", comparison.resolves);
+            engines.insert("mismatches", comparison.mismatches);
+            engines.insert("first_nsecs", comparison.firstNsecs);
+            engines.insert("second_nsecs", comparison.secondNsecs);
+            root.insert("engines", engines);
+        }
+        root.insert("passes", pass_array);
+        file.write(QJsonDocument(root).toJson());
+    } else {
+        QTextStream out(&file);
+
+        out << "# widgets: " << benchmark.widgetCount() << ", anchored: " << benchmark.anchoredCount()
+            << ", passes: " << passes.size() << "\n";
+        out << "# p50_nsecs: " << p50 << ", p99_nsecs: " << p99 << ", commits_per_pass: "
+            << commits_per_pass << ", peak_rss_bytes: " << peak_rss << "\n";
+        if (reference) {
+            out << "# engines: " << comparison.first << " vs " << comparison.second << ", resolves: "
+                << comparison.resolves << ", mismatches: " << comparison.mismatches << ", first_nsecs: "
+                << comparison.firstNsecs << ", second_nsecs: " << comparison.secondNsecs << "\n";
+        }
+        out << "pass,kind,nsecs,commits,updates,margin_changes\n";
+
+        for (int i = 0; i < passes.size(); ++i) {
+            const AnchorsBenchmarkPass &pass = passes.at(i);
+
+            out << i << "," << (pass.kind == AnchorsBenchmarkPass::Drag ? "drag" : "resize") << ","
+                << pass.nsecs << "," << pass.commits << "," << pass.updates << ","
+                << pass.marginChanges << "\n";
+        }
+    }
+
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
+    // the benchmark never needs a display, keep its numbers free of compositor noise
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
     QApplication a(argc, argv);
+    AnchorsBenchmarkShape shape;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Anchors layout benchmark on synthetic widget trees.");
+    parser.addHelpOption();
 
-    Anchors<MainWindow> w = new MainWindow;
-    w->resize(500, 500);
+    QCommandLineOption replay_option("replay", "Replay a recorded geometry trace instead.", "file");
+    QCommandLineOption widgets_option("widgets", "Number of generated widgets.", "count", QString::number(shape.widgets));
+    QCommandLineOption depth_option("depth", "Length of the anchor chains.", "depth", QString::number(shape.depth));
+    QCommandLineOption fan_out_option("fan-out", "Widgets anchored to every chain link.", "count", QString::number(shape.fanOut));
+    QCommandLineOption fill_option("fill-share", "Share of links using fill.", "ratio", QString::number(shape.fillShare));
+    QCommandLineOption center_in_option("center-in-share", "Share of links using centerIn.", "ratio", QString::number(shape.centerInShare));
+    QCommandLineOption margin_option("margin-rate", "Share of anchored widgets changing margins per pass.", "ratio", QString::number(shape.marginChangeRate));
+    QCommandLineOption drags_option("drags", "Number of scripted drag passes.", "count", QString::number(shape.drags));
+    QCommandLineOption resizes_option("resizes", "Number of scripted window resize passes.", "count", QString::number(shape.resizes));
+    QCommandLineOption seed_option("seed", "Seed of the generated shape.", "seed", QString::number(shape.seed));
+    QCommandLineOption json_option("json", "Write JSON instead of CSV.");
+    QCommandLineOption trace_option("trace", "Write a Chrome trace of all anchor cascades.", "file");
+    QCommandLineOption graph_option("graph", "Write the anchor graph, JSON for *.json and DOT otherwise.", "file");
+    QCommandLineOption engine_option("engine", "Layout engine: cascade or span.", "name", "cascade");
+    QCommandLineOption compare_option("compare", "Run a second engine alongside and compare their results.", "name");
+    QCommandLineOption output_option(QStringList() << "o" << "output", "Write the report to a file.", "file");
 
-    Anchors<DragWidget> ww = new DragWidget(w);
-    ww->setAutoFillBackground(true);
-    ww->resize(100, 100);
-    ww->setStyleSheet("QWidget{background-color:green;}");
-    ww->show();
+    parser.addOption(replay_option);
+    parser.addOption(widgets_option);
+    parser.addOption(depth_option);
+    parser.addOption(fan_out_option);
+    parser.addOption(fill_option);
+    parser.addOption(center_in_option);
+    parser.addOption(margin_option);
+    parser.addOption(drags_option);
+    parser.addOption(resizes_option);
+    parser.addOption(seed_option);
+    parser.addOption(json_option);
+    parser.addOption(trace_option);
+    parser.addOption(graph_option);
+    parser.addOption(engine_option);
+    parser.addOption(compare_option);
+    parser.addOption(output_option);
+    parser.process(a);
 
-    Anchors<DragWidget> widget = new DragWidget(w);
-    widget->setStyleSheet("QWidget{background-color:red;}");
-    widget->resize(100, 100);
+    if (parser.isSet("replay")) {
+        return replay(parser.value("replay"));
+    }
 
-    //ww.setBottom(w.bottom());
-   // ww.setBottomMargin(10);
+    shape.widgets = qMax(1, parser.value("widgets").toInt());
+    shape.depth = qMax(1, parser.value("depth").toInt());
+    shape.fanOut = qMax(0, parser.value("fan-out").toInt());
+    shape.fillShare = qBound(0.0, parser.value("fill-share").toDouble(), 1.0);
+    shape.centerInShare = qBound(0.0, parser.value("center-in-share").toDouble(), 1.0);
+    shape.marginChangeRate = qBound(0.0, parser.value("margin-rate").toDouble(), 1.0);
+    shape.drags = qMax(0, parser.value("drags").toInt());
+    shape.resizes = qMax(0, parser.value("resizes").toInt());
+    shape.seed = parser.value("seed").toUInt();
 
-    //ww.setVerticalCenter(widget.bottom());
-    //ww.setTop(widget.bottom());
-    ww.setRight(widget.right());
-    //ww.setBottom(widget.bottom());
-    //ww.setTopMargin(-1);
-    //ww.setVerticalCenterOffset(10);
-    ww.setMargins(10);
-    ww.setTopMargin(5);
-    //ww->raise();
-    qDebug()<<ww.errorString();
-    //ww.setRightMargin(-1);
+    AnchorsEngine *engine = engineByName(parser.value("engine"));
+    AnchorsEngine *reference = NULL;
 
-    //ww.moveLeft(widget->rect().right());
+    if (!engine) {
+        qWarning() << "unknown engine" << parser.value("engine");
+        return 1;
+    }
 
-    //widget.setVerticalCenter(100, Qt::AnchorTop);
+    if (parser.isSet("compare")) {
+        reference = engineByName(parser.value("compare"));
 
-    w->show();
+        if (!reference) {
+            qWarning() << "unknown engine" << parser.value("compare");
+            return 1;
+        }
+    }
 
-    return a.exec();
+    return benchmark(shape, parser.isSet("json"), parser.value("output"), parser.value("trace"),
+                     parser.value("graph"), engine, reference);
 }
@@ -0,0 +1,265 @@
+#include <QApplication>
+#include <QtTest>
+#include <QWidget>
+
+#include <cstdlib>
+#include <new>
+
+#include "anchors.h"
+
+// the flag is per thread, so that allocations of Qt's helper threads never
+// show up in the count
+static thread_local bool counting = false;
+static int allocations = 0;
+
+void *operator new(std::size_t size)
+{
+    if (counting) {
+        ++allocations;
+    }
+
+    void *ptr = std::malloc(size ? size : 1);
+
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+// counts what the library does between the events it handles, the commits
+// and the coalesced repaints are Qt's: setGeometry() and update() allocate
+// on their own, e.g. for the backing store regions they invalidate
+class AllocationScope : public AnchorsObserver
+{
+public:
+    void eventBegin(const QWidget *w, QEvent::Type type) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(w)
+        Q_UNUSED(type)
+
+        push(enabled);
+    }
+
+    void eventEnd(const QWidget *w, QEvent::Type type) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(w)
+        Q_UNUSED(type)
+
+        pop();
+    }
+
+    void geometryAboutToBeCommitted(const QWidget *w, const QRect &geometry) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(w)
+        Q_UNUSED(geometry)
+
+        push(false);
+    }
+
+    void geometryCommitted(const QWidget *w, const QRect &geometry) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(w)
+        Q_UNUSED(geometry)
+
+        pop();
+        ++commits;
+    }
+
+    void repaintAboutToBeRequested(const QWidget *parent, const QRect &rect) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(parent)
+        Q_UNUSED(rect)
+
+        push(false);
+    }
+
+    void repaintRequested(const QWidget *parent, const QRect &rect) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(parent)
+        Q_UNUSED(rect)
+
+        pop();
+        ++repaints;
+    }
+
+    bool enabled = false;
+    int commits = 0;
+    int repaints = 0;
+
+private:
+    // a fixed stack, the scope itself must not allocate while it counts
+    void push(bool state)
+    {
+        Q_ASSERT(depth < MaxDepth);
+
+        saved[depth++] = counting;
+        counting = state;
+    }
+
+    void pop()
+    {
+        counting = saved[--depth];
+    }
+
+    enum {
+        MaxDepth = 4096
+    };
+
+    bool saved[MaxDepth];
+    int depth = 0;
+};
+
+class TestAllocations : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void relayout();
+    void drag();
+    void cleanupTestCase();
+
+private:
+    QWidget *window = NULL;
+    QWidget *root = NULL;
+    QWidget *handle = NULL;
+    QList<QWidget *> fills;
+    QList<QWidget *> followers;
+};
+
+void TestAllocations::initTestCase()
+{
+    window = new QWidget;
+    window->resize(1200, 900);
+    root = new QWidget(window);
+    root->setGeometry(0, 0, 1000, 800);
+
+    QWidget *previous = NULL;
+
+    for (int i = 0; i < 1000; ++i) {
+        QWidget *w = new QWidget(root);
+        AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+        w->resize(20, 10);
+
+        switch (i % 4) {
+        case 0:
+            base->setAnchor(Qt::AnchorLeft, root, Qt::AnchorLeft);
+            base->setAnchor(Qt::AnchorRight, root, Qt::AnchorRight);
+            base->setAnchor(Qt::AnchorTop, root, Qt::AnchorTop);
+            base->setMargins(i % 50);
+            break;
+        case 1:
+            base->setFill(root);
+            base->setMargins(i % 50);
+            fills << w;
+            break;
+        case 2:
+            base->setCenterIn(previous);
+            break;
+        default:
+            base->setAnchor(Qt::AnchorLeft, previous, Qt::AnchorRight);
+            base->setAnchor(Qt::AnchorBottom, root, Qt::AnchorBottom);
+            break;
+        }
+
+        previous = w;
+    }
+
+    // a row of widgets following a handle that is dragged around, every
+    // move goes through the move events of the handle and its followers
+    handle = new QWidget(window);
+    handle->setGeometry(0, 820, 10, 10);
+    previous = handle;
+    for (int i = 0; i < 100; ++i) {
+        QWidget *w = new QWidget(window);
+        AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+        w->resize(10, 10);
+        base->setAnchor(Qt::AnchorLeft, previous, Qt::AnchorRight);
+        base->setAnchor(Qt::AnchorTop, previous, Qt::AnchorTop);
+        followers << w;
+        previous = w;
+    }
+
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+
+    // lazily built state, connection lists and the like, settles here
+    root->resize(900, 700);
+    root->resize(1000, 800);
+    handle->move(5, 825);
+    handle->move(0, 820);
+}
+
+void TestAllocations::relayout()
+{
+    AllocationScope scope;
+
+    allocations = 0;
+    scope.enabled = true;
+    root->resize(1100, 850);
+    scope.enabled = false;
+
+    QVERIFY(scope.commits >= 1000);
+    foreach (QWidget *w, fills) {
+        int margin = AnchorsBase::getAnchorBaseByWidget(w)->margins();
+
+        QCOMPARE(w->geometry(), root->rect().adjusted(margin, margin, -margin, -margin));
+    }
+    QCOMPARE(allocations, 0);
+}
+
+void TestAllocations::drag()
+{
+    AllocationScope scope;
+
+    QVERIFY(AnchorsBase::repaintCoalescing());
+
+    allocations = 0;
+    for (int i = 1; i <= 50; ++i) {
+        scope.enabled = true;
+        handle->move(i * 3, 820 + i % 7);
+        scope.enabled = false;
+    }
+
+    QVERIFY(scope.commits >= 50 * 100);
+    QVERIFY(scope.repaints >= 50);
+    QCOMPARE(followers.last()->geometry(), QRect(1150, 821, 10, 10));
+    QCOMPARE(allocations, 0);
+}
+
+void TestAllocations::cleanupTestCase()
+{
+    delete window;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestAllocations test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_allocations.moc"
@@ -0,0 +1,13 @@
+QT       += core gui widgets testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_bindings
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_bindings.cpp \
+    ../../anchors.cpp
+
+HEADERS  += ../../anchors.h
@@ -0,0 +1,233 @@
+#include <QApplication>
+#include <QRegularExpression>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+
+class OscillationScope : public AnchorsObserver
+{
+public:
+    void oscillationDetected(const QList<const QWidget *> &widgets) Q_DECL_OVERRIDE
+    {
+        ++reports;
+        involved = widgets;
+    }
+
+    int reports = 0;
+    QList<const QWidget *> involved;
+};
+
+class TestBindings : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void edge();
+    void size();
+    void edgeNextToAnchor();
+    void dependencies();
+    void conflicts();
+    void cleared();
+    void oscillation();
+    void cleanup();
+
+private:
+    QWidget *createWidget(int width, int height);
+
+    QWidget *window = NULL;
+    QWidget *source = NULL;
+    bool readFirst = true;
+};
+
+QWidget *TestBindings::createWidget(int width, int height)
+{
+    QWidget *w = new QWidget(window);
+
+    w->resize(width, height);
+    w->show();
+
+    return w;
+}
+
+void TestBindings::init()
+{
+    window = new QWidget;
+    window->resize(400, 300);
+    source = new QWidget(window);
+    source->setGeometry(10, 10, 50, 20);
+    readFirst = true;
+
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+}
+
+void TestBindings::edge()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+    QWidget *s = source;
+
+    QVERIFY(base->setBinding(AnchorsBase::LeftProperty, [s]() {
+        return AnchorsBase::valueOf(s, Qt::AnchorRight) + 5;
+    }));
+
+    QCOMPARE(w->x(), 65);
+    QCOMPARE(base->bindingDependencies(AnchorsBase::LeftProperty), QList<QWidget *>() << source);
+
+    source->move(100, 10);
+    QCOMPARE(w->x(), 155);
+    QCOMPARE(w->size(), QSize(30, 10));
+}
+
+void TestBindings::size()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    QVERIFY(base->setSizeBinding(AnchorsBase::WidthProperty, source, AnchorsBase::WidthProperty, 0.5, 4));
+    QCOMPARE(w->size(), QSize(29, 10));
+
+    source->resize(100, 20);
+    QCOMPARE(w->size(), QSize(54, 10));
+
+    // a move of the source changes nothing the binding reads
+    source->move(30, 30);
+    QCOMPARE(w->size(), QSize(54, 10));
+}
+
+void TestBindings::edgeNextToAnchor()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+    QWidget *s = source;
+
+    // the anchored left edge stays, the bound right edge sizes the widget
+    QVERIFY(base->setAnchor(Qt::AnchorLeft, window, Qt::AnchorLeft));
+    QVERIFY(base->setBinding(AnchorsBase::RightProperty, [s]() {
+        return AnchorsBase::valueOf(s, Qt::AnchorLeft);
+    }));
+
+    QCOMPARE(w->geometry().left(), 0);
+    QCOMPARE(w->width(), 10);
+
+    source->move(40, 10);
+    QCOMPARE(w->geometry().left(), 0);
+    QCOMPARE(w->width(), 40);
+}
+
+void TestBindings::dependencies()
+{
+    QWidget *first = createWidget(20, 10);
+    QWidget *second = createWidget(70, 10);
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    QVERIFY(base->setBinding(AnchorsBase::WidthProperty, [this, first, second]() {
+        return readFirst ? AnchorsBase::widthOf(first) : AnchorsBase::widthOf(second);
+    }));
+
+    QCOMPARE(w->width(), 20);
+    QCOMPARE(base->bindingDependencies(AnchorsBase::WidthProperty), QList<QWidget *>() << first);
+
+    // only what the last evaluation read is tracked
+    readFirst = false;
+    first->resize(25, 10);
+    QCOMPARE(w->width(), 70);
+    QCOMPARE(base->bindingDependencies(AnchorsBase::WidthProperty), QList<QWidget *>() << second);
+
+    first->resize(35, 10);
+    QCOMPARE(w->width(), 70);
+    second->resize(80, 10);
+    QCOMPARE(w->width(), 80);
+}
+
+void TestBindings::conflicts()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    QVERIFY(base->setAnchor(Qt::AnchorLeft, window, Qt::AnchorLeft));
+    QVERIFY(base->setAnchor(Qt::AnchorRight, window, Qt::AnchorRight));
+
+    QVERIFY(!base->setBinding(AnchorsBase::LeftProperty, []() { return 5; }));
+    QCOMPARE(base->errorCode(), AnchorsBase::Conflict);
+    QVERIFY(!base->setSizeBinding(AnchorsBase::WidthProperty, source, AnchorsBase::WidthProperty));
+    QCOMPARE(base->errorCode(), AnchorsBase::Conflict);
+    QVERIFY(!base->hasBinding(AnchorsBase::WidthProperty));
+
+    // a widget can't be sized by itself through a binding
+    QVERIFY(!base->setSizeBinding(AnchorsBase::HeightProperty, w, AnchorsBase::WidthProperty));
+    QCOMPARE(base->errorCode(), AnchorsBase::LoopBind);
+    QCOMPARE(w->geometry(), QRect(0, 0, 400, 10));
+}
+
+void TestBindings::cleared()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    QVERIFY(base->setSizeBinding(AnchorsBase::HeightProperty, source, AnchorsBase::HeightProperty, 2));
+    QCOMPARE(w->height(), 40);
+
+    base->clearBinding(AnchorsBase::HeightProperty);
+    QVERIFY(!base->hasBinding(AnchorsBase::HeightProperty));
+    QVERIFY(base->bindingDependencies(AnchorsBase::HeightProperty).isEmpty());
+
+    // the widget keeps the size the binding gave it
+    source->resize(50, 30);
+    QCOMPARE(w->height(), 40);
+}
+
+void TestBindings::oscillation()
+{
+    QWidget *first = createWidget(10, 10);
+    QWidget *second = createWidget(10, 10);
+    AnchorsBase *firstBase = AnchorsBase::createAnchorBase(first);
+    AnchorsBase *secondBase = AnchorsBase::createAnchorBase(second);
+    OscillationScope scope;
+    int limit = AnchorsBase::iterationLimit();
+
+    AnchorsBase::setIterationLimit(8);
+
+    QVERIFY(firstBase->setBinding(AnchorsBase::LeftProperty, [second]() {
+        return AnchorsBase::valueOf(second, Qt::AnchorLeft) + 10;
+    }));
+    QCOMPARE(first->x(), 10);
+
+    // each edge follows the other, the pass stops at the iteration limit
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("oscillation detected"));
+    QVERIFY(secondBase->setBinding(AnchorsBase::LeftProperty, [first]() {
+        return AnchorsBase::valueOf(first, Qt::AnchorLeft) + 10;
+    }));
+
+    AnchorsBase::setIterationLimit(limit);
+
+    QVERIFY(scope.reports >= 1);
+    QVERIFY(scope.involved.contains(first));
+    QVERIFY(scope.involved.contains(second));
+    QVERIFY(firstBase->errorCode() == AnchorsBase::Oscillation
+            || secondBase->errorCode() == AnchorsBase::Oscillation);
+    QVERIFY(first->x() < 400 && second->x() < 400);
+}
+
+void TestBindings::cleanup()
+{
+    delete window;
+    window = NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestBindings test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_bindings.moc"
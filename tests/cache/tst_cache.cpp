@@ -0,0 +1,223 @@
+#include <QApplication>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+
+class TestCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void hitAndMiss();
+    void capacity();
+    void anchorsChanged();
+    void movedByHand();
+    void invalidated();
+    void bindings();
+    void cleanup();
+
+private:
+    void resizeRoot(int width, int height);
+    void verifyGeometry();
+
+    QWidget *window = NULL;
+    QWidget *root = NULL;
+    QWidget *header = NULL;
+    QWidget *body = NULL;
+    AnchorsLayoutCache *cache = NULL;
+    int margins = 5;
+};
+
+void TestCache::init()
+{
+    window = new QWidget;
+    window->resize(600, 500);
+    root = new QWidget(window);
+    root->setGeometry(0, 0, 400, 300);
+    header = new QWidget(root);
+    header->resize(10, 30);
+    body = new QWidget(root);
+
+    // a header over the full width and a body taking the rest
+    AnchorsBase *base = AnchorsBase::createAnchorBase(header);
+
+    base->setAnchor(Qt::AnchorTop, root, Qt::AnchorTop);
+    base->setAnchor(Qt::AnchorLeft, root, Qt::AnchorLeft);
+    base->setAnchor(Qt::AnchorRight, root, Qt::AnchorRight);
+    base->setMargins(margins);
+
+    base = AnchorsBase::createAnchorBase(body);
+    base->setAnchor(Qt::AnchorTop, header, Qt::AnchorBottom);
+    base->setAnchor(Qt::AnchorBottom, root, Qt::AnchorBottom);
+    base->setAnchor(Qt::AnchorLeft, root, Qt::AnchorLeft);
+    base->setAnchor(Qt::AnchorRight, root, Qt::AnchorRight);
+    base->setMargins(margins);
+
+    cache = new AnchorsLayoutCache(root);
+
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+
+    // entries start with the first size the root settles at
+    cache->invalidate();
+    verifyGeometry();
+}
+
+void TestCache::resizeRoot(int width, int height)
+{
+    root->resize(width, height);
+    verifyGeometry();
+}
+
+// where the cascade puts the header and the body for the root's size
+void TestCache::verifyGeometry()
+{
+    int width = root->width() - 2 * margins;
+    int top = margins + 30 + margins;
+
+    QCOMPARE(header->geometry(), QRect(margins, margins, width, 30));
+    QCOMPARE(body->geometry(), QRect(margins, top, width, root->height() - margins - top));
+}
+
+void TestCache::hitAndMiss()
+{
+    int hits = cache->hits();
+    int misses = cache->misses();
+
+    // a size is stored once the root leaves it
+    resizeRoot(500, 400);
+    QCOMPARE(cache->count(), 0);
+    resizeRoot(450, 350);
+    QCOMPARE(cache->count(), 1);
+    QCOMPARE(cache->hits(), hits);
+    QCOMPARE(cache->misses(), misses + 2);
+
+    resizeRoot(500, 400);
+    QCOMPARE(cache->count(), 2);
+    QCOMPARE(cache->hits(), hits + 1);
+
+    resizeRoot(450, 350);
+    resizeRoot(500, 400);
+    QCOMPARE(cache->count(), 2);
+    QCOMPARE(cache->hits(), hits + 3);
+    QCOMPARE(cache->misses(), misses + 2);
+}
+
+void TestCache::capacity()
+{
+    cache->setCapacity(2);
+
+    for (int i = 0; i < 4; ++i) {
+        resizeRoot(300 + 10 * i, 300);
+    }
+
+    // only the two sizes left last are kept
+    QCOMPARE(cache->count(), 2);
+
+    int hits = cache->hits();
+
+    resizeRoot(320, 300);
+    QCOMPARE(cache->hits(), hits + 1);
+    resizeRoot(300, 300);
+    QCOMPARE(cache->hits(), hits + 1);
+
+    cache->setCapacity(1);
+    QCOMPARE(cache->count(), 1);
+}
+
+void TestCache::anchorsChanged()
+{
+    resizeRoot(500, 400);
+    resizeRoot(450, 350);
+    QCOMPARE(cache->count(), 1);
+
+    // a new margin makes every stored layout stale
+    margins = 8;
+    AnchorsBase::getAnchorBaseByWidget(header)->setMargins(margins);
+    AnchorsBase::getAnchorBaseByWidget(body)->setMargins(margins);
+
+    int hits = cache->hits();
+
+    resizeRoot(500, 400);
+    QCOMPARE(cache->hits(), hits);
+    QCOMPARE(cache->count(), 0);
+    QCOMPARE(header->geometry(), QRect(8, 8, 484, 30));
+    QCOMPARE(body->geometry(), QRect(8, 46, 484, 346));
+}
+
+void TestCache::movedByHand()
+{
+    resizeRoot(500, 400);
+    resizeRoot(450, 350);
+    QCOMPARE(cache->count(), 1);
+
+    // a geometry no anchor pass set is not in any entry either
+    header->move(20, margins);
+
+    int hits = cache->hits();
+
+    resizeRoot(500, 400);
+    QCOMPARE(cache->hits(), hits);
+    QCOMPARE(cache->count(), 0);
+}
+
+void TestCache::invalidated()
+{
+    resizeRoot(500, 400);
+    resizeRoot(450, 350);
+    resizeRoot(500, 400);
+    QCOMPARE(cache->count(), 2);
+
+    cache->invalidate();
+    QCOMPARE(cache->count(), 0);
+
+    int hits = cache->hits();
+
+    resizeRoot(450, 350);
+    QCOMPARE(cache->hits(), hits);
+}
+
+void TestCache::bindings()
+{
+    QWidget *badge = new QWidget(root);
+
+    badge->resize(10, 10);
+    QVERIFY(AnchorsBase::createAnchorBase(badge)->setBinding(AnchorsBase::LeftProperty, []() {
+        return 7;
+    }));
+
+    // the cache can't tell what an expression reads, so it stays out of it
+    int hits = cache->hits();
+    int misses = cache->misses();
+
+    resizeRoot(500, 400);
+    resizeRoot(450, 350);
+    resizeRoot(500, 400);
+    QCOMPARE(cache->hits(), hits);
+    QCOMPARE(cache->misses(), misses + 3);
+    QCOMPARE(cache->count(), 0);
+    QCOMPARE(badge->x(), 7);
+}
+
+void TestCache::cleanup()
+{
+    delete window;
+    window = NULL;
+    margins = 5;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestCache test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_cache.moc"
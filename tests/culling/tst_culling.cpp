@@ -0,0 +1,193 @@
+#include <QApplication>
+#include <QScrollArea>
+#include <QScrollBar>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+
+class TestCulling : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void culled();
+    void scrolled();
+    void margin();
+    void scrollAxis();
+    void dependency();
+    void resolved();
+    void cleanup();
+
+private:
+    int visibleRows() const;
+    int widenedCount() const;
+
+    QScrollArea *area = NULL;
+    QWidget *content = NULL;
+    QList<QWidget *> rows;
+    AnchorsViewportCulling *culling = NULL;
+};
+
+void TestCulling::init()
+{
+    area = new QScrollArea;
+    area->resize(300, 200);
+    area->setFrameShape(QFrame::NoFrame);
+    area->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    content = new QWidget;
+    content->resize(300, 2000);
+
+    // a list of full width rows, each below the previous one
+    QWidget *previous = NULL;
+
+    for (int i = 0; i < 100; ++i) {
+        QWidget *w = new QWidget(content);
+        AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+        w->resize(10, 20);
+        if (previous) {
+            base->setAnchor(Qt::AnchorTop, previous, Qt::AnchorBottom);
+        } else {
+            base->setAnchor(Qt::AnchorTop, content, Qt::AnchorTop);
+        }
+        base->setAnchor(Qt::AnchorLeft, content, Qt::AnchorLeft);
+        base->setAnchor(Qt::AnchorRight, content, Qt::AnchorRight);
+        rows << w;
+        previous = w;
+    }
+
+    area->setWidget(content);
+    area->show();
+    QVERIFY(QTest::qWaitForWindowExposed(area));
+
+    culling = new AnchorsViewportCulling(area);
+    culling->setMargin(0);
+    QCOMPARE(rows.last()->geometry(), QRect(0, 1980, 300, 20));
+}
+
+// the rows that intersect the viewport, the list starts at its top
+int TestCulling::visibleRows() const
+{
+    int bottom = area->verticalScrollBar()->value() + area->viewport()->height() - 1 + culling->margin();
+
+    return qMin(rows.size(), bottom / 20 + 1);
+}
+
+int TestCulling::widenedCount() const
+{
+    int count = 0;
+
+    foreach (QWidget *w, rows) {
+        count += w->width() == content->width();
+    }
+
+    return count;
+}
+
+void TestCulling::culled()
+{
+    int visible = visibleRows();
+
+    content->resize(400, 2000);
+
+    // only the rows in view get their new width
+    QCOMPARE(culling->pendingCount(), rows.size() - visible);
+    QCOMPARE(widenedCount(), visible);
+    QCOMPARE(rows.at(visible - 1)->geometry(), QRect(0, (visible - 1) * 20, 400, 20));
+    QCOMPARE(rows.at(visible)->geometry(), QRect(0, visible * 20, 300, 20));
+}
+
+void TestCulling::scrolled()
+{
+    content->resize(400, 2000);
+    area->verticalScrollBar()->setValue(1000);
+
+    // the rows scrolled into view catch up, the ones above stay laid out
+    int visible = visibleRows() - 50;
+
+    QCOMPARE(rows.at(50)->width(), 400);
+    QCOMPARE(rows.at(49 + visible)->width(), 400);
+    QCOMPARE(rows.at(50 + visible)->width(), 300);
+    QCOMPARE(rows.at(0)->width(), 400);
+    QCOMPARE(culling->pendingCount(), rows.size() - 2 * visible);
+}
+
+void TestCulling::margin()
+{
+    content->resize(400, 2000);
+
+    int before = culling->pendingCount();
+
+    // rows within the margin around the viewport count as visible
+    culling->setMargin(100);
+    QCOMPARE(culling->pendingCount(), before - 5);
+    QCOMPARE(widenedCount(), visibleRows());
+}
+
+void TestCulling::scrollAxis()
+{
+    content->resize(400, 2000);
+    AnchorsBase::getAnchorBaseByWidget(rows.first())->setTopMargin(30);
+
+    // positions along the scroll axis are never culled
+    QCOMPARE(rows.last()->geometry().top(), 30 + 99 * 20);
+}
+
+void TestCulling::dependency()
+{
+    QWidget *marker = new QWidget(content);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(marker);
+
+    marker->resize(10, 10);
+    marker->show();
+    base->setAnchor(Qt::AnchorTop, content, Qt::AnchorTop);
+    base->setAnchor(Qt::AnchorLeft, rows.at(50), Qt::AnchorRight);
+    QCOMPARE(marker->x(), 300);
+
+    // a visible widget never reads the stale geometry of a culled one
+    content->resize(400, 2000);
+    QCOMPARE(rows.at(50)->width(), 400);
+    QCOMPARE(marker->x(), 400);
+    QCOMPARE(culling->pendingCount(), rows.size() - visibleRows() - 1);
+}
+
+void TestCulling::resolved()
+{
+    content->resize(400, 2000);
+    QVERIFY(culling->pendingCount() > 0);
+
+    culling->resolveAll();
+    QCOMPARE(culling->pendingCount(), 0);
+    QCOMPARE(widenedCount(), rows.size());
+
+    // without culling every row follows at once
+    delete culling;
+    culling = NULL;
+    content->resize(350, 2000);
+    QCOMPARE(widenedCount(), rows.size());
+}
+
+void TestCulling::cleanup()
+{
+    delete culling;
+    culling = NULL;
+    delete area;
+    area = NULL;
+    rows.clear();
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestCulling test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_culling.moc"
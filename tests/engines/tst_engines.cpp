@@ -0,0 +1,212 @@
+#include <QApplication>
+#include <QRegularExpression>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+
+// the regular arithmetic, one pixel further along every bound axis; an
+// axis without anchors is left alone
+class ShiftedEngine : public AnchorsEngine
+{
+public:
+    QString name() const Q_DECL_OVERRIDE
+    {
+        return "shifted";
+    }
+
+    int resolve(Axis &axis) const Q_DECL_OVERRIDE
+    {
+        int index = AnchorsEngine::cascade()->resolve(axis);
+
+        if (index >= 0) {
+            ++axis.start;
+        }
+
+        return index;
+    }
+};
+
+class TestEngines : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void selected();
+    void agreeing();
+    void mismatch();
+    void comparedFirstCommits();
+    void restarted();
+    void otherWindow();
+    void cleanup();
+
+private:
+    QWidget *createWindow(QWidget **item);
+
+    QList<QWidget *> windows;
+    QWidget *window = NULL;
+    QWidget *stretched = NULL;
+    QWidget *centered = NULL;
+    ShiftedEngine shifted;
+};
+
+// an item stretched between the window's edges
+QWidget *TestEngines::createWindow(QWidget **item)
+{
+    QWidget *w = new QWidget;
+
+    w->resize(400, 300);
+    *item = new QWidget(w);
+    (*item)->resize(20, 20);
+
+    AnchorsBase *base = AnchorsBase::createAnchorBase(*item);
+
+    base->setAnchor(Qt::AnchorLeft, w, Qt::AnchorLeft);
+    base->setAnchor(Qt::AnchorRight, w, Qt::AnchorRight);
+    base->setMargins(10);
+
+    w->show();
+    windows << w;
+
+    return w;
+}
+
+void TestEngines::init()
+{
+    // and one centered in the window
+    window = createWindow(&stretched);
+    centered = new QWidget(window);
+    centered->resize(20, 20);
+    centered->show();
+    AnchorsBase::createAnchorBase(centered)->setCenterIn(window);
+
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+    QCOMPARE(stretched->geometry(), QRect(10, 0, 380, 20));
+    QCOMPARE(centered->geometry(), QRect(190, 140, 20, 20));
+}
+
+void TestEngines::selected()
+{
+    QCOMPARE(AnchorsEngine::engine(window), AnchorsEngine::cascade());
+
+    AnchorsEngine::setEngine(window, &shifted);
+    QCOMPARE(AnchorsEngine::engine(stretched), static_cast<AnchorsEngine *>(&shifted));
+
+    window->resize(500, 300);
+    QCOMPARE(stretched->geometry(), QRect(11, 0, 480, 20));
+    QCOMPARE(centered->geometry(), QRect(241, 141, 20, 20));
+    QCOMPARE(AnchorsEngine::comparison(window).resolves, qint64(0));
+
+    // the cascade is the default, selecting it drops the selection
+    AnchorsEngine::setEngine(window, AnchorsEngine::cascade());
+    window->resize(400, 300);
+    QCOMPARE(stretched->geometry(), QRect(10, 0, 380, 20));
+    QCOMPARE(centered->geometry(), QRect(190, 140, 20, 20));
+}
+
+void TestEngines::agreeing()
+{
+    AnchorsEngine::compare(window, AnchorsEngine::span(), AnchorsEngine::cascade());
+
+    window->resize(500, 350);
+    window->resize(451, 301);
+
+    AnchorsEngineComparison comparison = AnchorsEngine::comparison(window);
+
+    QCOMPARE(comparison.first, QString("span"));
+    QCOMPARE(comparison.second, QString("cascade"));
+    QVERIFY(comparison.resolves >= 4);
+    QCOMPARE(comparison.mismatches, qint64(0));
+    QCOMPARE(stretched->geometry(), QRect(10, 0, 431, 20));
+    QCOMPARE(centered->geometry(), QRect(215, 140, 20, 20));
+}
+
+void TestEngines::mismatch()
+{
+    AnchorsEngine::compare(window, AnchorsEngine::cascade(), &shifted);
+
+    // a disagreement is counted every time and only reported the first time
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("engines .*cascade.* and .*shifted.* disagree"));
+    window->resize(500, 300);
+
+    AnchorsEngineComparison comparison = AnchorsEngine::comparison(window);
+    qint64 mismatches = comparison.mismatches;
+
+    QVERIFY(mismatches >= 3);
+    QVERIFY(comparison.resolves >= mismatches);
+
+    window->resize(400, 300);
+    comparison = AnchorsEngine::comparison(window);
+    QVERIFY(comparison.mismatches >= mismatches + 3);
+    QVERIFY(comparison.firstNsecs > 0 || comparison.secondNsecs > 0);
+
+    // the first engine's result is the one committed
+    QCOMPARE(stretched->geometry(), QRect(10, 0, 380, 20));
+    QCOMPARE(centered->geometry(), QRect(190, 140, 20, 20));
+}
+
+void TestEngines::comparedFirstCommits()
+{
+    AnchorsEngine::compare(window, &shifted, AnchorsEngine::cascade());
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("disagree"));
+    window->resize(500, 300);
+
+    QCOMPARE(stretched->geometry(), QRect(11, 0, 480, 20));
+    QCOMPARE(centered->geometry(), QRect(241, 141, 20, 20));
+    QCOMPARE(AnchorsEngine::comparison(window).first, QString("shifted"));
+}
+
+void TestEngines::restarted()
+{
+    AnchorsEngine::compare(window, AnchorsEngine::cascade(), &shifted);
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("disagree"));
+    window->resize(500, 300);
+    QVERIFY(AnchorsEngine::comparison(window).mismatches > 0);
+
+    // a new comparison starts from zero
+    AnchorsEngine::compare(window, AnchorsEngine::cascade(), AnchorsEngine::span());
+    QCOMPARE(AnchorsEngine::comparison(window).resolves, qint64(0));
+    window->resize(400, 300);
+    QVERIFY(AnchorsEngine::comparison(window).resolves > 0);
+    QCOMPARE(AnchorsEngine::comparison(window).mismatches, qint64(0));
+}
+
+void TestEngines::otherWindow()
+{
+    QWidget *item = NULL;
+    QWidget *other = createWindow(&item);
+
+    QVERIFY(QTest::qWaitForWindowExposed(other));
+    AnchorsEngine::setEngine(window, &shifted);
+
+    // the selection is per window
+    other->resize(500, 300);
+    QCOMPARE(item->geometry(), QRect(10, 0, 480, 20));
+    QCOMPARE(AnchorsEngine::engine(other), AnchorsEngine::cascade());
+
+    window->resize(500, 300);
+    QCOMPARE(stretched->geometry(), QRect(11, 0, 480, 20));
+}
+
+void TestEngines::cleanup()
+{
+    qDeleteAll(windows);
+    windows.clear();
+    window = NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestEngines test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_engines.moc"
@@ -0,0 +1,212 @@
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+
+// a widget that takes a few milliseconds to move, so that a slice can't
+// place more than one of them within a one millisecond budget
+class SlowWidget : public QWidget
+{
+public:
+    explicit SlowWidget(QWidget *parent = 0):
+        QWidget(parent)
+    {
+    }
+
+protected:
+    void moveEvent(QMoveEvent *e) Q_DECL_OVERRIDE
+    {
+        QElapsedTimer clock;
+
+        clock.start();
+        while (clock.elapsed() < 3) {
+        }
+
+        QWidget::moveEvent(e);
+    }
+};
+
+class TestIncremental : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void deferred();
+    void slices();
+    void stopped();
+    void budget();
+    void cleanup();
+
+private:
+    int movedCount(const QList<QWidget *> &list) const;
+    bool processSlice();
+
+    QWidget *window = NULL;
+    QWidget *root = NULL;
+    QList<QWidget *> visibleItems;
+    QList<QWidget *> hiddenItems;
+    AnchorsIncrementalLayout *layout = NULL;
+};
+
+void TestIncremental::init()
+{
+    window = new QWidget;
+    window->resize(400, 300);
+    root = new QWidget(window);
+    root->setGeometry(0, 0, 400, 300);
+
+    // every item is pinned to the root's right edge on its own, so each
+    // one is a separate entry of the dirty list
+    for (int i = 0; i < 15; ++i) {
+        QWidget *w = new SlowWidget(root);
+
+        w->setGeometry(0, i * 20, 20, 20);
+        AnchorsBase::createAnchorBase(w)->setAnchor(Qt::AnchorRight, root, Qt::AnchorRight);
+        visibleItems << w;
+    }
+    for (int i = 0; i < 5; ++i) {
+        QWidget *w = new QWidget(root);
+
+        w->setGeometry(40, i * 20, 20, 20);
+        AnchorsBase::createAnchorBase(w)->setAnchor(Qt::AnchorRight, root, Qt::AnchorRight);
+        w->hide();
+        hiddenItems << w;
+    }
+
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+    QCOMPARE(visibleItems.first()->x(), 380);
+
+    layout = new AnchorsIncrementalLayout;
+    layout->start();
+    QVERIFY(layout->isActive());
+    QVERIFY(layout->isSettled());
+}
+
+int TestIncremental::movedCount(const QList<QWidget *> &list) const
+{
+    int count = 0;
+
+    foreach (QWidget *w, list) {
+        count += w->x() == root->width() - 20;
+    }
+
+    return count;
+}
+
+// one pass of the event loop runs at most one slice, a slice restarts its
+// timer for the next pass
+bool TestIncremental::processSlice()
+{
+    int pending = layout->pendingCount();
+
+    for (int i = 0; i < 1000 && layout->pendingCount() == pending; ++i) {
+        QCoreApplication::processEvents();
+    }
+
+    return layout->pendingCount() != pending;
+}
+
+void TestIncremental::deferred()
+{
+    root->resize(300, 300);
+
+    QCOMPARE(layout->pendingCount(), 20);
+    QVERIFY(!layout->isSettled());
+    QCOMPARE(movedCount(visibleItems), 0);
+
+    QTRY_VERIFY(layout->isSettled());
+    QCOMPARE(movedCount(visibleItems), visibleItems.size());
+    QCOMPARE(movedCount(hiddenItems), hiddenItems.size());
+}
+
+void TestIncremental::slices()
+{
+    QSignalSpy overrun(layout, &AnchorsIncrementalLayout::overrun);
+    QSignalSpy settled(layout, &AnchorsIncrementalLayout::settled);
+
+    layout->setBudget(1);
+    root->resize(300, 300);
+
+    // the first item of a slice always runs, the next one would not fit
+    QVERIFY(processSlice());
+    QCOMPARE(layout->pendingCount(), 19);
+    QCOMPARE(movedCount(visibleItems), 1);
+    QCOMPARE(overrun.count(), 1);
+    QCOMPARE(overrun.first().at(1).toInt(), 1);
+
+    // the visible items are placed before any hidden one
+    while (!layout->isSettled()) {
+        QVERIFY(processSlice());
+        if (movedCount(hiddenItems)) {
+            QCOMPARE(movedCount(visibleItems), visibleItems.size());
+        }
+    }
+
+    QCOMPARE(movedCount(hiddenItems), hiddenItems.size());
+    QCOMPARE(settled.count(), 1);
+    QVERIFY(overrun.count() >= visibleItems.size());
+}
+
+void TestIncremental::stopped()
+{
+    QSignalSpy settled(layout, &AnchorsIncrementalLayout::settled);
+    QSignalSpy active(layout, &AnchorsIncrementalLayout::activeChanged);
+
+    layout->setBudget(1);
+    root->resize(300, 300);
+    QVERIFY(processSlice());
+    QVERIFY(movedCount(visibleItems) < visibleItems.size());
+
+    // what is left is laid out at once
+    layout->stop();
+    QVERIFY(!layout->isActive());
+    QVERIFY(layout->isSettled());
+    QCOMPARE(movedCount(visibleItems), visibleItems.size());
+    QCOMPARE(movedCount(hiddenItems), hiddenItems.size());
+    QCOMPARE(settled.count(), 1);
+    QCOMPARE(active.count(), 1);
+
+    // without the mode changes apply synchronously again
+    root->resize(250, 300);
+    QCOMPARE(movedCount(visibleItems), visibleItems.size());
+}
+
+void TestIncremental::budget()
+{
+    QSignalSpy changed(layout, &AnchorsIncrementalLayout::budgetChanged);
+
+    QCOMPARE(layout->budget(), 8);
+    layout->setBudget(0);
+    QCOMPARE(layout->budget(), 1);
+    layout->setBudget(1);
+    QCOMPARE(changed.count(), 1);
+}
+
+void TestIncremental::cleanup()
+{
+    delete layout;
+    layout = NULL;
+    delete window;
+    window = NULL;
+    visibleItems.clear();
+    hiddenItems.clear();
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestIncremental test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_incremental.moc"
@@ -0,0 +1,15 @@
+QT       += core gui widgets testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_positioners
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_positioners.cpp \
+    ../../anchors.cpp \
+    ../../anchorspositioner.cpp
+
+HEADERS  += ../../anchors.h \
+    ../../anchorspositioner.h
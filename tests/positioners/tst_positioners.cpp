@@ -0,0 +1,199 @@
+#include <QApplication>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+#include "anchorspositioner.h"
+
+class TestPositioners : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void row();
+    void column();
+    void grid();
+    void flow();
+    void hiddenItem();
+    void anchoredSize();
+    void cleanup();
+
+private:
+    static QWidget *createItem(QWidget *parent, int width, int height);
+
+    QWidget *window = NULL;
+};
+
+QWidget *TestPositioners::createItem(QWidget *parent, int width, int height)
+{
+    QWidget *w = new QWidget(parent);
+
+    w->resize(width, height);
+
+    return w;
+}
+
+void TestPositioners::init()
+{
+    window = new QWidget;
+    window->resize(400, 300);
+}
+
+void TestPositioners::row()
+{
+    AnchorsRow *row = new AnchorsRow(window);
+    QWidget *first = createItem(row, 10, 20);
+    QWidget *second = createItem(row, 30, 10);
+    QWidget *third = createItem(row, 20, 15);
+
+    row->setContentsMargins(3, 4, 3, 4);
+    row->setSpacing(5);
+    row->forceLayout();
+
+    QCOMPARE(first->pos(), QPoint(3, 4));
+    QCOMPARE(second->pos(), QPoint(18, 4));
+    QCOMPARE(third->pos(), QPoint(53, 4));
+    QCOMPARE(row->size(), QSize(76, 28));
+    QCOMPARE(row->sizeHint(), QSize(76, 28));
+}
+
+void TestPositioners::column()
+{
+    AnchorsColumn *column = new AnchorsColumn(window);
+    QWidget *first = createItem(column, 10, 20);
+    QWidget *second = createItem(column, 30, 10);
+    QWidget *third = createItem(column, 20, 15);
+
+    column->setSpacing(2);
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+    column->forceLayout();
+
+    QCOMPARE(first->pos(), QPoint(0, 0));
+    QCOMPARE(second->pos(), QPoint(0, 22));
+    QCOMPARE(third->pos(), QPoint(0, 34));
+    QCOMPARE(column->size(), QSize(30, 49));
+
+    // a taller item pushes the ones after it down
+    first->resize(10, 40);
+    column->forceLayout();
+
+    QCOMPARE(second->pos(), QPoint(0, 42));
+    QCOMPARE(third->pos(), QPoint(0, 54));
+    QCOMPARE(column->size(), QSize(30, 69));
+}
+
+void TestPositioners::grid()
+{
+    AnchorsGrid *grid = new AnchorsGrid(window);
+    QList<QWidget *> items;
+
+    items << createItem(grid, 10, 10) << createItem(grid, 30, 20)
+          << createItem(grid, 20, 5) << createItem(grid, 5, 25);
+
+    grid->setColumns(2);
+    grid->setSpacing(2);
+    grid->forceLayout();
+
+    // every cell takes the widest item of its column and the tallest of its row
+    QCOMPARE(items.at(0)->pos(), QPoint(0, 0));
+    QCOMPARE(items.at(1)->pos(), QPoint(22, 0));
+    QCOMPARE(items.at(2)->pos(), QPoint(0, 22));
+    QCOMPARE(items.at(3)->pos(), QPoint(22, 22));
+    QCOMPARE(grid->size(), QSize(52, 47));
+
+    grid->setColumns(3);
+    grid->forceLayout();
+
+    QCOMPARE(items.at(2)->pos(), QPoint(44, 0));
+    QCOMPARE(items.at(3)->pos(), QPoint(0, 22));
+    QCOMPARE(grid->size(), QSize(64, 47));
+}
+
+void TestPositioners::flow()
+{
+    AnchorsFlow *flow = new AnchorsFlow(window);
+    QList<QWidget *> items;
+
+    flow->resize(50, 10);
+    for (int i = 0; i < 4; ++i) {
+        items << createItem(flow, 20, 10);
+    }
+    flow->setSpacing(5);
+    flow->forceLayout();
+
+    QCOMPARE(items.at(0)->pos(), QPoint(0, 0));
+    QCOMPARE(items.at(1)->pos(), QPoint(25, 0));
+    QCOMPARE(items.at(2)->pos(), QPoint(0, 15));
+    QCOMPARE(items.at(3)->pos(), QPoint(25, 15));
+    QCOMPARE(flow->size(), QSize(50, 25));
+
+    // a wider flow rewraps its items onto one line
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+    flow->resize(100, 25);
+    flow->forceLayout();
+
+    QCOMPARE(items.at(2)->pos(), QPoint(50, 0));
+    QCOMPARE(items.at(3)->pos(), QPoint(75, 0));
+    QCOMPARE(flow->size(), QSize(100, 10));
+}
+
+void TestPositioners::hiddenItem()
+{
+    AnchorsRow *row = new AnchorsRow(window);
+    QWidget *first = createItem(row, 10, 20);
+    QWidget *second = createItem(row, 30, 10);
+    QWidget *third = createItem(row, 20, 15);
+
+    row->setSpacing(5);
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+    row->forceLayout();
+
+    QCOMPARE(third->pos(), QPoint(50, 0));
+
+    // the hidden item leaves no gap, the change is picked up by the event loop
+    second->hide();
+    QTRY_COMPARE(third->pos(), QPoint(15, 0));
+    QCOMPARE(first->pos(), QPoint(0, 0));
+    QCOMPARE(row->size(), QSize(35, 20));
+}
+
+void TestPositioners::anchoredSize()
+{
+    AnchorsRow *row = new AnchorsRow(window);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(row);
+
+    createItem(row, 10, 20);
+    createItem(row, 30, 10);
+
+    QVERIFY(base->setAnchor(Qt::AnchorLeft, window, Qt::AnchorLeft));
+    QVERIFY(base->setAnchor(Qt::AnchorRight, window, Qt::AnchorRight));
+    row->forceLayout();
+
+    // the anchors own the width, the content only gives the height
+    QCOMPARE(row->size(), QSize(400, 20));
+    QCOMPARE(row->sizeHint(), QSize(40, 20));
+}
+
+void TestPositioners::cleanup()
+{
+    delete window;
+    window = NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestPositioners test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_positioners.moc"
@@ -0,0 +1,15 @@
+QT       += core gui widgets testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_reclaim
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_reclaim.cpp \
+    ../../anchors.cpp \
+    ../../anchorsgraph.cpp
+
+HEADERS  += ../../anchors.h \
+    ../../anchorsgraph.h
@@ -0,0 +1,108 @@
+#include <QApplication>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+#include "anchorsgraph.h"
+
+class TestReclaim : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void idleAfterClear();
+    void idleAfterGraphExport();
+    void retained();
+    void cleanup();
+
+private:
+    QWidget *window = NULL;
+    QWidget *source = NULL;
+    QWidget *target = NULL;
+};
+
+void TestReclaim::init()
+{
+    AnchorsBase::setAutoReclaim(true);
+
+    window = new QWidget;
+    window->resize(400, 300);
+    target = new QWidget(window);
+    target->setGeometry(10, 20, 100, 50);
+    source = new QWidget(window);
+    source->resize(30, 30);
+
+    QVERIFY(AnchorsBase::setAnchor(source, Qt::AnchorLeft, target, Qt::AnchorRight));
+    QCOMPARE(source->x(), 110);
+}
+
+void TestReclaim::idleAfterClear()
+{
+    AnchorsBase *base = AnchorsBase::getAnchorBaseByWidget(source);
+
+    QVERIFY(base);
+    QVERIFY(!base->isRetained());
+    QVERIFY(AnchorsBase::getAnchorBaseByWidget(target));
+
+    base->setLeft(NULL);
+    QCoreApplication::processEvents();
+
+    QVERIFY(!AnchorsBase::getAnchorBaseByWidget(source));
+    QVERIFY(!AnchorsBase::getAnchorBaseByWidget(target));
+}
+
+void TestReclaim::idleAfterGraphExport()
+{
+    AnchorsGraph graph(window);
+
+    QCOMPARE(graph.edges().count(), 1);
+    QVERIFY(!graph.toJson().isEmpty());
+
+    // exporting the graph only looks the objects up
+    QVERIFY(!AnchorsBase::getAnchorBaseByWidget(source)->isRetained());
+    QVERIFY(!AnchorsBase::getAnchorBaseByWidget(target)->isRetained());
+
+    AnchorsBase::getAnchorBaseByWidget(source)->setLeft(NULL);
+    QCoreApplication::processEvents();
+
+    QVERIFY(!AnchorsBase::getAnchorBaseByWidget(source));
+    QVERIFY(!AnchorsBase::getAnchorBaseByWidget(target));
+}
+
+void TestReclaim::retained()
+{
+    AnchorsBase *base = AnchorsBase::getAnchorBaseByWidget(source);
+
+    base->setRetained(true);
+    base->setLeft(NULL);
+    QCoreApplication::processEvents();
+
+    QCOMPARE(AnchorsBase::getAnchorBaseByWidget(source), base);
+    QVERIFY(!AnchorsBase::getAnchorBaseByWidget(target));
+
+    base->setRetained(false);
+    QCoreApplication::processEvents();
+
+    QVERIFY(!AnchorsBase::getAnchorBaseByWidget(source));
+}
+
+void TestReclaim::cleanup()
+{
+    delete window;
+    window = NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestReclaim test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_reclaim.moc"
@@ -0,0 +1,154 @@
+#include <QApplication>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+
+class RepaintRecorder : public AnchorsObserver
+{
+public:
+    void repaintRequested(const QWidget *parent, const QRect &rect) Q_DECL_OVERRIDE
+    {
+        parents << parent;
+        rects << rect;
+    }
+
+    QList<const QWidget *> parents;
+    QList<QRect> rects;
+};
+
+class TestRepaints : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void singleMove();
+    void adjacentMoves();
+    void unchanged();
+    void disabled();
+    void cleanup();
+
+private:
+    QWidget *follow(QWidget *target);
+
+    QWidget *window = NULL;
+    QWidget *handle = NULL;
+};
+
+void TestRepaints::init()
+{
+    AnchorsBase::setRepaintCoalescing(true);
+
+    window = new QWidget;
+    window->resize(400, 300);
+    handle = new QWidget(window);
+    handle->setGeometry(10, 10, 30, 20);
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+}
+
+QWidget *TestRepaints::follow(QWidget *target)
+{
+    QWidget *w = new QWidget(window);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    w->resize(20, 20);
+    w->show();
+    base->setAnchor(Qt::AnchorLeft, target, Qt::AnchorRight);
+    base->setAnchor(Qt::AnchorTop, target, Qt::AnchorTop);
+
+    return w;
+}
+
+void TestRepaints::singleMove()
+{
+    QWidget *w = follow(handle);
+
+    QCOMPARE(w->geometry(), QRect(40, 10, 20, 20));
+
+    RepaintRecorder recorder;
+
+    handle->move(110, 10);
+
+    // the old and the new area, nothing in between
+    QCOMPARE(w->geometry(), QRect(140, 10, 20, 20));
+    QCOMPARE(recorder.rects.size(), 2);
+    QCOMPARE(recorder.parents.at(0), (const QWidget *)window);
+    QCOMPARE(recorder.parents.at(1), (const QWidget *)window);
+    QCOMPARE(recorder.rects.at(0), QRect(40, 10, 20, 20));
+    QCOMPARE(recorder.rects.at(1), QRect(140, 10, 20, 20));
+    QVERIFY(w->updatesEnabled());
+}
+
+void TestRepaints::adjacentMoves()
+{
+    QWidget *previous = handle;
+    QList<QWidget *> chain;
+
+    for (int i = 0; i < 5; ++i) {
+        previous = follow(previous);
+        chain << previous;
+    }
+    QCOMPARE(chain.last()->geometry(), QRect(120, 10, 20, 20));
+
+    RepaintRecorder recorder;
+
+    handle->move(20, 10);
+
+    // the five widgets touch before and after the move, one area covers
+    // everything that moved and nothing else
+    QCOMPARE(chain.last()->geometry(), QRect(130, 10, 20, 20));
+    QCOMPARE(recorder.rects.size(), 1);
+    QCOMPARE(recorder.rects.at(0), QRect(40, 10, 110, 20));
+    foreach (QWidget *w, chain) {
+        QVERIFY(w->updatesEnabled());
+    }
+}
+
+void TestRepaints::unchanged()
+{
+    QWidget *w = follow(handle);
+    RepaintRecorder recorder;
+
+    // only the height of the handle changes, its follower stays put
+    handle->resize(30, 40);
+
+    QCOMPARE(w->geometry(), QRect(40, 10, 20, 20));
+    QVERIFY(recorder.rects.isEmpty());
+}
+
+void TestRepaints::disabled()
+{
+    AnchorsBase::setRepaintCoalescing(false);
+
+    QWidget *w = follow(handle);
+    RepaintRecorder recorder;
+
+    handle->move(110, 10);
+
+    // Qt invalidates the areas itself
+    QCOMPARE(w->geometry(), QRect(140, 10, 20, 20));
+    QVERIFY(recorder.rects.isEmpty());
+}
+
+void TestRepaints::cleanup()
+{
+    AnchorsBase::setRepaintCoalescing(true);
+    delete window;
+    window = NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestRepaints test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_repaints.moc"
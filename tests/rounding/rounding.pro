@@ -0,0 +1,13 @@
+QT       += core gui widgets testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_rounding
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_rounding.cpp \
+    ../../anchors.cpp
+
+HEADERS  += ../../anchors.h
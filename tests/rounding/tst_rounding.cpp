@@ -0,0 +1,113 @@
+#include <QApplication>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+
+class TestRounding : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void fractionalPoints_data();
+    void fractionalPoints();
+    void cleanup();
+
+private:
+    QWidget *window = NULL;
+    QWidget *negative = NULL;
+    QWidget *positive = NULL;
+};
+
+void TestRounding::init()
+{
+    window = new QWidget;
+    window->resize(400, 300);
+
+    // odd sizes put the centers between two pixels, one target on each side
+    // of the origin, so truncation and flooring differ
+    negative = new QWidget(window);
+    negative->setGeometry(-11, -7, 21, 15);
+    positive = new QWidget(window);
+    positive->setGeometry(10, 4, 21, 15);
+}
+
+void TestRounding::fractionalPoints_data()
+{
+    QTest::addColumn<int>("rounding");
+    QTest::addColumn<bool>("span");
+    QTest::addColumn<QPoint>("start");
+    QTest::addColumn<QPoint>("end");
+    QTest::addColumn<int>("stretched");
+
+    // the leading points are -0.5/0.5, the trailing edges 19.5/10.5
+    QTest::newRow("down") << int(AnchorsBase::RoundDown) << false << QPoint(-1, 0) << QPoint(19, 10) << 31;
+    QTest::newRow("up") << int(AnchorsBase::RoundUp) << false << QPoint(0, 1) << QPoint(20, 11) << 32;
+    QTest::newRow("nearest") << int(AnchorsBase::RoundNearest) << false << QPoint(0, 1) << QPoint(20, 11) << 32;
+    QTest::newRow("span down") << int(AnchorsBase::RoundDown) << true << QPoint(-1, 0) << QPoint(19, 10) << 31;
+    QTest::newRow("span up") << int(AnchorsBase::RoundUp) << true << QPoint(0, 1) << QPoint(20, 11) << 32;
+    QTest::newRow("span nearest") << int(AnchorsBase::RoundNearest) << true << QPoint(0, 1) << QPoint(20, 11) << 32;
+}
+
+void TestRounding::fractionalPoints()
+{
+    QFETCH(int, rounding);
+    QFETCH(bool, span);
+    QFETCH(QPoint, start);
+    QFETCH(QPoint, end);
+    QFETCH(int, stretched);
+
+    AnchorsBase::setCenterRounding(AnchorsBase::CenterRounding(rounding));
+    if (span) {
+        AnchorsEngine::setEngine(window, AnchorsEngine::span());
+    }
+
+    QWidget *leading = new QWidget(window);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(leading);
+
+    leading->resize(30, 20);
+    base->setAnchor(Qt::AnchorLeft, negative, Qt::AnchorHorizontalCenter);
+    base->setAnchor(Qt::AnchorTop, negative, Qt::AnchorVerticalCenter);
+    QCOMPARE(leading->geometry(), QRect(start, QSize(30, 20)));
+
+    QWidget *trailing = new QWidget(window);
+
+    base = AnchorsBase::createAnchorBase(trailing);
+    trailing->resize(30, 20);
+    base->setAnchor(Qt::AnchorRight, positive, Qt::AnchorHorizontalCenter);
+    base->setAnchor(Qt::AnchorBottom, positive, Qt::AnchorVerticalCenter);
+    QCOMPARE(trailing->geometry().bottomRight(), end);
+    QCOMPARE(trailing->size(), QSize(30, 20));
+
+    // the rounded end point sizes the widget
+    QWidget *between = new QWidget(window);
+
+    base = AnchorsBase::createAnchorBase(between);
+    between->resize(30, 20);
+    base->setAnchor(Qt::AnchorLeft, negative, Qt::AnchorLeft);
+    base->setAnchor(Qt::AnchorRight, positive, Qt::AnchorHorizontalCenter);
+    QCOMPARE(between->x(), -11);
+    QCOMPARE(between->width(), stretched);
+}
+
+void TestRounding::cleanup()
+{
+    AnchorsBase::setCenterRounding(AnchorsBase::RoundDown);
+    delete window;
+    window = NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestRounding test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_rounding.moc"
@@ -0,0 +1,13 @@
+QT       += core gui widgets testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_scheduler
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_scheduler.cpp \
+    ../../anchors.cpp
+
+HEADERS  += ../../anchors.h
@@ -0,0 +1,170 @@
+#include <QApplication>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+
+class TestScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void disabled();
+    void parkedWhileHidden();
+    void flushedExplicitly();
+    void flushedWhenDisabled();
+    void idleWindow();
+    void cleanup();
+
+private:
+    QWidget *createWindow(QWidget **item);
+
+    QList<QWidget *> windows;
+};
+
+// a window with an item pinned to its right edge at x 380
+QWidget *TestScheduler::createWindow(QWidget **item)
+{
+    QWidget *window = new QWidget;
+
+    window->resize(400, 300);
+    *item = new QWidget(window);
+    (*item)->resize(20, 20);
+    AnchorsBase::createAnchorBase(*item)->setAnchor(Qt::AnchorRight, window, Qt::AnchorRight);
+    windows << window;
+
+    return window;
+}
+
+void TestScheduler::init()
+{
+    QVERIFY(!AnchorsScheduler::isEnabled());
+}
+
+void TestScheduler::disabled()
+{
+    QWidget *item = NULL;
+    QWidget *window = createWindow(&item);
+
+    QCOMPARE(AnchorsScheduler::priority(window), AnchorsScheduler::Immediate);
+
+    AnchorsBase::getAnchorBaseByWidget(item)->setMargins(10);
+    QCOMPARE(item->x(), 370);
+    QCOMPARE(AnchorsScheduler::pendingCount(), 0);
+}
+
+void TestScheduler::parkedWhileHidden()
+{
+    QWidget *item = NULL;
+    QWidget *other = NULL;
+    QWidget *window = createWindow(&item);
+
+    other = new QWidget(window);
+    other->resize(20, 20);
+    AnchorsBase::createAnchorBase(other)->setAnchor(Qt::AnchorRight, window, Qt::AnchorRight);
+
+    AnchorsScheduler::setEnabled(true);
+    QCOMPARE(AnchorsScheduler::priority(window), AnchorsScheduler::Suspended);
+
+    // a widget is queued once however often it changes
+    AnchorsBase::getAnchorBaseByWidget(item)->setMargins(10);
+    AnchorsBase::getAnchorBaseByWidget(item)->setRightMargin(15);
+    QCOMPARE(AnchorsScheduler::pendingCount(window), 1);
+    AnchorsBase::getAnchorBaseByWidget(other)->setMargins(5);
+    QCOMPARE(AnchorsScheduler::pendingCount(window), 2);
+    QCOMPARE(item->x(), 380);
+    QCOMPARE(other->x(), 380);
+
+    // the backlog is laid out before the window is first painted
+    window->show();
+    QCOMPARE(AnchorsScheduler::pendingCount(window), 0);
+    QCOMPARE(item->x(), 365);
+    QCOMPARE(other->x(), 375);
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+    QVERIFY(AnchorsScheduler::priority(window) != AnchorsScheduler::Suspended);
+}
+
+void TestScheduler::flushedExplicitly()
+{
+    QWidget *item = NULL;
+    QWidget *window = createWindow(&item);
+
+    AnchorsScheduler::setEnabled(true);
+    AnchorsBase::getAnchorBaseByWidget(item)->setMargins(10);
+    QCOMPARE(AnchorsScheduler::pendingCount(window), 1);
+    QCOMPARE(item->x(), 380);
+
+    AnchorsScheduler::flush(window);
+    QCOMPARE(AnchorsScheduler::pendingCount(window), 0);
+    QCOMPARE(item->x(), 370);
+    QCOMPARE(AnchorsScheduler::priority(window), AnchorsScheduler::Suspended);
+}
+
+void TestScheduler::flushedWhenDisabled()
+{
+    QWidget *item = NULL;
+
+    createWindow(&item);
+
+    AnchorsScheduler::setEnabled(true);
+    AnchorsBase::getAnchorBaseByWidget(item)->setMargins(10);
+    QCOMPARE(AnchorsScheduler::pendingCount(), 1);
+
+    // nothing stays parked once updates are synchronous again
+    AnchorsScheduler::setEnabled(false);
+    QCOMPARE(item->x(), 370);
+}
+
+void TestScheduler::idleWindow()
+{
+    QWidget *activeItem = NULL;
+    QWidget *idleItem = NULL;
+    QWidget *active = createWindow(&activeItem);
+    QWidget *idle = createWindow(&idleItem);
+
+    AnchorsScheduler::setEnabled(true);
+    idle->show();
+    active->show();
+    QVERIFY(QTest::qWaitForWindowExposed(idle));
+    QVERIFY(QTest::qWaitForWindowExposed(active));
+    active->activateWindow();
+    if (!QTest::qWaitForWindowActive(active)
+            || AnchorsScheduler::priority(idle) != AnchorsScheduler::Idle) {
+        QSKIP("the platform does not report inactive windows");
+    }
+
+    QCOMPARE(AnchorsScheduler::priority(active), AnchorsScheduler::Immediate);
+
+    // the active window is laid out at once, the other one in an idle slice
+    AnchorsBase::getAnchorBaseByWidget(activeItem)->setMargins(10);
+    AnchorsBase::getAnchorBaseByWidget(idleItem)->setMargins(10);
+    QCOMPARE(activeItem->x(), 370);
+    QCOMPARE(idleItem->x(), 380);
+    QCOMPARE(AnchorsScheduler::pendingCount(idle), 1);
+    QCOMPARE(AnchorsScheduler::pendingCount(active), 0);
+
+    QTRY_COMPARE(idleItem->x(), 370);
+    QCOMPARE(AnchorsScheduler::pendingCount(), 0);
+}
+
+void TestScheduler::cleanup()
+{
+    AnchorsScheduler::setEnabled(false);
+    qDeleteAll(windows);
+    windows.clear();
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestScheduler test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_scheduler.moc"
@@ -0,0 +1,15 @@
+QT       += core gui widgets testlib
+
+CONFIG += c++11 testcase
+
+TARGET = tst_screen
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += tst_screen.cpp \
+    ../../anchors.cpp \
+    ../../anchorsscreen.cpp
+
+HEADERS  += ../../anchors.h \
+    ../../anchorsscreen.h
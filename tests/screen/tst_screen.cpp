@@ -0,0 +1,196 @@
+#include <QApplication>
+#include <QScreen>
+#include <QSignalSpy>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+#include "anchorsscreen.h"
+
+class TestScreen : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void corner();
+    void coalesced();
+    void area();
+    void stretched();
+    void centered();
+    void sizeLimits();
+    void screenChanged();
+    void windowResized();
+    void cleared();
+    void refused();
+    void realScreen();
+    void cleanup();
+
+private:
+    QWidget *window = NULL;
+    AnchorsScreen *screen = NULL;
+};
+
+void TestScreen::init()
+{
+    window = new QWidget;
+    window->setGeometry(100, 100, 300, 200);
+    screen = new AnchorsScreen(window);
+
+    // a full HD screen with a 30 pixel panel at the top
+    screen->setSimulatedScreen(QRect(0, 0, 1920, 1080), QRect(0, 30, 1920, 1050));
+    QCOMPARE(screen->screenRect(), QRect(0, 30, 1920, 1050));
+}
+
+void TestScreen::corner()
+{
+    QSignalSpy committed(screen, &AnchorsScreen::committed);
+
+    QVERIFY(screen->setAnchor(Qt::AnchorRight, Qt::AnchorRight, 10));
+    QVERIFY(screen->setAnchor(Qt::AnchorBottom, Qt::AnchorBottom, 10));
+    QVERIFY(screen->isAnchored(Qt::AnchorRight));
+    QVERIFY(!screen->isAnchored(Qt::AnchorLeft));
+
+    QTRY_COMPARE(window->geometry(), QRect(1610, 870, 300, 200));
+    QCOMPARE(committed.count(), 1);
+    QCOMPARE(committed.first().at(0).toRect(), QRect(1610, 870, 300, 200));
+}
+
+void TestScreen::coalesced()
+{
+    // any number of changes before the event loop runs share one commit
+    screen->setAnchor(Qt::AnchorLeft, Qt::AnchorLeft, 5);
+    screen->setAnchor(Qt::AnchorTop, Qt::AnchorTop, 5);
+    screen->setSimulatedScreen(QRect(0, 0, 1280, 720), QRect(0, 0, 1280, 720));
+    screen->setArea(AnchorsScreen::Geometry);
+    QCOMPARE(screen->commitCount(), 0);
+
+    QTRY_COMPARE(window->geometry(), QRect(5, 5, 300, 200));
+    QCoreApplication::processEvents();
+    QCOMPARE(screen->commitCount(), 1);
+}
+
+void TestScreen::area()
+{
+    screen->setAnchor(Qt::AnchorTop, Qt::AnchorTop);
+    screen->forceUpdate();
+    QCOMPARE(window->y(), 30);
+
+    screen->setArea(AnchorsScreen::Geometry);
+    screen->forceUpdate();
+    QCOMPARE(window->y(), 0);
+    QCOMPARE(screen->screenRect(), QRect(0, 0, 1920, 1080));
+}
+
+void TestScreen::stretched()
+{
+    screen->setAnchor(Qt::AnchorLeft, Qt::AnchorLeft);
+    screen->setAnchor(Qt::AnchorRight, Qt::AnchorRight);
+    screen->setAnchor(Qt::AnchorTop, Qt::AnchorTop);
+    screen->setAnchor(Qt::AnchorBottom, Qt::AnchorBottom);
+    screen->forceUpdate();
+
+    QCOMPARE(window->geometry(), QRect(0, 30, 1920, 1050));
+}
+
+void TestScreen::centered()
+{
+    screen->setAnchor(Qt::AnchorHorizontalCenter, Qt::AnchorHorizontalCenter);
+    screen->setAnchor(Qt::AnchorVerticalCenter, Qt::AnchorVerticalCenter, 20);
+    screen->forceUpdate();
+
+    QCOMPARE(window->geometry(), QRect(810, 475, 300, 200));
+}
+
+void TestScreen::sizeLimits()
+{
+    window->setMaximumWidth(1000);
+    window->setMinimumHeight(300);
+    screen->setAnchor(Qt::AnchorLeft, Qt::AnchorLeft);
+    screen->setAnchor(Qt::AnchorRight, Qt::AnchorRight);
+    screen->setAnchor(Qt::AnchorBottom, Qt::AnchorBottom);
+    screen->forceUpdate();
+
+    // the window's limits win, its anchored point stays put
+    QCOMPARE(window->geometry(), QRect(0, 780, 1000, 300));
+}
+
+void TestScreen::screenChanged()
+{
+    screen->setAnchor(Qt::AnchorRight, Qt::AnchorRight, 10);
+    screen->setAnchor(Qt::AnchorBottom, Qt::AnchorBottom, 10);
+    screen->forceUpdate();
+    QCOMPARE(window->geometry(), QRect(1610, 870, 300, 200));
+
+    screen->setSimulatedScreen(QRect(0, 0, 1280, 720), QRect(0, 0, 1280, 690));
+    QTRY_COMPARE(window->geometry(), QRect(970, 480, 300, 200));
+}
+
+void TestScreen::windowResized()
+{
+    screen->setAnchor(Qt::AnchorRight, Qt::AnchorRight, 10);
+    screen->setAnchor(Qt::AnchorTop, Qt::AnchorTop);
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+    QTRY_COMPARE(window->geometry(), QRect(1610, 30, 300, 200));
+
+    // a window anchored by its right edge grows to the left
+    window->resize(400, 250);
+    QTRY_COMPARE(window->geometry(), QRect(1510, 30, 400, 250));
+}
+
+void TestScreen::cleared()
+{
+    screen->setAnchor(Qt::AnchorLeft, Qt::AnchorLeft, 10);
+    screen->forceUpdate();
+    QCOMPARE(window->x(), 10);
+
+    // the window keeps its place, like a widget whose anchor is removed
+    screen->clearAnchor(Qt::AnchorLeft);
+    screen->setSimulatedScreen(QRect(100, 0, 1920, 1080), QRect(100, 0, 1920, 1080));
+    screen->forceUpdate();
+    QCOMPARE(window->x(), 10);
+}
+
+void TestScreen::refused()
+{
+    QVERIFY(!screen->setAnchor(Qt::AnchorLeft, Qt::AnchorTop));
+    QVERIFY(!screen->isAnchored(Qt::AnchorLeft));
+
+    QWidget *child = new QWidget(window);
+    AnchorsScreen *childScreen = new AnchorsScreen(child);
+
+    QTest::ignoreMessage(QtWarningMsg, "AnchorsScreen: only top-level widgets can anchor to a screen");
+    QVERIFY(!childScreen->setAnchor(Qt::AnchorLeft, Qt::AnchorLeft));
+}
+
+void TestScreen::realScreen()
+{
+    screen->clearSimulatedScreen();
+    QVERIFY(screen->screen());
+    QCOMPARE(screen->screenRect(), screen->screen()->availableGeometry());
+
+    screen->setArea(AnchorsScreen::Geometry);
+    QCOMPARE(screen->screenRect(), screen->screen()->geometry());
+}
+
+void TestScreen::cleanup()
+{
+    delete window;
+    window = NULL;
+    screen = NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestScreen test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_screen.moc"
@@ -0,0 +1,302 @@
+#include <QApplication>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+
+class CommitScope : public AnchorsObserver
+{
+public:
+    explicit CommitScope(const QWidget *w) : widget(w) {}
+
+    void geometryCommitted(const QWidget *w, const QRect &geometry) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(geometry)
+
+        if (w == widget) {
+            ++commits;
+        }
+    }
+
+    int commits = 0;
+
+private:
+    const QWidget *widget;
+};
+
+class TestSizes : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void sizeNextToAnchor();
+    void aspectStretched();
+    void aspectHorizontal();
+    void aspectKeepsAnchoredEdge();
+    void aspectCentered();
+    void aspectFree();
+    void proportional();
+    void aspectWithFill();
+    void refused();
+    void disabled();
+    void cleanup();
+
+private:
+    QWidget *createWidget(int width, int height);
+
+    QWidget *window = NULL;
+    QWidget *area = NULL;
+    QWidget *source = NULL;
+};
+
+QWidget *TestSizes::createWidget(int width, int height)
+{
+    QWidget *w = new QWidget(window);
+
+    w->resize(width, height);
+    w->show();
+
+    return w;
+}
+
+void TestSizes::init()
+{
+    window = new QWidget;
+    window->resize(600, 400);
+    area = new QWidget(window);
+    area->setGeometry(0, 0, 400, 300);
+    source = new QWidget(window);
+    source->setGeometry(500, 10, 50, 20);
+
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+}
+
+void TestSizes::sizeNextToAnchor()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    // the anchored right edge stays, the bound width moves the left one
+    QVERIFY(base->setAnchor(Qt::AnchorRight, area, Qt::AnchorRight));
+    QCOMPARE(w->geometry(), QRect(370, 0, 30, 10));
+
+    QVERIFY(base->setSizeBinding(AnchorsBase::WidthProperty, source, AnchorsBase::WidthProperty, 0.5, 4));
+    QCOMPARE(w->geometry(), QRect(371, 0, 29, 10));
+
+    source->resize(100, 20);
+    QCOMPARE(w->geometry(), QRect(346, 0, 54, 10));
+    QVERIFY(AnchorsBase::isSizeAnchored(w, Qt::Horizontal));
+    QVERIFY(!AnchorsBase::isSizeAnchored(w, Qt::Vertical));
+}
+
+void TestSizes::aspectStretched()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    QVERIFY(base->setAnchor(Qt::AnchorLeft, area, Qt::AnchorLeft));
+    QVERIFY(base->setAnchor(Qt::AnchorRight, area, Qt::AnchorRight));
+    base->setMargins(10);
+    base->setAspectRatio(2);
+
+    QCOMPARE(w->geometry(), QRect(10, 0, 380, 190));
+    QVERIFY(AnchorsBase::isSizeAnchored(w, Qt::Horizontal));
+    QVERIFY(AnchorsBase::isSizeAnchored(w, Qt::Vertical));
+
+    // the height follows the width in the same commit, not in a second
+    // pass started by the resize
+    CommitScope scope(w);
+
+    area->resize(500, 300);
+    QCOMPARE(w->geometry(), QRect(10, 0, 480, 240));
+    QCOMPARE(scope.commits, 1);
+}
+
+void TestSizes::aspectHorizontal()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    // the vertical size is determined, so the ratio gives the width
+    QVERIFY(base->setAnchor(Qt::AnchorTop, area, Qt::AnchorTop));
+    QVERIFY(base->setAnchor(Qt::AnchorBottom, area, Qt::AnchorBottom));
+    base->setMargins(10);
+    base->setAspectRatio(0.5);
+
+    QCOMPARE(w->geometry(), QRect(0, 10, 140, 280));
+    QVERIFY(AnchorsBase::isSizeAnchored(w, Qt::Horizontal));
+
+    area->resize(400, 200);
+    QCOMPARE(w->geometry(), QRect(0, 10, 90, 180));
+}
+
+void TestSizes::aspectKeepsAnchoredEdge()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    QVERIFY(base->setAnchor(Qt::AnchorTop, area, Qt::AnchorTop));
+    QVERIFY(base->setAnchor(Qt::AnchorBottom, area, Qt::AnchorBottom));
+    QVERIFY(base->setAnchor(Qt::AnchorRight, area, Qt::AnchorRight));
+    base->setTopMargin(10);
+    base->setBottomMargin(10);
+    base->setAspectRatio(0.5);
+
+    QCOMPARE(w->geometry(), QRect(260, 10, 140, 280));
+
+    area->resize(400, 200);
+    QCOMPARE(w->geometry(), QRect(310, 10, 90, 180));
+}
+
+void TestSizes::aspectCentered()
+{
+    QWidget *w = createWidget(100, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    // a centered widget keeps its width, the ratio gives the height
+    QVERIFY(base->setCenterIn(area));
+    QCOMPARE(w->geometry(), QRect(150, 145, 100, 10));
+
+    base->setAspectRatio(4);
+    QCOMPARE(w->geometry(), QRect(150, 137, 100, 25));
+
+    area->resize(300, 300);
+    QCOMPARE(w->geometry(), QRect(100, 137, 100, 25));
+}
+
+void TestSizes::aspectFree()
+{
+    QWidget *w = createWidget(120, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    base->setAspectRatio(3);
+    QCOMPARE(w->geometry(), QRect(0, 0, 120, 40));
+    QVERIFY(AnchorsBase::isSizeAnchored(w, Qt::Vertical));
+    QVERIFY(!AnchorsBase::isSizeAnchored(w, Qt::Horizontal));
+
+    // a free width sized by hand is followed by the height
+    w->resize(90, 40);
+    QCOMPARE(w->size(), QSize(90, 30));
+
+    base->setAspectRatio(1.5);
+    QCOMPARE(w->size(), QSize(90, 60));
+
+    // without a ratio the widget keeps the size it was given
+    base->setAspectRatio(0);
+    QCOMPARE(base->aspectRatio(), qreal(0));
+    QCOMPARE(w->size(), QSize(90, 60));
+    QVERIFY(!AnchorsBase::isSizeAnchored(w, Qt::Vertical));
+
+    w->resize(50, 60);
+    QCOMPARE(w->size(), QSize(50, 60));
+
+    base->setAspectRatio(-2);
+    QCOMPARE(base->aspectRatio(), qreal(0));
+    QCOMPARE(w->size(), QSize(50, 60));
+}
+
+void TestSizes::proportional()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    QVERIFY(base->setSizeBinding(AnchorsBase::WidthProperty, source, AnchorsBase::WidthProperty, 2));
+    base->setAspectRatio(2);
+    QCOMPARE(w->size(), QSize(100, 50));
+
+    CommitScope scope(w);
+
+    source->resize(30, 20);
+    QCOMPARE(w->size(), QSize(60, 30));
+    QCOMPARE(scope.commits, 1);
+
+    // a height tied to the width of another widget, with an offset
+    QWidget *other = createWidget(30, 10);
+    AnchorsBase *otherBase = AnchorsBase::createAnchorBase(other);
+
+    QVERIFY(otherBase->setSizeBinding(AnchorsBase::HeightProperty, source, AnchorsBase::WidthProperty, 0.5, 5));
+    QCOMPARE(other->size(), QSize(30, 20));
+
+    source->resize(61, 20);
+    QCOMPARE(other->size(), QSize(30, 35));
+    QCOMPARE(w->size(), QSize(122, 61));
+}
+
+void TestSizes::aspectWithFill()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    // a filled widget takes the target's size whatever its ratio
+    QVERIFY(base->setFill(area));
+    base->setAspectRatio(2);
+
+    QCOMPARE(w->geometry(), QRect(0, 0, 400, 300));
+    QVERIFY(AnchorsBase::isSizeAnchored(w, Qt::Vertical));
+
+    QVERIFY(!base->setSizeBinding(AnchorsBase::WidthProperty, source, AnchorsBase::WidthProperty));
+    QCOMPARE(base->errorCode(), AnchorsBase::Conflict);
+    QCOMPARE(w->geometry(), QRect(0, 0, 400, 300));
+}
+
+void TestSizes::refused()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    QVERIFY(!base->setSizeBinding(AnchorsBase::TopProperty, source, AnchorsBase::WidthProperty));
+    QCOMPARE(base->errorCode(), AnchorsBase::PointInvalid);
+    QVERIFY(!base->setSizeBinding(AnchorsBase::WidthProperty, source, AnchorsBase::LeftProperty));
+    QCOMPARE(base->errorCode(), AnchorsBase::PointInvalid);
+    QVERIFY(!base->setSizeBinding(AnchorsBase::WidthProperty, NULL, AnchorsBase::WidthProperty));
+    QCOMPARE(base->errorCode(), AnchorsBase::TargetInvalid);
+    QVERIFY(!base->setSizeBinding(AnchorsBase::WidthProperty, w, AnchorsBase::HeightProperty));
+    QCOMPARE(base->errorCode(), AnchorsBase::LoopBind);
+
+    // two anchors already determine the width
+    QVERIFY(base->setAnchor(Qt::AnchorLeft, area, Qt::AnchorLeft));
+    QVERIFY(base->setAnchor(Qt::AnchorRight, area, Qt::AnchorRight));
+    QVERIFY(!base->setSizeBinding(AnchorsBase::WidthProperty, source, AnchorsBase::WidthProperty));
+    QCOMPARE(base->errorCode(), AnchorsBase::Conflict);
+
+    QVERIFY(!base->hasBinding(AnchorsBase::WidthProperty));
+    QCOMPARE(w->geometry(), QRect(0, 0, 400, 10));
+}
+
+void TestSizes::disabled()
+{
+    QWidget *w = createWidget(30, 10);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(w);
+
+    QVERIFY(base->setSizeBinding(AnchorsBase::HeightProperty, source, AnchorsBase::HeightProperty));
+    base->setAspectRatio(1);
+    QCOMPARE(w->size(), QSize(20, 20));
+    QVERIFY(AnchorsBase::isSizeAnchored(w, Qt::Horizontal));
+    QVERIFY(AnchorsBase::isSizeAnchored(w, Qt::Vertical));
+
+    base->setEnabled(false);
+    QVERIFY(!AnchorsBase::isSizeAnchored(w, Qt::Horizontal));
+    QVERIFY(!AnchorsBase::isSizeAnchored(w, Qt::Vertical));
+}
+
+void TestSizes::cleanup()
+{
+    delete window;
+    window = NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestSizes test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_sizes.moc"
@@ -0,0 +1,255 @@
+#include <QApplication>
+#include <QtTest>
+#include <QWidget>
+
+#include <cstdlib>
+#include <new>
+
+#include "anchors.h"
+
+static thread_local bool counting = false;
+static int allocations = 0;
+
+void *operator new(std::size_t size)
+{
+    if (counting) {
+        ++allocations;
+    }
+
+    void *ptr = std::malloc(size ? size : 1);
+
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+// counts what a template costs, the commits are Qt's own
+class AllocationScope : public AnchorsObserver
+{
+public:
+    void geometryAboutToBeCommitted(const QWidget *w, const QRect &geometry) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(w)
+        Q_UNUSED(geometry)
+
+        saved = counting;
+        counting = false;
+    }
+
+    void geometryCommitted(const QWidget *w, const QRect &geometry) Q_DECL_OVERRIDE
+    {
+        Q_UNUSED(w)
+        Q_UNUSED(geometry)
+
+        counting = saved;
+    }
+
+    int apply(const AnchorsTemplate &t, const QList<QWidget *> &items)
+    {
+        allocations = 0;
+        counting = true;
+        t.apply(items);
+        counting = false;
+
+        return allocations;
+    }
+
+private:
+    bool saved = false;
+};
+
+class TestTemplates : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void shared();
+    void parentResized();
+    void overridden();
+    void itemRemoved();
+    void cleared();
+    void allocationCount();
+    void cleanupTestCase();
+
+private:
+    static AnchorsTemplate column();
+    static QList<QWidget *> createItems(QWidget *parent, int count);
+    static int baseCount(const QList<QWidget *> &items);
+
+    QWidget *window = NULL;
+    QWidget *parent = NULL;
+    QList<QWidget *> items;
+};
+
+// a column of full width rows, each below the previous one
+AnchorsTemplate TestTemplates::column()
+{
+    AnchorsTemplate t;
+
+    t.setAnchor(Qt::AnchorTop, AnchorsTemplate::PreviousTarget, Qt::AnchorBottom)
+     .setAnchor(Qt::AnchorLeft, AnchorsTemplate::ParentTarget, Qt::AnchorLeft)
+     .setAnchor(Qt::AnchorRight, AnchorsTemplate::ParentTarget, Qt::AnchorRight)
+     .setMargin(AnchorsBase::MarginsProperty, 2);
+
+    return t;
+}
+
+QList<QWidget *> TestTemplates::createItems(QWidget *parent, int count)
+{
+    QList<QWidget *> list;
+
+    for (int i = 0; i < count; ++i) {
+        QWidget *w = new QWidget(parent);
+
+        w->resize(10, 20);
+        list << w;
+    }
+
+    return list;
+}
+
+int TestTemplates::baseCount(const QList<QWidget *> &items)
+{
+    int count = 0;
+
+    foreach (QWidget *w, items) {
+        count += AnchorsBase::getAnchorBaseByWidget(w) != NULL;
+    }
+
+    return count;
+}
+
+void TestTemplates::initTestCase()
+{
+    window = new QWidget;
+    window->resize(400, 1300);
+    parent = new QWidget(window);
+    parent->setGeometry(0, 0, 300, 1200);
+    items = createItems(parent, 50);
+
+    window->show();
+    QVERIFY(QTest::qWaitForWindowExposed(window));
+
+    QVERIFY(column().apply(items));
+}
+
+void TestTemplates::shared()
+{
+    QCOMPARE(baseCount(items), 0);
+    for (int i = 0; i < items.size(); ++i) {
+        QCOMPARE(items.at(i)->geometry(), QRect(2, 2 + 22 * i, 296, 20));
+    }
+    QVERIFY(AnchorsBase::isSizeAnchored(items.first(), Qt::Horizontal));
+    QVERIFY(!AnchorsBase::isSizeAnchored(items.first(), Qt::Vertical));
+}
+
+void TestTemplates::parentResized()
+{
+    parent->resize(400, 1200);
+
+    QCOMPARE(baseCount(items), 0);
+    for (int i = 0; i < items.size(); ++i) {
+        QCOMPARE(items.at(i)->geometry(), QRect(2, 2 + 22 * i, 396, 20));
+    }
+}
+
+void TestTemplates::overridden()
+{
+    AnchorsBase::createAnchorBase(items.at(3))->setLeftMargin(20);
+
+    QCOMPARE(items.at(3)->geometry(), QRect(20, 68, 378, 20));
+
+    // the overridden item and the neighbour it follows are the only ones
+    // with anchors objects of their own
+    for (int i = 0; i < items.size(); ++i) {
+        if (i != 2 && i != 3) {
+            QVERIFY(!AnchorsBase::getAnchorBaseByWidget(items.at(i)));
+        }
+    }
+    QVERIFY(baseCount(items) <= 2);
+
+    parent->resize(300, 1200);
+
+    QCOMPARE(items.at(3)->geometry(), QRect(20, 68, 278, 20));
+    QCOMPARE(items.at(4)->geometry(), QRect(2, 90, 296, 20));
+    QCOMPARE(items.last()->geometry(), QRect(2, 2 + 22 * 49, 296, 20));
+}
+
+void TestTemplates::itemRemoved()
+{
+    delete items.takeAt(10);
+
+    for (int i = 10; i < items.size(); ++i) {
+        QCOMPARE(items.at(i)->geometry(), QRect(2, 2 + 22 * i, 296, 20));
+    }
+}
+
+void TestTemplates::cleared()
+{
+    QWidget *w = items.last();
+
+    AnchorsBase::clearAnchors(w);
+    parent->resize(350, 1200);
+
+    QCOMPARE(w->geometry(), QRect(2, 2 + 22 * 48, 296, 20));
+    QCOMPARE(items.first()->geometry(), QRect(2, 2, 346, 20));
+}
+
+void TestTemplates::allocationCount()
+{
+    QWidget *sharedParent = new QWidget(window);
+    QWidget *ownParent = new QWidget(window);
+    QList<QWidget *> sharedItems = createItems(sharedParent, 200);
+    QList<QWidget *> ownItems = createItems(ownParent, 200);
+    AllocationScope scope;
+
+    // an aspect ratio keeps the template on anchors of every item
+    AnchorsTemplate own = column();
+
+    own.setAspectRatio(2);
+
+    int shared = scope.apply(column(), sharedItems);
+    int perItem = scope.apply(own, ownItems);
+
+    QCOMPARE(baseCount(sharedItems), 0);
+    QCOMPARE(baseCount(ownItems), ownItems.size());
+    QVERIFY2(shared * 4 < perItem, qPrintable(QString("%1 vs %2").arg(shared).arg(perItem)));
+    QVERIFY2(shared <= 4 * sharedItems.size(), qPrintable(QString::number(shared)));
+}
+
+void TestTemplates::cleanupTestCase()
+{
+    delete window;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestTemplates test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_templates.moc"
@@ -0,0 +1,18 @@
+TEMPLATE = subdirs
+
+SUBDIRS += allocations \
+    bindings \
+    cache \
+    culling \
+    engines \
+    incremental \
+    positioners \
+    reclaim \
+    repaints \
+    rounding \
+    scheduler \
+    screen \
+    sizes \
+    templates \
+    transactions \
+    variables
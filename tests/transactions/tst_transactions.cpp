@@ -0,0 +1,168 @@
+#include <QApplication>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+
+class TestTransactions : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void rollbackAnchors();
+    void commitLoop();
+    void rollbackBindings();
+    void rollbackVariables();
+    void nestedRollback();
+    void cleanup();
+
+private:
+    QWidget *window = NULL;
+    QWidget *a = NULL;
+    QWidget *b = NULL;
+};
+
+void TestTransactions::init()
+{
+    window = new QWidget;
+    window->resize(400, 300);
+    b = new QWidget(window);
+    b->setGeometry(50, 60, 40, 30);
+    AnchorsBase::createAnchorBase(b);
+    a = new QWidget(window);
+    a->resize(40, 30);
+
+    AnchorsBase *base = AnchorsBase::createAnchorBase(a);
+
+    base->setAnchor(Qt::AnchorLeft, b, Qt::AnchorRight);
+    base->setAnchor(Qt::AnchorTop, b, Qt::AnchorTop);
+    QCOMPARE(a->geometry(), QRect(90, 60, 40, 30));
+}
+
+void TestTransactions::rollbackAnchors()
+{
+    AnchorsBase *base = AnchorsBase::getAnchorBaseByWidget(a);
+
+    {
+        AnchorsTransaction transaction;
+
+        QVERIFY(base->setAnchor(Qt::AnchorLeft, window, Qt::AnchorLeft));
+        base->setLeftMargin(5);
+        transaction.rollback();
+        QVERIFY(!transaction.isActive());
+    }
+
+    QCOMPARE(base->left()->targetInfo->base->target(), b);
+    QCOMPARE(base->leftMargin(), 0);
+    QCOMPARE(a->geometry(), QRect(90, 60, 40, 30));
+}
+
+void TestTransactions::commitLoop()
+{
+    AnchorsBase *base = AnchorsBase::getAnchorBaseByWidget(b);
+    AnchorsTransaction transaction;
+
+    // the loop is only found when the transaction is validated
+    QVERIFY(base->setAnchor(Qt::AnchorLeft, a, Qt::AnchorRight));
+    QVERIFY(!transaction.commit());
+    QCOMPARE(transaction.errorCode(), AnchorsBase::LoopBind);
+
+    QVERIFY(!base->left()->targetInfo);
+    QCOMPARE(b->geometry(), QRect(50, 60, 40, 30));
+    QCOMPARE(a->geometry(), QRect(90, 60, 40, 30));
+}
+
+void TestTransactions::rollbackBindings()
+{
+    QWidget *c = new QWidget(window);
+    AnchorsBase *base = AnchorsBase::createAnchorBase(c);
+    QWidget *source = b;
+
+    c->setGeometry(0, 0, 20, 20);
+    QVERIFY(base->setBinding(AnchorsBase::LeftProperty, [source]() { return AnchorsBase::widthOf(source) - 10; }));
+    QCOMPARE(c->x(), 30);
+
+    {
+        AnchorsTransaction transaction;
+
+        base->clearBinding(AnchorsBase::LeftProperty);
+        QVERIFY(base->setAnchor(Qt::AnchorLeft, b, Qt::AnchorLeft));
+        QVERIFY(base->setBinding(AnchorsBase::TopProperty, []() { return 70; }));
+        transaction.rollback();
+    }
+
+    QVERIFY(base->hasBinding(AnchorsBase::LeftProperty));
+    QVERIFY(!base->hasBinding(AnchorsBase::TopProperty));
+    QVERIFY(!base->left()->targetInfo);
+    QCOMPARE(c->x(), 30);
+
+    // the restored binding still tracks what its expression reads
+    b->resize(55, 30);
+    QCOMPARE(c->x(), 45);
+}
+
+void TestTransactions::rollbackVariables()
+{
+    AnchorsBase *base = AnchorsBase::getAnchorBaseByWidget(a);
+
+    AnchorsVariables::setValue("gap", 6);
+    QVERIFY(base->setMarginVariable(AnchorsBase::LeftMarginProperty, "gap"));
+    QCOMPARE(a->x(), 96);
+
+    {
+        AnchorsTransaction transaction;
+
+        base->setLeftMargin(2);
+        QVERIFY(base->marginVariable(AnchorsBase::LeftMarginProperty).isEmpty());
+        transaction.rollback();
+    }
+
+    QCOMPARE(base->marginVariable(AnchorsBase::LeftMarginProperty), QString("gap"));
+    QCOMPARE(AnchorsVariables::dependentCount("gap"), 1);
+    QCOMPARE(a->x(), 96);
+
+    AnchorsVariables::setValue("gap", 10);
+    QCOMPARE(a->x(), 100);
+    AnchorsVariables::remove("gap");
+}
+
+void TestTransactions::nestedRollback()
+{
+    AnchorsBase *base = AnchorsBase::getAnchorBaseByWidget(a);
+    AnchorsTransaction outer;
+
+    base->setTopMargin(12);
+    {
+        AnchorsTransaction inner;
+
+        base->setLeftMargin(7);
+        inner.rollback();
+    }
+
+    // the inner rollback aborts the outermost transaction
+    QVERIFY(!outer.commit());
+    QCOMPARE(base->topMargin(), 0);
+    QCOMPARE(base->leftMargin(), 0);
+    QCOMPARE(a->geometry(), QRect(90, 60, 40, 30));
+}
+
+void TestTransactions::cleanup()
+{
+    delete window;
+    window = NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestTransactions test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_transactions.moc"
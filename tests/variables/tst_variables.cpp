@@ -0,0 +1,139 @@
+#include <QApplication>
+#include <QtTest>
+#include <QWidget>
+
+#include "anchors.h"
+
+class TestVariables : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void follow();
+    void oneValueManyWidgets();
+    void directSetterUnlinks();
+    void directSetterKeepsOtherLinks();
+    void remove();
+    void cleanup();
+
+private:
+    QWidget *window = NULL;
+    QWidget *first = NULL;
+    QWidget *second = NULL;
+};
+
+void TestVariables::init()
+{
+    AnchorsVariables::setValue("spacing", 8);
+
+    window = new QWidget;
+    window->resize(400, 300);
+    first = new QWidget(window);
+    AnchorsBase::createAnchorBase(first)->setFill(window);
+    second = new QWidget(window);
+    second->resize(40, 30);
+    AnchorsBase::createAnchorBase(second)->setAnchor(Qt::AnchorLeft, first, Qt::AnchorLeft);
+    QCOMPARE(first->geometry(), QRect(0, 0, 400, 300));
+}
+
+void TestVariables::follow()
+{
+    AnchorsBase *base = AnchorsBase::getAnchorBaseByWidget(first);
+
+    QVERIFY(!base->setMarginVariable(AnchorsBase::MarginsProperty, "unknown"));
+    QVERIFY(base->setMarginVariable(AnchorsBase::MarginsProperty, "spacing"));
+    QCOMPARE(base->marginVariable(AnchorsBase::MarginsProperty), QString("spacing"));
+    QCOMPARE(first->geometry(), QRect(8, 8, 384, 284));
+
+    AnchorsVariables::setValue("spacing", 12);
+    QCOMPARE(base->margins(), 12);
+    QCOMPARE(first->geometry(), QRect(12, 12, 376, 276));
+    QCOMPARE(second->x(), 12);
+}
+
+void TestVariables::oneValueManyWidgets()
+{
+    AnchorsBase *firstBase = AnchorsBase::getAnchorBaseByWidget(first);
+    AnchorsBase *secondBase = AnchorsBase::getAnchorBaseByWidget(second);
+
+    firstBase->setMarginVariable(AnchorsBase::MarginsProperty, "spacing");
+    secondBase->setMarginVariable(AnchorsBase::LeftMarginProperty, "spacing");
+    QCOMPARE(AnchorsVariables::dependentCount("spacing"), 2);
+    QCOMPARE(second->x(), 16);
+
+    AnchorsVariables::setValue("spacing", 4);
+    QCOMPARE(first->geometry(), QRect(4, 4, 392, 292));
+    QCOMPARE(second->x(), 8);
+}
+
+void TestVariables::directSetterUnlinks()
+{
+    AnchorsBase *base = AnchorsBase::getAnchorBaseByWidget(first);
+
+    base->setMarginVariable(AnchorsBase::MarginsProperty, "spacing");
+    base->setMargins(4);
+
+    QVERIFY(base->marginVariable(AnchorsBase::MarginsProperty).isEmpty());
+    QCOMPARE(AnchorsVariables::dependentCount("spacing"), 0);
+
+    AnchorsVariables::setValue("spacing", 20);
+    QCOMPARE(base->margins(), 4);
+    QCOMPARE(first->geometry(), QRect(4, 4, 392, 292));
+
+    // setting the value the variable already has unlinks it just the same
+    base->setMarginVariable(AnchorsBase::MarginsProperty, "spacing");
+    base->setMargins(20);
+    QVERIFY(base->marginVariable(AnchorsBase::MarginsProperty).isEmpty());
+}
+
+void TestVariables::directSetterKeepsOtherLinks()
+{
+    AnchorsBase *base = AnchorsBase::getAnchorBaseByWidget(first);
+
+    base->setMarginVariable(AnchorsBase::MarginsProperty, "spacing");
+    base->setMarginVariable(AnchorsBase::TopMarginProperty, "spacing");
+    base->setTopMargin(3);
+
+    QVERIFY(base->marginVariable(AnchorsBase::TopMarginProperty).isEmpty());
+    QCOMPARE(base->marginVariable(AnchorsBase::MarginsProperty), QString("spacing"));
+    QCOMPARE(AnchorsVariables::dependentCount("spacing"), 1);
+
+    AnchorsVariables::setValue("spacing", 16);
+    QCOMPARE(base->margins(), 16);
+    QCOMPARE(base->topMargin(), 3);
+    QCOMPARE(first->geometry(), QRect(16, 3, 368, 281));
+}
+
+void TestVariables::remove()
+{
+    AnchorsBase *base = AnchorsBase::getAnchorBaseByWidget(first);
+
+    base->setMarginVariable(AnchorsBase::MarginsProperty, "spacing");
+    AnchorsVariables::remove("spacing");
+
+    QVERIFY(!AnchorsVariables::contains("spacing"));
+    QVERIFY(base->marginVariable(AnchorsBase::MarginsProperty).isEmpty());
+    QCOMPARE(first->geometry(), QRect(8, 8, 384, 284));
+}
+
+void TestVariables::cleanup()
+{
+    delete window;
+    window = NULL;
+    AnchorsVariables::remove("spacing");
+}
+
+int main(int argc, char *argv[])
+{
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty()) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    TestVariables test;
+
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_variables.moc"